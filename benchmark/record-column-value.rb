@@ -0,0 +1,60 @@
+#!/usr/bin/env ruby
+#
+# Measures Groonga::Record#[] and the number of Ruby objects
+# allocated for each call. Options parsing in the extension
+# shouldn't allocate any object. So the number of allocated
+# objects for an Int32 column should be 0. The column name is
+# created only once so that a String literal isn't allocated for
+# each call. Table#column_value allocates an options Hash for each
+# call in Ruby.
+#
+# % ruby benchmark/record-column-value.rb
+
+require "benchmark"
+require "fileutils"
+
+base_dir = File.expand_path(File.join(File.dirname(__FILE__), ".."))
+$LOAD_PATH.unshift(File.join(base_dir, "ext", "groonga"))
+$LOAD_PATH.unshift(File.join(base_dir, "lib"))
+
+require "groonga"
+
+n = 1_000_000
+
+def n_allocated_objects
+  stat = GC.stat
+  stat[:total_allocated_objects] || stat[:total_allocated_object]
+end
+
+tmp_dir = "/tmp/groonga"
+FileUtils.rm_rf(tmp_dir)
+FileUtils.mkdir_p(tmp_dir)
+Groonga::Database.create(:path => "#{tmp_dir}/db")
+
+Groonga::Schema.create_table("Entries", :type => :hash) do |table|
+  table.int32("n_likes")
+end
+entries = Groonga["Entries"]
+record = entries.add("groonga", :n_likes => 100)
+column_name = "n_likes"
+
+items = [
+  ["Record#[]",
+   lambda {record[column_name]}],
+  ["Table#column_value",
+   lambda {entries.column_value(record.id, column_name, :id => true)}],
+]
+
+Benchmark.bm(20) do |benchmark|
+  items.each do |label, item|
+    item.call
+    before = n_allocated_objects
+    benchmark.report(label) do
+      n.times {item.call}
+    end
+    after = n_allocated_objects
+    if before
+      puts("%20s %.2f objects/call" % ["", (after - before) / n.to_f])
+    end
+  end
+end
@@ -0,0 +1,145 @@
+#!/usr/bin/env ruby
+#
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+# Runs the benchmark suite against a generated corpus.
+#
+# Usage:
+#   % ruby benchmark/run-suite.rb --n-records=100000 \
+#       --format=json --output=before.json
+#   (change rroonga)
+#   % ruby benchmark/run-suite.rb --n-records=100000 \
+#       --format=json --output=after.json --compare=before.json
+
+require "optparse"
+require "time"
+require "tmpdir"
+
+base_dir = File.expand_path(File.join(File.dirname(__FILE__), ".."))
+$LOAD_PATH.unshift(File.join(base_dir, "ext", "groonga"))
+$LOAD_PATH.unshift(File.join(base_dir, "lib"))
+$LOAD_PATH.unshift(File.join(base_dir, "benchmark"))
+
+require "groonga"
+
+require "suite/dataset"
+require "suite/measurement"
+require "suite/cases"
+require "suite/report"
+
+options = {
+  :n_records => 10000,
+  :seed => 29,
+  :n_warmups => 2,
+  :n_iterations => 10,
+  :format => :text,
+  :output => nil,
+  :compare => nil,
+  :filter => nil,
+  :database_dir => File.join(Dir.tmpdir, "rroonga-benchmark"),
+}
+
+parser = OptionParser.new
+parser.banner += " [OPTIONS]"
+parser.on("--n-records=N", Integer,
+          "The number of generated records",
+          "(#{options[:n_records]})") do |n|
+  options[:n_records] = n
+end
+parser.on("--seed=SEED", Integer,
+          "The seed of generated records",
+          "(#{options[:seed]})") do |seed|
+  options[:seed] = seed
+end
+parser.on("--warmups=N", Integer,
+          "The number of warmup runs per benchmark",
+          "(#{options[:n_warmups]})") do |n|
+  options[:n_warmups] = n
+end
+parser.on("--iterations=N", Integer,
+          "The number of measured runs per benchmark",
+          "(#{options[:n_iterations]})") do |n|
+  options[:n_iterations] = n
+end
+parser.on("--format=FORMAT", [:text, :json, :csv],
+          "Output format [text, json, csv]",
+          "(#{options[:format]})") do |format|
+  options[:format] = format
+end
+parser.on("--output=PATH",
+          "Output to PATH instead of the standard output") do |path|
+  options[:output] = path
+end
+parser.on("--compare=PATH",
+          "Compare with a JSON result at PATH") do |path|
+  options[:compare] = path
+end
+parser.on("--filter=PATTERN",
+          "Run only benchmarks whose name matches PATTERN") do |pattern|
+  options[:filter] = Regexp.new(pattern)
+end
+parser.on("--database-dir=DIR",
+          "Create the database in DIR",
+          "(#{options[:database_dir]})") do |dir|
+  options[:database_dir] = dir
+end
+parser.parse!(ARGV)
+
+dataset = RroongaBenchmark::Dataset.new(options[:n_records], options[:seed])
+context = Groonga::Context.new
+database_path = File.join(options[:database_dir], "db")
+$stderr.puts("creating database: #{options[:n_records]} records...")
+dataset.create_database(context, database_path)
+
+measurements = []
+cases = RroongaBenchmark::Cases.new(context, dataset)
+cases.each do |benchmark_case|
+  next if options[:filter] and options[:filter] !~ benchmark_case.name
+  $stderr.puts("running: #{benchmark_case.name}")
+  measurement = RroongaBenchmark::Measurement.new(benchmark_case.name)
+  measurement.run(options[:n_warmups],
+                  options[:n_iterations],
+                  benchmark_case.setup,
+                  &benchmark_case.body)
+  measurements << measurement
+end
+cases.close
+
+metadata = {
+  "ruby" => RUBY_DESCRIPTION,
+  "groonga" => Groonga.version,
+  "rroonga" => Groonga.bindings_version,
+  "n_records" => options[:n_records],
+  "seed" => options[:seed],
+  "n_warmups" => options[:n_warmups],
+  "n_iterations" => options[:n_iterations],
+  "time" => Time.now.utc.iso8601,
+}
+report = RroongaBenchmark::Report.new(metadata, measurements)
+formatted_report = report.format(options[:format])
+if options[:output]
+  File.open(options[:output], "w") do |output|
+    output.write(formatted_report)
+  end
+else
+  print(formatted_report)
+end
+
+if options[:compare]
+  print(report.compare(File.read(options[:compare])))
+end
+
+context.close
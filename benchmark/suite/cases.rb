@@ -0,0 +1,179 @@
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+module RroongaBenchmark
+  # Benchmark cases. Each case is a name, an optional setup block
+  # that isn't measured and a measured block that receives the
+  # value returned by the setup block.
+  class Cases
+    Case = Struct.new(:name, :setup, :body)
+
+    def initialize(context, dataset)
+      @context = context
+      @dataset = dataset
+      @cases = []
+      define_cases
+    end
+
+    def each(&block)
+      @cases.each(&block)
+    end
+
+    # Closes resources used by cases.
+    def close
+      @null_output.close unless @null_output.closed?
+    end
+
+    private
+    def add(name, setup=nil, &body)
+      @cases << Case.new(name, setup, body)
+    end
+
+    def documents
+      @context["Documents"]
+    end
+
+    def define_cases
+      define_load_cases
+      define_select_cases
+      define_sort_cases
+      define_group_cases
+      define_scan_cases
+      define_snippet_cases
+      define_dump_cases
+    end
+
+    def define_load_cases
+      n_records = [@dataset.n_records, 1000].min
+      keys, *values = @dataset.columns
+      value_names = @dataset.column_names[1..-1]
+      create_load_table = lambda do
+        table = @context["LoadTarget"]
+        table.remove if table
+        Groonga::Schema.define(:context => @context) do |schema|
+          schema.create_table("LoadTarget",
+                              :type => :hash,
+                              :key_type => "ShortText") do |table|
+            table.short_text("title")
+            table.text("content")
+            table.reference("tag", "Tags")
+            table.uint32("n_likes")
+            table.time("created_at")
+          end
+        end
+        @context["LoadTarget"]
+      end
+
+      add("load: add", create_load_table) do |table|
+        n_records.times do |i|
+          attributes = {}
+          value_names.each_with_index do |name, j|
+            attributes[name] = values[j][i]
+          end
+          table.add(keys[i], attributes)
+        end
+      end
+
+      add("load: load_columns", create_load_table) do |table|
+        columns = @dataset.columns.collect {|column| column[0, n_records]}
+        table.load_columns(@dataset.column_names, columns)
+      end
+    end
+
+    def define_select_cases
+      query = "content:@#{@dataset.frequent_word}"
+      add("select: query") do
+        documents.select(query)
+      end
+
+      add("select: block") do
+        documents.select do |record|
+          record.n_likes > 5000
+        end
+      end
+    end
+
+    def define_sort_cases
+      add("sort: n_likes limit 10") do
+        documents.sort([["n_likes", :descending]], :limit => 10)
+      end
+
+      add("sort: created_at all") do
+        documents.sort([["created_at", :ascending]])
+      end
+    end
+
+    def define_group_cases
+      add("group: tag") do
+        documents.group("tag")
+      end
+    end
+
+    def define_scan_cases
+      add("scan: each") do
+        documents.each do |record|
+          record.id
+        end
+      end
+
+      add("scan: each reuse_record") do
+        documents.each(:reuse_record => true) do |record|
+          record.id
+        end
+      end
+
+      add("scan: each_id_slice") do
+        documents.each_id_slice(1000) do |ids|
+          ids.bytesize
+        end
+      end
+
+      add("scan: fetch_columns") do
+        documents.fetch_columns(["n_likes", "created_at"])
+      end
+    end
+
+    def define_snippet_cases
+      keyword = @dataset.frequent_word
+      contents = nil
+      setup = lambda do
+        contents ||= documents.select("content:@#{keyword}").collect do |record|
+          record.content
+        end.first(100)
+      end
+      add("snippet: execute", setup) do |target_contents|
+        snippet = Groonga::Snippet.new(:context => @context,
+                                       :normalize => true,
+                                       :width => 100,
+                                       :max_results => 3)
+        snippet.add_keyword(keyword, :open_tag => "<b>", :close_tag => "</b>")
+        target_contents.each do |content|
+          snippet.execute(content)
+        end
+      end
+    end
+
+    def define_dump_cases
+      @null_output = File.open(File::NULL, "w")
+      add("dump: database") do
+        Groonga::DatabaseDumper.dump(:context => @context,
+                                     :output => @null_output,
+                                     :tables => ["Documents"],
+                                     :dump_schema => false,
+                                     :dump_indexes => false)
+      end
+    end
+  end
+end
@@ -0,0 +1,128 @@
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+require "fileutils"
+
+module RroongaBenchmark
+  # Generates a synthetic corpus. The same seed and the same number
+  # of records generate the same corpus.
+  class Dataset
+    N_WORDS = 2000
+    N_TAGS = 50
+    N_WORDS_PER_CONTENT = 20..120
+
+    attr_reader :n_records, :seed, :words, :tags
+
+    def initialize(n_records, seed)
+      @n_records = n_records
+      @seed = seed
+      random = Random.new(@seed)
+      @words = N_WORDS.times.collect do |i|
+        length = random.rand(3..10)
+        word = length.times.collect {("a".ord + random.rand(26)).chr}.join
+        "#{word}#{i}"
+      end
+      @tags = N_TAGS.times.collect {|i| "tag#{i}"}
+    end
+
+    # @return [Array<Array>] Column-major values for
+    #   +_key+, +title+, +content+, +tag+, +n_likes+ and +created_at+.
+    def columns
+      @columns ||= generate_columns
+    end
+
+    def column_names
+      ["_key", "title", "content", "tag", "n_likes", "created_at"]
+    end
+
+    # @return [String] The most frequent word in contents. It is
+    #   used as the search keyword.
+    def frequent_word
+      @words.first
+    end
+
+    def define_schema(context)
+      Groonga::Schema.define(:context => context) do |schema|
+        schema.create_table("Tags",
+                            :type => :hash,
+                            :key_type => "ShortText") do |table|
+        end
+
+        schema.create_table("Documents",
+                            :type => :hash,
+                            :key_type => "ShortText") do |table|
+          table.short_text("title")
+          table.text("content")
+          table.reference("tag", "Tags")
+          table.uint32("n_likes")
+          table.time("created_at")
+        end
+
+        schema.create_table("Terms",
+                            :type => :patricia_trie,
+                            :key_type => "ShortText",
+                            :default_tokenizer => "TokenBigram",
+                            :normalizer => "NormalizerAuto") do |table|
+          table.index("Documents.content")
+        end
+      end
+    end
+
+    def load(context)
+      documents = context["Documents"]
+      documents.load_columns(column_names, columns)
+    end
+
+    # Creates a database at _path_ and loads the corpus into it.
+    def create_database(context, path)
+      FileUtils.rm_rf(File.dirname(path))
+      FileUtils.mkdir_p(File.dirname(path))
+      context.create_database(path)
+      define_schema(context)
+      load(context)
+    end
+
+    private
+    def generate_columns
+      random = Random.new(@seed)
+      base_time = Time.at(1388534400) # 2014-01-01T00:00:00Z
+      keys = []
+      titles = []
+      contents = []
+      tags = []
+      n_likes = []
+      created_ats = []
+      @n_records.times do |i|
+        keys << "document#{i}"
+        titles << pick_words(random, 3).join(" ")
+        n_content_words = random.rand(N_WORDS_PER_CONTENT)
+        contents << pick_words(random, n_content_words).join(" ")
+        tags << @tags[random.rand(@tags.size)]
+        n_likes << random.rand(10000)
+        created_ats << base_time + random.rand(365 * 24 * 60 * 60)
+      end
+      [keys, titles, contents, tags, n_likes, created_ats]
+    end
+
+    # Picks words by Zipf like distribution to make realistic
+    # posting lists.
+    def pick_words(random, n)
+      n.times.collect do
+        index = (N_WORDS * (random.rand ** 3)).to_i
+        @words[index]
+      end
+    end
+  end
+end
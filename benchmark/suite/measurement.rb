@@ -0,0 +1,153 @@
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+module RroongaBenchmark
+  # Runs a benchmark block with warmup and repeated iterations and
+  # collects times, allocations and RSS delta.
+  class Measurement
+    attr_reader :name, :times, :n_allocated_objects, :rss_delta
+
+    def initialize(name)
+      @name = name
+      @times = []
+      @n_allocated_objects = nil
+      @rss_delta = nil
+    end
+
+    def run(n_warmups, n_iterations, setup=nil, &block)
+      n_warmups.times do
+        argument = setup ? setup.call : nil
+        block.call(argument)
+      end
+
+      GC.start
+      before_rss = Measurement.rss
+      total_n_allocated_objects = 0
+      n_iterations.times do
+        argument = setup ? setup.call : nil
+        # Objects allocated by setup aren't counted.
+        before_n_allocated_objects = Measurement.n_allocated_objects
+        start = Measurement.now
+        block.call(argument)
+        @times << Measurement.now - start
+        after_n_allocated_objects = Measurement.n_allocated_objects
+        if total_n_allocated_objects and
+            before_n_allocated_objects and after_n_allocated_objects
+          total_n_allocated_objects +=
+            after_n_allocated_objects - before_n_allocated_objects
+        else
+          total_n_allocated_objects = nil
+        end
+      end
+      after_rss = Measurement.rss
+
+      if total_n_allocated_objects and n_iterations > 0
+        @n_allocated_objects = total_n_allocated_objects / n_iterations
+      end
+      if before_rss and after_rss
+        @rss_delta = after_rss - before_rss
+      end
+      @sorted_times = nil
+      self
+    end
+
+    def min
+      sorted_times.first
+    end
+
+    def max
+      sorted_times.last
+    end
+
+    def mean
+      @times.inject(0.0) {|sum, time| sum + time} / @times.size
+    end
+
+    def standard_deviation
+      average = mean
+      variance = @times.inject(0.0) do |sum, time|
+        sum + (time - average) ** 2
+      end / @times.size
+      Math.sqrt(variance)
+    end
+
+    # @param [Numeric] percent 0..100
+    def percentile(percent)
+      sorted = sorted_times
+      return nil if sorted.empty?
+      index = (percent / 100.0) * (sorted.size - 1)
+      lower = sorted[index.floor]
+      upper = sorted[index.ceil]
+      lower + (upper - lower) * (index - index.floor)
+    end
+
+    def median
+      percentile(50)
+    end
+
+    def to_h
+      {
+        "name" => @name,
+        "n_iterations" => @times.size,
+        "min" => min,
+        "max" => max,
+        "mean" => mean,
+        "standard_deviation" => standard_deviation,
+        "p50" => percentile(50),
+        "p90" => percentile(90),
+        "p99" => percentile(99),
+        "n_allocated_objects" => @n_allocated_objects,
+        "rss_delta" => @rss_delta,
+      }
+    end
+
+    class << self
+      if defined?(Process::CLOCK_MONOTONIC)
+        def now
+          Process.clock_gettime(Process::CLOCK_MONOTONIC)
+        end
+      else
+        def now
+          Time.now.to_f
+        end
+      end
+
+      # @return [Integer, nil] The number of allocated objects
+      #   since the process is started.
+      def n_allocated_objects
+        stat = GC.stat
+        stat[:total_allocated_objects] || stat[:total_allocated_object]
+      end
+
+      # @return [Integer, nil] The resident set size in bytes.
+      def rss
+        status_path = "/proc/#{Process.pid}/status"
+        return nil unless File.readable?(status_path)
+        File.foreach(status_path) do |line|
+          case line
+          when /\AVmRSS:\s*(\d+)\s*kB/
+            return Integer($1) * 1024
+          end
+        end
+        nil
+      end
+    end
+
+    private
+    def sorted_times
+      @sorted_times ||= @times.sort
+    end
+  end
+end
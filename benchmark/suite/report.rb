@@ -0,0 +1,137 @@
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+require "csv"
+require "json"
+
+module RroongaBenchmark
+  # Formats measurements as text, JSON or CSV and compares them
+  # with a previous JSON result.
+  class Report
+    COLUMNS = [
+      "name",
+      "n_iterations",
+      "min",
+      "max",
+      "mean",
+      "standard_deviation",
+      "p50",
+      "p90",
+      "p99",
+      "n_allocated_objects",
+      "rss_delta",
+    ]
+
+    def initialize(metadata, measurements)
+      @metadata = metadata
+      @results = measurements.collect(&:to_h)
+    end
+
+    def format(type)
+      case type
+      when :json
+        JSON.pretty_generate("metadata" => @metadata,
+                             "results" => @results) + "\n"
+      when :csv
+        CSV.generate do |csv|
+          csv << COLUMNS
+          @results.each do |result|
+            csv << COLUMNS.collect {|column| result[column]}
+          end
+        end
+      else
+        format_text
+      end
+    end
+
+    # @param [String] previous_json The JSON formatted result of a
+    #   previous run.
+    def compare(previous_json)
+      previous = JSON.parse(previous_json)
+      previous_results = {}
+      previous["results"].each do |result|
+        previous_results[result["name"]] = result
+      end
+
+      width = name_width
+      lines = []
+      lines << [
+        "name".ljust(width),
+        "p50(before)".rjust(12),
+        "p50(after)".rjust(12),
+        "ratio".rjust(8),
+        "alloc(before)".rjust(14),
+        "alloc(after)".rjust(14),
+      ].join(" ")
+      @results.each do |result|
+        previous_result = previous_results[result["name"]]
+        next if previous_result.nil?
+        before = previous_result["p50"]
+        after = result["p50"]
+        ratio = (before and before > 0) ? after / before : nil
+        lines << [
+          result["name"].ljust(width),
+          format_seconds(before).rjust(12),
+          format_seconds(after).rjust(12),
+          (ratio ? "%.3f" % ratio : "-").rjust(8),
+          previous_result["n_allocated_objects"].to_s.rjust(14),
+          result["n_allocated_objects"].to_s.rjust(14),
+        ].join(" ")
+      end
+      lines.join("\n") + "\n"
+    end
+
+    private
+    def name_width
+      (@results.collect {|result| result["name"].size} + [4]).max
+    end
+
+    def format_text
+      width = name_width
+      lines = []
+      lines << [
+        "name".ljust(width),
+        "p50".rjust(10),
+        "p90".rjust(10),
+        "p99".rjust(10),
+        "stddev".rjust(10),
+        "alloc/iter".rjust(12),
+        "rss delta".rjust(12),
+      ].join(" ")
+      @results.each do |result|
+        lines << [
+          result["name"].ljust(width),
+          format_seconds(result["p50"]).rjust(10),
+          format_seconds(result["p90"]).rjust(10),
+          format_seconds(result["p99"]).rjust(10),
+          format_seconds(result["standard_deviation"]).rjust(10),
+          result["n_allocated_objects"].to_s.rjust(12),
+          format_bytes(result["rss_delta"]).rjust(12),
+        ].join(" ")
+      end
+      lines.join("\n") + "\n"
+    end
+
+    def format_seconds(seconds)
+      return "-" if seconds.nil?
+      "%.3fms" % (seconds * 1000)
+    end
+
+    def format_bytes(bytes)
+      return "-" if bytes.nil?
+      "%.3fMB" % (bytes / 1024.0 / 1024.0)
+    end
+  end
+end
@@ -270,7 +270,15 @@ have_header("ruby/st.h") unless have_macro("HAVE_RUBY_ST_H", "ruby.h")
 have_func("rb_errinfo", "ruby.h")
 have_func("rb_sym2str", "ruby.h")
 have_func("rb_to_symbol", "ruby.h")
+have_func("rb_hash_lookup2", "ruby.h")
+if have_header("ruby/thread.h")
+  have_func("rb_thread_call_without_gvl", "ruby/thread.h")
+  have_func("rb_thread_call_without_gvl2", "ruby/thread.h")
+  have_func("rb_thread_call_with_gvl", "ruby/thread.h")
+end
 have_type("enum ruby_value_type", "ruby.h")
+have_func("grn_db_get_last_modified", "groonga.h")
+have_func("grn_obj_touch", "groonga.h")
 
 checking_for(checking_message("--enable-debug-log option")) do
   enable_debug_log = enable_config("debug-log", false)
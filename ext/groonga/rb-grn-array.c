@@ -18,10 +18,22 @@
 
 #include "rb-grn.h"
 
+#include <time.h>
+
 #define SELF(object, context) (RVAL2GRNTABLE(object, context))
 
+#define PULL_POLL_INTERVAL_MSEC 10
+
 VALUE rb_cGrnArray;
 
+/*
+ * The number of {Groonga::Array#unblock} calls for each array in
+ * this process. A pull operation polls it without the GVL to be
+ * unblocked. Counters aren't freed because a pull operation may
+ * refer them without the GVL.
+ */
+static st_table *rb_grn_array_unblock_counts = NULL;
+
 /*
  * Document-class: Groonga::Array < Groonga::Table
  *
@@ -325,6 +337,148 @@ rb_grn_array_push (VALUE self)
     return data.record;
 }
 
+static volatile unsigned int *
+rb_grn_array_get_unblock_count (grn_obj *array)
+{
+    st_data_t count;
+
+    if (!rb_grn_array_unblock_counts)
+        rb_grn_array_unblock_counts = st_init_numtable();
+    if (!st_lookup(rb_grn_array_unblock_counts, (st_data_t)array, &count)) {
+        unsigned int *new_count;
+
+        new_count = ALLOC(unsigned int);
+        *new_count = 0;
+        count = (st_data_t)new_count;
+        st_insert(rb_grn_array_unblock_counts, (st_data_t)array, count);
+    }
+
+    return (volatile unsigned int *)count;
+}
+
+typedef struct _PullData
+{
+    grn_ctx *context;
+    grn_array *array;
+    grn_bool block_p;
+    grn_bool have_timeout;
+    double timeout;
+    grn_id *ids;
+    long max_n_ids;
+    long n_ids;
+    volatile unsigned int *unblock_count;
+    unsigned int n_unblocks;
+    volatile grn_bool interrupted;
+} PullData;
+
+static void
+pull_sleep (void)
+{
+#ifdef WIN32
+    Sleep(PULL_POLL_INTERVAL_MSEC);
+#else
+    struct timespec interval;
+
+    interval.tv_sec = 0;
+    interval.tv_nsec = PULL_POLL_INTERVAL_MSEC * 1000 * 1000;
+    nanosleep(&interval, NULL);
+#endif
+}
+
+/*
+ * Pulls IDs without blocking in groonga. A blocking
+ * grn_array_pull() can't be woken reliably by an interrupt because
+ * it clears an unblock request when it starts waiting. So the
+ * array is polled every PULL_POLL_INTERVAL_MSEC and an interrupt
+ * and Groonga::Array#unblock are checked after each
+ * grn_array_pull() returns.
+ */
+static void *
+pull_ids (void *user_data)
+{
+    PullData *data = user_data;
+    double waited_time = 0.0;
+
+    while (data->n_ids < data->max_n_ids && !data->interrupted) {
+        grn_id id;
+
+        id = grn_array_pull(data->context, data->array, GRN_FALSE, NULL, NULL);
+        if (id != GRN_ID_NIL) {
+            data->ids[data->n_ids++] = id;
+            continue;
+        }
+
+        /* Only the first record is waited. Other records are
+           pulled only when they are already pushed. */
+        if (data->n_ids > 0 || !data->block_p)
+            break;
+        if (*(data->unblock_count) != data->n_unblocks)
+            break;
+        if (data->have_timeout && waited_time >= data->timeout)
+            break;
+        pull_sleep();
+        waited_time += PULL_POLL_INTERVAL_MSEC / 1000.0;
+    }
+
+    return NULL;
+}
+
+static void
+pull_interrupt (void *user_data)
+{
+    PullData *data = user_data;
+
+    /* pull_ids() checks it at most PULL_POLL_INTERVAL_MSEC
+       later. */
+    data->interrupted = GRN_TRUE;
+}
+
+static VALUE
+pull_records (VALUE self, grn_ctx *context, grn_obj *table,
+              long max_n_records, VALUE rb_block_p, VALUE rb_timeout)
+{
+    PullData data;
+    VALUE rb_ids, rb_records;
+    long i;
+
+    data.context = context;
+    data.array = (grn_array *)table;
+    data.block_p = NIL_P(rb_block_p) ? GRN_TRUE : RVAL2CBOOL(rb_block_p);
+    data.have_timeout = !NIL_P(rb_timeout);
+    data.timeout = data.have_timeout ? NUM2DBL(rb_timeout) : 0.0;
+    data.max_n_ids = max_n_records;
+    data.n_ids = 0;
+    data.unblock_count = rb_grn_array_get_unblock_count(table);
+    data.n_unblocks = *(data.unblock_count);
+    data.interrupted = GRN_FALSE;
+    rb_ids = rb_str_buf_new(sizeof(grn_id) * max_n_records);
+    data.ids = (grn_id *)RSTRING_PTR(rb_ids);
+
+    if (data.block_p) {
+        rb_grn_context_call_without_gvl_defer_interrupts(context,
+                                                         pull_ids, &data,
+                                                         pull_interrupt,
+                                                         &data);
+    } else {
+        pull_ids(&data);
+    }
+
+    rb_records = rb_ary_new2(data.n_ids);
+    for (i = 0; i < data.n_ids; i++) {
+        rb_ary_push(rb_records, rb_grn_record_new(self, data.ids[i], Qnil));
+    }
+    RB_GC_GUARD(rb_ids);
+
+    /* Pulled records are removed from the array. They are returned
+       even when an interrupt is pending. The pending interrupt is
+       processed at the next check point. */
+    if (data.n_ids == 0)
+        rb_thread_check_ints();
+    rb_grn_context_check(context, self);
+
+    return rb_records;
+}
+
 /*
  * Pulls a record from the array. The required values should be
  * retrieved in the given block.
@@ -353,28 +507,58 @@ rb_grn_array_push (VALUE self)
  *     p pulled_record.nil? # => true
  *   end
  *
- * Note that your signal handlers can't be ran while a pull
- * operation. You need to use {Groonga::Array#unblock} from
- * another process to unblock the pull operation. If you call
- * {Groonga::Array#unblock}, signal handler can be ran.
+ * If you passes @:timeout => seconds@ option, the pull operation
+ * blocks at most _seconds_. The given block isn't called and
+ * returns nil when no record is pushed in _seconds_.
+ *
+ * @example A program that pulls with timeout
+ *   queue = Groonga::Array.open(:name => "CrawlURLQueue")
+ *   loop do
+ *     pulled_record = queue.pull(:timeout => 5) do |record|
+ *       # Crawl URL
+ *       record.delete
+ *     end
+ *     next if pulled_record.nil? # No job in 5 seconds
+ *   end
+ *
+ * The GVL is released while the pull operation blocks. So other
+ * threads can run while a thread is waiting for a pushed
+ * record. The blocked pull operation polls the array every 10
+ * milliseconds. It is interrupted by signals, Thread#raise,
+ * Thread#kill and so on. The interrupted pull operation returns
+ * nil without calling the given block.
  *
- * @example Signal handler isn't called
+ * The given block is called after the pulled record is removed
+ * from the array. It isn't called while the array is locked for
+ * the pull operation. So other pull operations can pull the next
+ * record while the block is running. It is available since 4.0.5.
+ * The block was called while the array is locked before 4.0.5.
+ *
+ * @example Signal handler is called
  *   queue = Groonga::Array.open(:name => "CrawlURLQueue")
  *   trap(:INT) do
- *     p :not_called!
+ *     p :called!
  *   end
  *   queue.pull do |record|
  *     # Send SIGINT while blocking the pull operation.
- *     # The signal handler isn't called.
+ *     # The signal handler is called and the pull operation
+ *     # returns nil.
  *   end
  *
  * @see Groonga::Array#push Examples exist in the push documentation.
+ * @see Groonga::Array#pull_batch
  *
  * @overload pull(options={})
  *   @param [::Hash] options The option parameters.
  *   @option options [Boolean] :block? (true)
  *     Whether the pull operation is blocked or not when no record exist
  *     in the array.
+ *   @option options [Numeric] :timeout (nil)
+ *     The max seconds to block the pull operation. If it is +nil+,
+ *     the pull operation blocks until a record is pushed. It is
+ *     ignored when +:block?+ is +false+.
+ *
+ *     It is available since 4.0.5.
  *   @yield [record] Gets required values for a pull record in the given block.
  *   @yieldparam record [Groonga::Record or nil]
  *     A pulled record. It is nil when no records exist in the array
@@ -388,13 +572,14 @@ rb_grn_array_pull (int argc, VALUE *argv, VALUE self)
     grn_ctx *context = NULL;
     grn_obj *table;
     VALUE options;
-    VALUE rb_block_p;
-    YieldRecordCallbackData data;
+    VALUE rb_block_p, rb_timeout;
+    VALUE rb_records, rb_record;
 
     rb_scan_args(argc, argv, "01", &options);
 
     rb_grn_scan_options(options,
                         "block?", &rb_block_p,
+                        "timeout", &rb_timeout,
                         NULL);
 
     if (!rb_block_given_p()) {
@@ -404,26 +589,108 @@ rb_grn_array_pull (int argc, VALUE *argv, VALUE self)
 
     table = SELF(self, &context);
 
-    if (NIL_P(rb_block_p)) {
-        rb_block_p = Qtrue;
+    rb_records = pull_records(self, context, table, 1, rb_block_p, rb_timeout);
+    if (RARRAY_LEN(rb_records) == 0) {
+        return Qnil;
     }
 
-    data.self = self;
-    data.record = Qnil;
-    data.status = 0;
-    grn_array_pull(context, (grn_array *)table, RVAL2CBOOL(rb_block_p),
-                   yield_record_callback, &data);
-    if (data.status != 0) {
-        rb_jump_tag(data.status);
+    rb_record = RARRAY_PTR(rb_records)[0];
+    rb_yield(rb_record);
+
+    return rb_record;
+}
+
+/*
+ * Pulls at most _n_ records from the array in one call. It is
+ * useful to reduce per record overhead when many records are
+ * pushed.
+ *
+ * Only the first record is waited like {Groonga::Array#pull}.
+ * Other records are pulled only when they are already pushed. So
+ * the number of pulled records may be less than _n_.
+ *
+ * The given block is called for each record after all records
+ * are pulled. The array isn't locked while the block is
+ * running. It is different from the block of
+ * {Groonga::Array#pull} before 4.0.5 that is called while the
+ * array is locked. Pulled records are already removed from the
+ * array. So they are lost if the block raises an exception.
+ *
+ * @example A program that pulls jobs in a batch
+ *   queue = Groonga::Array.open(:name => "CrawlURLQueue")
+ *   loop do
+ *     urls = []
+ *     queue.pull_batch(100, :timeout => 5) do |record|
+ *       urls << record.url
+ *       record.delete
+ *     end
+ *     # Crawl URLs
+ *   end
+ *
+ * @overload pull_batch(n, options={})
+ *   @param n [Integer] The max number of pulled records.
+ *   @param [::Hash] options The option parameters.
+ *   @option options [Boolean] :block? (true)
+ *     The same as {Groonga::Array#pull}.
+ *   @option options [Numeric] :timeout (nil)
+ *     The same as {Groonga::Array#pull}.
+ *   @yield [record] Gets required values for each pulled record
+ *     in the given block. It is optional.
+ *   @yieldparam record [Groonga::Record] A pulled record.
+ *   @return [::Array<Groonga::Record>] Pulled records. It is an
+ *     empty Array when no record is pulled.
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_array_pull_batch (int argc, VALUE *argv, VALUE self)
+{
+    grn_ctx *context = NULL;
+    grn_obj *table;
+    VALUE rb_n, options;
+    VALUE rb_block_p, rb_timeout;
+    VALUE rb_records;
+    long n;
+
+    rb_scan_args(argc, argv, "11", &rb_n, &options);
+
+    rb_grn_scan_options(options,
+                        "block?", &rb_block_p,
+                        "timeout", &rb_timeout,
+                        NULL);
+
+    n = NUM2LONG(rb_n);
+    if (n <= 0) {
+        rb_raise(rb_eArgError,
+                 "the number of pulled records should be positive: "
+                 "<%ld>: <%s>",
+                 n, rb_grn_inspect(self));
     }
-    rb_grn_context_check(context, self);
 
-    return data.record;
+    table = SELF(self, &context);
+
+    rb_records = pull_records(self, context, table, n, rb_block_p, rb_timeout);
+    if (rb_block_given_p()) {
+        long i;
+
+        for (i = 0; i < RARRAY_LEN(rb_records); i++) {
+            rb_yield(RARRAY_PTR(rb_records)[i]);
+        }
+    }
+
+    return rb_records;
 }
 
 /*
  * Unblocks all {Groonga::Array#pull} operations for the array.
  *
+ * Pull operations in this process return nil at most 10
+ * milliseconds later. Pull operations in other processes by
+ * rroonga 4.0.5 or later aren't unblocked because they poll the
+ * array instead of waiting in groonga. Send a signal to them
+ * instead. Pull operations that wait in groonga such as pull
+ * operations by rroonga before 4.0.5 are unblocked.
+ *
  * @example Pull, unblock and signal
  *   # pull.rb
  *   queue = Groonga::Array.open(:name => "CrawlURLQueue")
@@ -455,6 +722,7 @@ rb_grn_array_unblock (VALUE self)
 
     table = SELF(self, &context);
 
+    (*(rb_grn_array_get_unblock_count(table)))++;
     grn_array_unblock(context, (grn_array *)table);
 
     return Qnil;
@@ -471,5 +739,6 @@ rb_grn_init_array (VALUE mGrn)
     rb_define_method(rb_cGrnArray, "add", rb_grn_array_add, -1);
     rb_define_method(rb_cGrnArray, "push", rb_grn_array_push, 0);
     rb_define_method(rb_cGrnArray, "pull", rb_grn_array_pull, -1);
+    rb_define_method(rb_cGrnArray, "pull_batch", rb_grn_array_pull_batch, -1);
     rb_define_method(rb_cGrnArray, "unblock", rb_grn_array_unblock, 0);
 }
@@ -782,6 +782,7 @@ rb_grn_column_rename (VALUE self, VALUE rb_name)
     rc = grn_column_rename(context, column, name, name_size);
     rb_grn_context_check(context, self);
     rb_grn_rc_check(rc, self);
+    rb_grn_table_expire_column_caches(context, column);
 
     return self;
 }
@@ -20,6 +20,12 @@
 
 #define SELF(object) (RVAL2GRNCONTEXT(object))
 
+#if defined(_MSC_VER)
+#  define THREAD_LOCAL __declspec(thread)
+#else
+#  define THREAD_LOCAL __thread
+#endif
+
 static VALUE cGrnContext;
 
 /*
@@ -219,6 +225,8 @@ rb_grn_context_finalizer (grn_ctx *context, int n_args, grn_obj **grn_objects,
     rb_grn_context = user_data->ptr;
 
     rb_grn_context_close_floating_objects(rb_grn_context);
+    rb_grn_select_cache_free(context, rb_grn_context->select_cache);
+    rb_grn_context->select_cache = NULL;
     if (!(context->flags & GRN_CTX_PER_DB)) {
         rb_grn_context_unlink_database(context);
     }
@@ -350,6 +358,254 @@ rb_grn_context_text_set (grn_ctx *context, grn_obj *bulk, VALUE rb_string)
     GRN_TEXT_SET(context, bulk, RSTRING_PTR(rb_string), RSTRING_LEN(rb_string));
 }
 
+static RbGrnContext *
+rb_grn_context_get_rb_grn_context (grn_ctx *context)
+{
+    if (!context)
+        return NULL;
+    return GRN_CTX_USER_DATA(context)->ptr;
+}
+
+grn_bool
+rb_grn_context_need_release_gvl (grn_ctx *context, VALUE rb_release_gvl)
+{
+    RbGrnContext *rb_grn_context;
+
+    if (!NIL_P(rb_release_gvl))
+        return RVAL2CBOOL(rb_release_gvl);
+
+    rb_grn_context = rb_grn_context_get_rb_grn_context(context);
+    if (!rb_grn_context)
+        return GRN_FALSE;
+    return rb_grn_context->release_gvl;
+}
+
+/*
+ * Whether the current thread released the GVL by
+ * rb_grn_context_call_without_gvl() or not. It is per thread
+ * instead of per context because callbacks such as logger may be
+ * called for the same context by another thread that holds the
+ * GVL.
+ */
+static THREAD_LOCAL grn_bool rb_grn_context_gvl_released = GRN_FALSE;
+
+#ifdef HAVE_RB_THREAD_CALL_WITHOUT_GVL
+static void
+rb_grn_context_interrupt (void *data)
+{
+    grn_ctx *context = data;
+
+    /* groonga stops the current operation when it checks
+       context->rc next time. */
+    context->rc = GRN_INTERRUPTED_FUNCTION_CALL;
+}
+
+typedef struct {
+    RbGrnCallFunction function;
+    void *data;
+    RbGrnUnblockFunction unblock_function;
+    void *unblock_data;
+    void *result;
+} RbGrnCallWithoutGVLData;
+
+static VALUE
+rb_grn_context_call_without_gvl_body (VALUE user_data)
+{
+    RbGrnCallWithoutGVLData *data = (RbGrnCallWithoutGVLData *)user_data;
+
+    data->result = rb_thread_call_without_gvl(data->function,
+                                              data->data,
+                                              data->unblock_function,
+                                              data->unblock_data);
+    return Qnil;
+}
+#endif
+
+/*
+ * Calls _function_ with _data_ without the GVL. Only groonga API
+ * can be used in _function_. Ruby API must not be used.
+ *
+ * Other Ruby threads can run while _function_ is running. The
+ * running groonga operation is interrupted by Thread#raise,
+ * Thread#kill and so on. The exception of the interrupt such as
+ * the exception passed to Thread#raise is raised after
+ * _function_ returns. context->rc set by the interrupt is cleared
+ * in the case. If the operation is interrupted without an
+ * exception, it is reported as context->rc.
+ *
+ * _context_ must not be used by other threads while _function_ is
+ * running.
+ */
+void *
+rb_grn_context_call_without_gvl (grn_ctx *context,
+                                 RbGrnCallFunction function,
+                                 void *data)
+{
+    return rb_grn_context_call_without_gvl_full(context, function, data,
+                                                NULL, NULL);
+}
+
+/*
+ * It is the same as rb_grn_context_call_without_gvl() but
+ * _unblock_function_ is called with _unblock_data_ instead of
+ * setting context->rc when the running operation is
+ * interrupted. It is useful for an operation that waits for
+ * something and can't check context->rc while it is waiting.
+ *
+ * If _unblock_function_ is NULL, it is the same as
+ * rb_grn_context_call_without_gvl().
+ */
+void *
+rb_grn_context_call_without_gvl_full (grn_ctx *context,
+                                      RbGrnCallFunction function,
+                                      void *data,
+                                      RbGrnUnblockFunction unblock_function,
+                                      void *unblock_data)
+{
+#ifdef HAVE_RB_THREAD_CALL_WITHOUT_GVL
+    RbGrnCallWithoutGVLData call_data;
+    int state = 0;
+
+    if (!rb_grn_context_get_rb_grn_context(context) ||
+        rb_grn_context_gvl_released)
+        return function(data);
+
+    if (!unblock_function) {
+        unblock_function = rb_grn_context_interrupt;
+        unblock_data = context;
+    }
+
+    call_data.function = function;
+    call_data.data = data;
+    call_data.unblock_function = unblock_function;
+    call_data.unblock_data = unblock_data;
+    call_data.result = NULL;
+    rb_grn_context_gvl_released = GRN_TRUE;
+    rb_protect(rb_grn_context_call_without_gvl_body, (VALUE)&call_data,
+               &state);
+    rb_grn_context_gvl_released = GRN_FALSE;
+    if (state != 0) {
+        /* The interrupt is reported by the raised exception. The
+           context must be usable after the exception is rescued. */
+        if (context->rc == GRN_INTERRUPTED_FUNCTION_CALL)
+            context->rc = GRN_SUCCESS;
+        rb_jump_tag(state);
+    }
+
+    return call_data.result;
+#else
+    return function(data);
+#endif
+}
+
+/*
+ * It is the same as rb_grn_context_call_without_gvl_full() but
+ * pending interrupts such as Thread#raise aren't processed. The
+ * caller can save the result of _function_ before the interrupts
+ * are processed. The caller must call rb_thread_check_ints() to
+ * process them.
+ *
+ * _function_ may not be called when an interrupt is already
+ * pending.
+ */
+void *
+rb_grn_context_call_without_gvl_defer_interrupts (grn_ctx *context,
+                                                  RbGrnCallFunction function,
+                                                  void *data,
+                                                  RbGrnUnblockFunction unblock_function,
+                                                  void *unblock_data)
+{
+#ifdef HAVE_RB_THREAD_CALL_WITHOUT_GVL2
+    void *result;
+
+    if (!rb_grn_context_get_rb_grn_context(context) ||
+        rb_grn_context_gvl_released)
+        return function(data);
+
+    if (!unblock_function) {
+        unblock_function = rb_grn_context_interrupt;
+        unblock_data = context;
+    }
+
+    rb_grn_context_gvl_released = GRN_TRUE;
+    result = rb_thread_call_without_gvl2(function, data,
+                                         unblock_function, unblock_data);
+    rb_grn_context_gvl_released = GRN_FALSE;
+
+    return result;
+#else
+    return rb_grn_context_call_without_gvl_full(context, function, data,
+                                                unblock_function,
+                                                unblock_data);
+#endif
+}
+
+#ifdef HAVE_RB_THREAD_CALL_WITH_GVL
+typedef struct _RbGrnCallWithGVLData RbGrnCallWithGVLData;
+struct _RbGrnCallWithGVLData
+{
+    RbGrnCallFunction function;
+    void *data;
+    void *result;
+};
+
+static VALUE
+rb_grn_context_call_with_gvl_body (VALUE user_data)
+{
+    RbGrnCallWithGVLData *data = (RbGrnCallWithGVLData *)user_data;
+
+    data->result = data->function(data->data);
+    return Qnil;
+}
+
+static void *
+rb_grn_context_call_with_gvl_protect (void *user_data)
+{
+    int state = 0;
+
+    rb_protect(rb_grn_context_call_with_gvl_body, (VALUE)user_data, &state);
+    if (state != 0) {
+        /* We can't raise an exception across a function called
+           without the GVL. */
+        rb_set_errinfo(Qnil);
+    }
+    return NULL;
+}
+#endif
+
+/*
+ * Calls _function_ with _data_ with the GVL. It is for callbacks
+ * from groonga such as logger. They may be called while
+ * _context_ is processing an operation without the GVL by
+ * rb_grn_context_call_without_gvl().
+ *
+ * If an exception is raised in _function_ called while the GVL
+ * is released, the exception is ignored.
+ */
+void *
+rb_grn_context_call_with_gvl (grn_ctx *context,
+                              RbGrnCallFunction function,
+                              void *data)
+{
+#ifdef HAVE_RB_THREAD_CALL_WITH_GVL
+    RbGrnCallWithGVLData call_data;
+
+    if (!rb_grn_context_gvl_released)
+        return function(data);
+
+    call_data.function = function;
+    call_data.data = data;
+    call_data.result = NULL;
+    rb_grn_context_gvl_released = GRN_FALSE;
+    rb_thread_call_with_gvl(rb_grn_context_call_with_gvl_protect, &call_data);
+    rb_grn_context_gvl_released = GRN_TRUE;
+
+    return call_data.result;
+#else
+    return function(data);
+#endif
+}
+
 /*
  * デフォルトのコンテキストを返す。デフォルトのコンテキスト
  * が作成されていない場合は暗黙のうちに作成し、それを返す。
@@ -430,6 +686,10 @@ rb_grn_context_s_set_default_options (VALUE self, VALUE options)
  *   @option options [Groonga::Encoding] :encoding The encoding
  *     エンコーディングを指定する。エンコーディングの指定方法
  *     は {Groonga::Encoding} を参照。
+ *   @option options [Boolean] :release_gvl (false)
+ *     +true+ を指定すると時間のかかる検索処理（ {Groonga::Table#select} ,
+ *     {Groonga::Table#sort} , {Groonga::Table#group} ）の実行中に
+ *     GVLを解放する。詳細は {#release_gvl=} を参照。
  */
 static VALUE
 rb_grn_context_initialize (int argc, VALUE *argv, VALUE self)
@@ -438,7 +698,7 @@ rb_grn_context_initialize (int argc, VALUE *argv, VALUE self)
     grn_ctx *context;
     int flags = 0; /* TODO: GRN_CTX_PER_DB */
     VALUE options, default_options;
-    VALUE rb_encoding;
+    VALUE rb_encoding, rb_release_gvl;
 
     rb_scan_args(argc, argv, "01", &options);
     default_options = rb_grn_context_s_get_default_options(rb_obj_class(self));
@@ -451,11 +711,15 @@ rb_grn_context_initialize (int argc, VALUE *argv, VALUE self)
 
     rb_grn_scan_options(options,
                         "encoding", &rb_encoding,
+                        "release_gvl", &rb_release_gvl,
                         NULL);
 
     rb_grn_context = ALLOC(RbGrnContext);
     DATA_PTR(self) = rb_grn_context;
     rb_grn_context->self = self;
+    rb_grn_context->release_gvl = RVAL2CBOOL(rb_release_gvl);
+    rb_grn_context->connected = GRN_FALSE;
+    rb_grn_context->select_cache = NULL;
     grn_ctx_init(&(rb_grn_context->context_entity), flags);
     context = rb_grn_context->context = &(rb_grn_context->context_entity);
     rb_grn_context_check(context, self);
@@ -473,6 +737,7 @@ rb_grn_context_initialize (int argc, VALUE *argv, VALUE self)
     }
 
     rb_iv_set(self, "@memory_pools", rb_ary_new());
+    rb_iv_set(self, "@profiler", Qnil);
 
     debug("context new: %p\n", context);
 
@@ -647,6 +912,231 @@ rb_grn_context_set_match_escalation_threshold (VALUE self, VALUE threshold)
     return threshold;
 }
 
+/*
+ * Returns whether the GVL is released while heavy operations
+ * use this context or not.
+ *
+ * @overload release_gvl?
+ *   @return [Boolean] +true+ if the GVL is released, +false+ otherwise.
+ *
+ * @see #release_gvl=
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_context_release_gvl_p (VALUE self)
+{
+    RbGrnContext *rb_grn_context;
+
+    Data_Get_Struct(self, RbGrnContext, rb_grn_context);
+    return CBOOL2RVAL(rb_grn_context->release_gvl);
+}
+
+/*
+ * Sets whether the GVL is released while heavy operations use
+ * this context or not. Heavy operations are {Groonga::Table#select},
+ * {Groonga::Table#sort} and {Groonga::Table#group}. They also
+ * accept @:release_gvl@ option to overwrite this value per call.
+ *
+ * Other Ruby threads can run while an operation is running without
+ * the GVL. So you can search the same database in parallel by
+ * multiple threads. Each thread must use its own context because a
+ * context can't be used by multiple threads at the same time.
+ *
+ * An operation running without the GVL is interrupted by
+ * Thread#raise, Thread#kill, Timeout and so on. The interrupted
+ * operation raises the exception of the interrupt such as the
+ * exception passed to Thread#raise. The context can be used
+ * after the exception is rescued.
+ *
+ * @example Searches in parallel
+ *   threads = 4.times.collect do
+ *     Thread.new do
+ *       context = Groonga::Context.new(:release_gvl => true)
+ *       context.open_database(path) do
+ *         entries = context["Entries"]
+ *         entries.select {|record| record.content =~ "groonga"}.size
+ *       end
+ *     end
+ *   end
+ *   threads.collect(&:value)
+ *
+ * @overload release_gvl=(release_gvl)
+ *   @param release_gvl [Boolean] +true+ to release the GVL.
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_context_set_release_gvl (VALUE self, VALUE rb_release_gvl)
+{
+    RbGrnContext *rb_grn_context;
+
+    Data_Get_Struct(self, RbGrnContext, rb_grn_context);
+    rb_grn_context->release_gvl = RVAL2CBOOL(rb_release_gvl);
+
+    return rb_release_gvl;
+}
+
+RbGrnSelectCache *
+rb_grn_context_get_select_cache (grn_ctx *context)
+{
+    RbGrnContext *rb_grn_context;
+
+    rb_grn_context = rb_grn_context_get_rb_grn_context(context);
+    if (!rb_grn_context)
+        return NULL;
+    if (!rb_grn_context->select_cache)
+        return NULL;
+    if (rb_grn_context->select_cache->max_size == 0)
+        return NULL;
+    return rb_grn_context->select_cache;
+}
+
+/*
+ * Returns the max number of results cached by the select cache.
+ *
+ * @overload select_cache_size
+ *   @return [Integer] The max number of cached results. +0+ means
+ *     that the select cache is disabled.
+ *
+ * @see #select_cache_size=
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_context_get_select_cache_size (VALUE self)
+{
+    RbGrnContext *rb_grn_context;
+
+    Data_Get_Struct(self, RbGrnContext, rb_grn_context);
+    if (!rb_grn_context->select_cache)
+        return UINT2NUM(0);
+    return UINT2NUM(rb_grn_context->select_cache->max_size);
+}
+
+/*
+ * Sets the max number of results cached by the select cache. The
+ * select cache is disabled by default.
+ *
+ * The select cache caches IDs and scores of records in a result of
+ * {Groonga::Table#select} with a query string. A cached result is
+ * used for the same table, query and options. Select with a block,
+ * a {Groonga::Expression}, +:result+ option or +:syntax => :script+
+ * isn't cached.
+ *
+ * Cached results are expired when the database is modified. You
+ * can expire them explicitly by {Groonga::Database#touch}. When
+ * the number of cached results exceeds the max number, the least
+ * recently used result is evicted.
+ *
+ * @example Cache 100 results
+ *   context.select_cache_size = 100
+ *   entries.select("content:@groonga") # miss
+ *   entries.select("content:@groonga") # hit
+ *   p context.select_cache_statistics
+ *     # => {:size=>1, :max_size=>100, :n_hits=>1, :n_misses=>1, :n_evictions=>0}
+ *
+ * @overload select_cache_size=(size)
+ *   @param size [Integer] The max number of cached results. +0+
+ *     disables the select cache and clears cached results.
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_context_set_select_cache_size (VALUE self, VALUE rb_size)
+{
+    RbGrnContext *rb_grn_context;
+    grn_ctx *context;
+    unsigned int size;
+
+    context = SELF(self);
+    Data_Get_Struct(self, RbGrnContext, rb_grn_context);
+    size = NUM2UINT(rb_size);
+#ifndef HAVE_GRN_DB_GET_LAST_MODIFIED
+    if (size > 0) {
+        rb_raise(rb_eNotImpError,
+                 "select cache isn't supported by groonga %d.%d.%d: "
+                 "grn_db_get_last_modified() is needed",
+                 GRN_MAJOR_VERSION, GRN_MINOR_VERSION, GRN_MICRO_VERSION);
+    }
+#endif
+    if (rb_grn_context->select_cache) {
+        rb_grn_select_cache_set_max_size(context,
+                                         rb_grn_context->select_cache,
+                                         size);
+    } else if (size > 0) {
+        rb_grn_context->select_cache = rb_grn_select_cache_new(context, size);
+    }
+
+    return rb_size;
+}
+
+/*
+ * Returns statistics of the select cache.
+ *
+ * @overload select_cache_statistics
+ *   @return [::Hash] The statistics. It has the following keys:
+ *
+ *     - +:size+ := The number of cached results. =:
+ *     - +:max_size+ := The max number of cached results. =:
+ *     - +:n_hits+ := The number of selects that used a cached
+ *       result. =:
+ *     - +:n_misses+ := The number of selects that didn't find a
+ *       valid cached result. =:
+ *     - +:n_evictions+ := The number of results evicted because the
+ *       cache was full. =:
+ *
+ * @see #select_cache_size=
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_context_get_select_cache_statistics (VALUE self)
+{
+    RbGrnContext *rb_grn_context;
+    RbGrnSelectCache *cache;
+    VALUE rb_statistics;
+
+    Data_Get_Struct(self, RbGrnContext, rb_grn_context);
+    cache = rb_grn_context->select_cache;
+
+    rb_statistics = rb_hash_new();
+    rb_hash_aset(rb_statistics, ID2SYM(rb_intern("size")),
+                 UINT2NUM(cache ? cache->size : 0));
+    rb_hash_aset(rb_statistics, ID2SYM(rb_intern("max_size")),
+                 UINT2NUM(cache ? cache->max_size : 0));
+    rb_hash_aset(rb_statistics, ID2SYM(rb_intern("n_hits")),
+                 ULL2NUM(cache ? cache->n_hits : 0));
+    rb_hash_aset(rb_statistics, ID2SYM(rb_intern("n_misses")),
+                 ULL2NUM(cache ? cache->n_misses : 0));
+    rb_hash_aset(rb_statistics, ID2SYM(rb_intern("n_evictions")),
+                 ULL2NUM(cache ? cache->n_evictions : 0));
+
+    return rb_statistics;
+}
+
+/*
+ * Clears all cached results in the select cache.
+ *
+ * @overload clear_select_cache
+ *   @return [void]
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_context_clear_select_cache (VALUE self)
+{
+    RbGrnContext *rb_grn_context;
+    grn_ctx *context;
+
+    context = SELF(self);
+    Data_Get_Struct(self, RbGrnContext, rb_grn_context);
+    if (rb_grn_context->select_cache)
+        rb_grn_select_cache_clear(context, rb_grn_context->select_cache);
+
+    return Qnil;
+}
+
 /*
  * groongaがZlibサポート付きでビルドされていれば +true+ 、そう
  * でなければ +false+ を返す。
@@ -720,6 +1210,7 @@ rb_grn_context_get_database (VALUE self)
 static VALUE
 rb_grn_context_connect (int argc, VALUE *argv, VALUE self)
 {
+    RbGrnContext *rb_grn_context;
     grn_ctx *context;
     const char *host;
     int port;
@@ -750,10 +1241,31 @@ rb_grn_context_connect (int argc, VALUE *argv, VALUE self)
     rc = grn_ctx_connect(context, host, port, flags);
     rb_grn_context_check(context, self);
     rb_grn_rc_check(rc, self);
+    Data_Get_Struct(self, RbGrnContext, rb_grn_context);
+    rb_grn_context->connected = GRN_TRUE;
 
     return Qnil;
 }
 
+/*
+ * Returns whether the context is connected to a groonga server
+ * by {#connect} or not.
+ *
+ * @overload connected?
+ *   @return [Boolean] +true+ if the context is connected to a
+ *     groonga server, +false+ otherwise.
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_context_connected_p (VALUE self)
+{
+    RbGrnContext *rb_grn_context;
+
+    Data_Get_Struct(self, RbGrnContext, rb_grn_context);
+    return CBOOL2RVAL(rb_grn_context->connected);
+}
+
 /*
  * groongaサーバにクエリ文字列を送信する。
  * @return [Integer] ID
@@ -778,23 +1290,114 @@ rb_grn_context_send (VALUE self, VALUE rb_string)
     return UINT2NUM(query_id);
 }
 
+typedef struct _ReceiveData ReceiveData;
+struct _ReceiveData
+{
+    grn_ctx *context;
+    char *result;
+    unsigned int result_size;
+    int flags;
+    unsigned int query_id;
+};
+
+static void *
+rb_grn_context_receive_without_gvl (void *user_data)
+{
+    ReceiveData *data = user_data;
+
+    data->query_id = grn_ctx_recv(data->context,
+                                  &(data->result),
+                                  &(data->result_size),
+                                  &(data->flags));
+    return NULL;
+}
+
+/*
+ * Waits until a response can be read from the connection. It is
+ * waited by Ruby. So it can be interrupted by Thread#raise,
+ * Thread#kill, Timeout and so on. grn_ctx_recv() can't be
+ * interrupted while it is blocked in recv(2).
+ */
+static void
+rb_grn_context_wait_response_raw (grn_ctx *context)
+{
+#ifndef WIN32
+    grn_ctx_info info;
+
+    if (grn_ctx_info_get(context, &info) != GRN_SUCCESS)
+        return;
+    if (info.fd < 0)
+        return;
+    rb_thread_wait_fd(info.fd);
+#endif
+}
+
+/*
+ * Waits until a response from the connected groonga server can be
+ * received. It returns immediately if the context isn't connected.
+ *
+ * Other Ruby threads can run and can use the context by
+ * {#send} while it is waiting. The wait can be interrupted by
+ * Thread#raise, Thread#kill, Timeout and so on.
+ *
+ * @overload wait_response
+ *   @return [void]
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_context_wait_response (VALUE self)
+{
+    RbGrnContext *rb_grn_context;
+    grn_ctx *context;
+
+    context = SELF(self);
+    Data_Get_Struct(self, RbGrnContext, rb_grn_context);
+    if (rb_grn_context->connected)
+        rb_grn_context_wait_response_raw(context);
+
+    return Qnil;
+}
+
 /*
  * groongaサーバからクエリ実行結果文字列を受信する。
+ *
+ * If the context is connected to a groonga server, it waits for
+ * a response by {#wait_response} and receives it without the
+ * GVL. Other Ruby threads can run while it is waiting.
+ *
  * @overload receive
  * @return [[ID, String]] クエリ実行結果
  */
 static VALUE
 rb_grn_context_receive (VALUE self)
 {
+    RbGrnContext *rb_grn_context;
     grn_ctx *context;
-    char *result = NULL;
+    ReceiveData data;
+    char *result;
     unsigned result_size;
     VALUE rb_result;
-    int flags = 0;
     unsigned int query_id;
 
     context = SELF(self);
-    query_id = grn_ctx_recv(context, &result, &result_size, &flags);
+    Data_Get_Struct(self, RbGrnContext, rb_grn_context);
+    data.context = context;
+    data.result = NULL;
+    data.result_size = 0;
+    data.flags = 0;
+    data.query_id = 0;
+    if (rb_grn_context->connected) {
+        rb_grn_context_wait_response_raw(context);
+        rb_grn_context_call_without_gvl(context,
+                                        rb_grn_context_receive_without_gvl,
+                                        &data);
+    } else {
+        rb_grn_context_receive_without_gvl(&data);
+    }
+    query_id = data.query_id;
+    result = data.result;
+    result_size = data.result_size;
     if (result) {
         rb_result = rb_str_new(result, result_size);
     } else {
@@ -969,6 +1572,18 @@ rb_grn_init_context (VALUE mGrn)
                      rb_grn_context_get_match_escalation_threshold, 0);
     rb_define_method(cGrnContext, "match_escalation_threshold=",
                      rb_grn_context_set_match_escalation_threshold, 1);
+    rb_define_method(cGrnContext, "release_gvl?",
+                     rb_grn_context_release_gvl_p, 0);
+    rb_define_method(cGrnContext, "release_gvl=",
+                     rb_grn_context_set_release_gvl, 1);
+    rb_define_method(cGrnContext, "select_cache_size",
+                     rb_grn_context_get_select_cache_size, 0);
+    rb_define_method(cGrnContext, "select_cache_size=",
+                     rb_grn_context_set_select_cache_size, 1);
+    rb_define_method(cGrnContext, "select_cache_statistics",
+                     rb_grn_context_get_select_cache_statistics, 0);
+    rb_define_method(cGrnContext, "clear_select_cache",
+                     rb_grn_context_clear_select_cache, 0);
 
     rb_define_method(cGrnContext, "support_zlib?",
                      rb_grn_context_support_zlib_p, 0);
@@ -980,6 +1595,9 @@ rb_grn_init_context (VALUE mGrn)
     rb_define_method(cGrnContext, "[]", rb_grn_context_array_reference, 1);
 
     rb_define_method(cGrnContext, "connect", rb_grn_context_connect, -1);
+    rb_define_method(cGrnContext, "connected?", rb_grn_context_connected_p, 0);
     rb_define_method(cGrnContext, "send", rb_grn_context_send, 1);
     rb_define_method(cGrnContext, "receive", rb_grn_context_receive, 0);
+    rb_define_method(cGrnContext, "wait_response",
+                     rb_grn_context_wait_response, 0);
 }
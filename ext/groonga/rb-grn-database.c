@@ -510,18 +510,42 @@ rb_grn_database_is_locked (VALUE self)
 /*
  * _database_ の最終更新時刻を現在時刻にする。
  *
- * @overload touch
+ * _time_ is available since 4.0.5. It needs groonga that has
+ * grn_obj_touch().
+ *
+ * @overload touch(time=nil)
+ *   @param time [Time, nil] The last modified time. If it is
+ *     +nil+, the current time is used.
  */
 static VALUE
-rb_grn_database_touch (VALUE self)
+rb_grn_database_touch (int argc, VALUE *argv, VALUE self)
 {
     grn_ctx *context;
     grn_obj *database;
+    VALUE rb_time;
+
+    rb_scan_args(argc, argv, "01", &rb_time);
 
     rb_grn_database_deconstruct(SELF(self), &database, &context,
                                 NULL, NULL, NULL, NULL);
 
-    grn_db_touch(context, database);
+    if (NIL_P(rb_time)) {
+        grn_db_touch(context, database);
+    } else {
+#ifdef HAVE_GRN_OBJ_TOUCH
+        grn_timeval time_value;
+
+        time_value.tv_sec = NUM2LL(rb_funcall(rb_time, rb_intern("to_i"), 0));
+        time_value.tv_nsec =
+            NUM2LONG(rb_funcall(rb_time, rb_intern("nsec"), 0));
+        grn_obj_touch(context, database, &time_value);
+#else
+        rb_raise(rb_eNotImpError,
+                 "touching with time isn't supported by groonga %d.%d.%d: "
+                 "grn_obj_touch() is needed",
+                 GRN_MAJOR_VERSION, GRN_MINOR_VERSION, GRN_MICRO_VERSION);
+#endif
+    }
     return Qnil;
 }
 
@@ -591,6 +615,6 @@ rb_grn_init_database (VALUE mGrn)
                      rb_grn_database_clear_lock, 0);
     rb_define_method(rb_cGrnDatabase, "locked?", rb_grn_database_is_locked, 0);
 
-    rb_define_method(rb_cGrnDatabase, "touch", rb_grn_database_touch, 0);
+    rb_define_method(rb_cGrnDatabase, "touch", rb_grn_database_touch, -1);
     rb_define_method(rb_cGrnDatabase, "defrag", rb_grn_database_defrag, -1);
 }
@@ -21,6 +21,10 @@
 
 #define SELF(object) ((RbGrnIndexCursor *)DATA_PTR(object))
 
+/* The max number of postings allocated before a slice is filled.
+   A larger slice grows its buffer on demand. */
+#define PACKED_SLICE_MAX_INITIAL_N_POSTINGS 65536
+
 VALUE rb_cGrnIndexCursor;
 
 VALUE
@@ -126,6 +130,96 @@ rb_grn_index_cursor_each (VALUE self)
     return Qnil;
 }
 
+/*
+ * Iterates postings by _n_ postings. Postings are passed to the
+ * block as a String that packs postings. A posting is packed as
+ * six 32bit unsigned integers in native byte order: record ID,
+ * section ID, term ID, position, term frequency and weight. Use
+ * +String#unpack("L*")+ and +Array#each_slice(6)+ to get
+ * postings as Arrays. The last String may have less than _n_
+ * postings.
+ *
+ * It is useful to process many postings without creating a
+ * {Groonga::Posting} for each posting.
+ *
+ * @example
+ *   terms.open_cursor do |table_cursor|
+ *     index.open_cursor(table_cursor) do |cursor|
+ *       cursor.each_packed_slice(10000) do |packed_postings|
+ *         packed_postings.unpack("L*").each_slice(6) do |posting|
+ *           record_id, section_id, term_id, position,
+ *             term_frequency, weight = posting
+ *           # ...
+ *         end
+ *       end
+ *     end
+ *   end
+ *
+ * @overload each_packed_slice(n)
+ *   @param n [Integer] The max number of postings in a slice.
+ *   @yield [packed_postings] Gives packed postings to the block.
+ *   @yieldparam packed_postings [String] Packed postings.
+ *   @return [nil]
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_index_cursor_each_packed_slice (VALUE self, VALUE rb_n)
+{
+    RbGrnObject *rb_grn_object;
+    grn_obj *cursor;
+    grn_ctx *context;
+    grn_posting *posting;
+    grn_id term_id;
+    uint32_t packed_posting[6];
+    long n, n_postings, initial_n_postings;
+    VALUE rb_packed_postings;
+
+    RETURN_ENUMERATOR(self, 1, &rb_n);
+
+    n = NUM2LONG(rb_n);
+    if (n <= 0) {
+        rb_raise(rb_eArgError,
+                 "slice size should be positive: <%ld>: <%s>",
+                 n, rb_grn_inspect(self));
+    }
+
+    rb_grn_index_cursor_deconstruct(SELF(self), &cursor, &context,
+                                    NULL, NULL, NULL, NULL);
+    if (!context || !cursor)
+        return Qnil;
+
+    rb_grn_object = RB_GRN_OBJECT(SELF(self));
+    initial_n_postings = n;
+    if (initial_n_postings > PACKED_SLICE_MAX_INITIAL_N_POSTINGS)
+        initial_n_postings = PACKED_SLICE_MAX_INITIAL_N_POSTINGS;
+    rb_packed_postings =
+        rb_str_buf_new(sizeof(packed_posting) * initial_n_postings);
+    n_postings = 0;
+    while (rb_grn_object->object &&
+           (posting = grn_index_cursor_next(context, cursor, &term_id))) {
+        packed_posting[0] = posting->rid;
+        packed_posting[1] = posting->sid;
+        packed_posting[2] = term_id;
+        packed_posting[3] = posting->pos;
+        packed_posting[4] = posting->tf;
+        packed_posting[5] = posting->weight;
+        rb_str_cat(rb_packed_postings,
+                   (const char *)packed_posting, sizeof(packed_posting));
+        n_postings++;
+        if (n_postings == n) {
+            rb_yield(rb_packed_postings);
+            rb_packed_postings =
+                rb_str_buf_new(sizeof(packed_posting) * initial_n_postings);
+            n_postings = 0;
+        }
+    }
+    if (n_postings > 0)
+        rb_yield(rb_packed_postings);
+
+    return Qnil;
+}
+
 void
 rb_grn_init_index_cursor (VALUE mGrn)
 {
@@ -136,4 +230,6 @@ rb_grn_init_index_cursor (VALUE mGrn)
 
     rb_define_method(rb_cGrnIndexCursor, "next", rb_grn_index_cursor_next, 0);
     rb_define_method(rb_cGrnIndexCursor, "each", rb_grn_index_cursor_each, 0);
+    rb_define_method(rb_cGrnIndexCursor, "each_packed_slice",
+                     rb_grn_index_cursor_each_packed_slice, 1);
 }
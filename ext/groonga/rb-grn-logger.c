@@ -146,23 +146,51 @@ rb_grn_logger_reset (VALUE klass)
     rb_grn_logger_reset_with_error_check(klass, NULL);
 }
 
+typedef struct _RbGrnLoggerLogData RbGrnLoggerLogData;
+struct _RbGrnLoggerLogData
+{
+    VALUE handler;
+    grn_log_level level;
+    const char *timestamp;
+    const char *title;
+    const char *message;
+    const char *location;
+};
+
+static void *
+rb_grn_logger_log_body (void *user_data)
+{
+    RbGrnLoggerLogData *data = user_data;
+
+    /* TODO: use rb_protect(). */
+    rb_funcall(data->handler, id_log, 5,
+               GRNLOGLEVEL2RVAL(data->level),
+               rb_str_new2(data->timestamp),
+               rb_str_new2(data->title),
+               rb_str_new2(data->message),
+               rb_str_new2(data->location));
+    return NULL;
+}
+
 static void
 rb_grn_logger_log (grn_ctx *ctx, grn_log_level level,
                    const char *timestamp, const char *title, const char *message,
                    const char *location, void *user_data)
 {
     VALUE handler = (VALUE)user_data;
+    RbGrnLoggerLogData data;
 
     if (NIL_P(handler))
         return;
 
-    /* TODO: use rb_protect(). */
-    rb_funcall(handler, id_log, 5,
-               GRNLOGLEVEL2RVAL(level),
-               rb_str_new2(timestamp),
-               rb_str_new2(title),
-               rb_str_new2(message),
-               rb_str_new2(location));
+    data.handler = handler;
+    data.level = level;
+    data.timestamp = timestamp;
+    data.title = title;
+    data.message = message;
+    data.location = location;
+    /* ctx may be processing an operation without the GVL. */
+    rb_grn_context_call_with_gvl(ctx, rb_grn_logger_log_body, &data);
 }
 
 static void
@@ -0,0 +1,937 @@
+/* -*- coding: utf-8; mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+  Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License version 2.1 as published by the Free Software Foundation.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "rb-grn.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Document-class: Groonga::NativeQueryLogger
+ *
+ * A query logger that doesn't call Ruby for each query log
+ * event. Events are copied into a lock-free ring buffer by the
+ * thread that emits them. A drain thread writes them to a file
+ * without the GVL. Register it by {Groonga::QueryLogger.register}.
+ *
+ * If the ring buffer is full, new events are dropped. Dropped
+ * events are counted by {#n_dropped_events}.
+ *
+ * @since 4.0.5
+ */
+
+#define SELF(object) (rb_grn_native_query_logger_get(object))
+
+#define TIMESTAMP_SIZE 32
+#define INFO_SIZE 64
+#define CONTEXT_ID_SIZE 32
+#define DRAIN_POLL_INTERVAL_MSEC 10
+
+#if defined(_MSC_VER)
+#  define CAS32(pointer, old_value, new_value)                          \
+    (InterlockedCompareExchange((volatile LONG *)(pointer),             \
+                                (LONG)(new_value),                      \
+                                (LONG)(old_value)) == (LONG)(old_value))
+#  define INCREMENT32(pointer) InterlockedIncrement((volatile LONG *)(pointer))
+#  define DECREMENT32(pointer) InterlockedDecrement((volatile LONG *)(pointer))
+#  define MEMORY_BARRIER() MemoryBarrier()
+#else
+#  define CAS32(pointer, old_value, new_value)                  \
+    __sync_bool_compare_and_swap((pointer), (old_value), (new_value))
+#  define INCREMENT32(pointer) __sync_add_and_fetch((pointer), 1)
+#  define DECREMENT32(pointer) __sync_sub_and_fetch((pointer), 1)
+#  define MEMORY_BARRIER() __sync_synchronize()
+#endif
+
+typedef enum {
+    FORMAT_TEXT,
+    FORMAT_JSON,
+    FORMAT_BINARY
+} Format;
+
+typedef struct _Slot
+{
+    volatile uint32_t sequence;
+    unsigned int flag;
+    char timestamp[TIMESTAMP_SIZE];
+    char info[INFO_SIZE];
+    uint32_t message_size;
+    char message[1];
+} Slot;
+
+typedef struct _Buffer
+{
+    char *data;
+    size_t size;
+    size_t capacity;
+} Buffer;
+
+typedef struct _PendingQuery
+{
+    char context_id[CONTEXT_ID_SIZE];
+    Buffer events;
+} PendingQuery;
+
+typedef struct _RbGrnNativeQueryLogger
+{
+    char *path;
+    FILE *file;
+    int open_errno;
+    Format format;
+    double sample_rate;
+    double sample_accumulator;
+    uint64_t slow_threshold;
+    uint32_t buffer_size;
+    size_t max_message_size;
+    size_t slot_size;
+    char *slots;
+    volatile uint32_t enqueue_position;
+    uint32_t dequeue_position;
+    volatile uint32_t n_dropped_events;
+    uint64_t n_drained_events;
+    volatile grn_bool reopen_requested;
+    volatile grn_bool closed;
+    volatile grn_bool interrupted;
+    PendingQuery *pending_queries;
+    size_t n_pending_queries;
+    Buffer output;
+    struct _RbGrnNativeQueryLogger *next_retired;
+} RbGrnNativeQueryLogger;
+
+VALUE rb_cGrnNativeQueryLogger;
+
+static grn_query_logger rb_grn_native_query_logger;
+
+/*
+ * The registered logger is referred from here instead of
+ * grn_query_logger::user_data. A producer counts itself in
+ * n_producers before it refers the registered logger. So a logger
+ * that isn't registered can't be referred by a producer that
+ * starts after n_producers is 0.
+ */
+static RbGrnNativeQueryLogger * volatile rb_grn_native_query_logger_current = NULL;
+static volatile uint32_t rb_grn_native_query_logger_n_producers = 0;
+/*
+ * Loggers that are freed by GC while producers may refer
+ * them. They are freed when no producer is running.
+ */
+static RbGrnNativeQueryLogger *rb_grn_native_query_logger_retired = NULL;
+
+#define SLOT(logger, position)                                          \
+    ((Slot *)((logger)->slots +                                         \
+              (logger)->slot_size *                                     \
+              ((position) & ((logger)->buffer_size - 1))))
+
+static void
+buffer_append (Buffer *buffer, const char *data, size_t size)
+{
+    if (buffer->size + size > buffer->capacity) {
+        size_t capacity = buffer->capacity == 0 ? 4096 : buffer->capacity;
+        char *new_data;
+
+        while (buffer->size + size > capacity) {
+            capacity *= 2;
+        }
+        new_data = realloc(buffer->data, capacity);
+        if (!new_data)
+            return;
+        buffer->data = new_data;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+}
+
+static void
+buffer_append_string (Buffer *buffer, const char *string)
+{
+    buffer_append(buffer, string, strlen(string));
+}
+
+static void
+buffer_append_json_string (Buffer *buffer, const char *string, size_t size)
+{
+    size_t i;
+
+    buffer_append(buffer, "\"", 1);
+    for (i = 0; i < size; i++) {
+        unsigned char character = string[i];
+        char escaped[7];
+
+        switch (character) {
+        case '"':
+            buffer_append(buffer, "\\\"", 2);
+            break;
+        case '\\':
+            buffer_append(buffer, "\\\\", 2);
+            break;
+        case '\n':
+            buffer_append(buffer, "\\n", 2);
+            break;
+        case '\r':
+            buffer_append(buffer, "\\r", 2);
+            break;
+        case '\t':
+            buffer_append(buffer, "\\t", 2);
+            break;
+        default:
+            if (character < 0x20) {
+                snprintf(escaped, sizeof(escaped), "\\u%04x", character);
+                buffer_append(buffer, escaped, 6);
+            } else {
+                buffer_append(buffer, (const char *)&character, 1);
+            }
+            break;
+        }
+    }
+    buffer_append(buffer, "\"", 1);
+}
+
+static void
+buffer_free (Buffer *buffer)
+{
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+}
+
+static void
+copy_string (char *destination, size_t destination_size, const char *source)
+{
+    size_t size;
+
+    size = strlen(source);
+    if (size >= destination_size)
+        size = destination_size - 1;
+    memcpy(destination, source, size);
+    destination[size] = '\0';
+}
+
+static void
+rb_grn_native_query_logger_log (grn_ctx *ctx, unsigned int flag,
+                                const char *timestamp, const char *info,
+                                const char *message, void *user_data)
+{
+    RbGrnNativeQueryLogger *logger;
+    Slot *slot;
+    uint32_t position;
+    size_t message_size;
+
+    INCREMENT32(&rb_grn_native_query_logger_n_producers);
+    logger = rb_grn_native_query_logger_current;
+    if (!logger || logger->closed)
+        goto exit;
+
+    position = logger->enqueue_position;
+    for (;;) {
+        int32_t diff;
+
+        slot = SLOT(logger, position);
+        MEMORY_BARRIER();
+        diff = (int32_t)(slot->sequence - position);
+        if (diff == 0) {
+            if (CAS32(&(logger->enqueue_position), position, position + 1))
+                break;
+            position = logger->enqueue_position;
+        } else if (diff < 0) {
+            INCREMENT32(&(logger->n_dropped_events));
+            goto exit;
+        } else {
+            position = logger->enqueue_position;
+        }
+    }
+
+    slot->flag = flag;
+    copy_string(slot->timestamp, TIMESTAMP_SIZE, timestamp);
+    copy_string(slot->info, INFO_SIZE, info);
+    message_size = strlen(message);
+    if (message_size > logger->max_message_size)
+        message_size = logger->max_message_size;
+    memcpy(slot->message, message, message_size);
+    slot->message_size = message_size;
+    MEMORY_BARRIER();
+    slot->sequence = position + 1;
+
+exit:
+    DECREMENT32(&rb_grn_native_query_logger_n_producers);
+}
+
+static void
+rb_grn_native_query_logger_reopen (grn_ctx *ctx, void *user_data)
+{
+    RbGrnNativeQueryLogger *logger = rb_grn_native_query_logger_current;
+
+    if (!logger)
+        return;
+
+    /* The file is reopened by the drain thread. */
+    logger->reopen_requested = GRN_TRUE;
+}
+
+static void
+rb_grn_native_query_logger_fin (grn_ctx *ctx, void *user_data)
+{
+}
+
+static Slot *
+rb_grn_native_query_logger_peek (RbGrnNativeQueryLogger *logger)
+{
+    Slot *slot;
+
+    slot = SLOT(logger, logger->dequeue_position);
+    MEMORY_BARRIER();
+    if ((int32_t)(slot->sequence - (logger->dequeue_position + 1)) != 0)
+        return NULL;
+    return slot;
+}
+
+static void
+rb_grn_native_query_logger_release (RbGrnNativeQueryLogger *logger,
+                                    Slot *slot)
+{
+    MEMORY_BARRIER();
+    slot->sequence = logger->dequeue_position + logger->buffer_size;
+    logger->dequeue_position++;
+}
+
+static void
+rb_grn_native_query_logger_format (RbGrnNativeQueryLogger *logger,
+                                   Slot *slot, Buffer *buffer)
+{
+    switch (logger->format) {
+    case FORMAT_TEXT:
+        buffer_append_string(buffer, slot->timestamp);
+        buffer_append(buffer, "|", 1);
+        buffer_append_string(buffer, slot->info);
+        buffer_append(buffer, slot->message, slot->message_size);
+        buffer_append(buffer, "\n", 1);
+        break;
+    case FORMAT_JSON:
+    {
+        char flag[32];
+
+        buffer_append_string(buffer, "{\"timestamp\":");
+        buffer_append_json_string(buffer,
+                                  slot->timestamp, strlen(slot->timestamp));
+        snprintf(flag, sizeof(flag), ",\"flag\":%u,\"info\":", slot->flag);
+        buffer_append_string(buffer, flag);
+        buffer_append_json_string(buffer, slot->info, strlen(slot->info));
+        buffer_append_string(buffer, ",\"message\":");
+        buffer_append_json_string(buffer, slot->message, slot->message_size);
+        buffer_append_string(buffer, "}\n");
+        break;
+    }
+    case FORMAT_BINARY:
+    {
+        uint32_t header[4];
+
+        header[0] = slot->flag;
+        header[1] = strlen(slot->timestamp);
+        header[2] = strlen(slot->info);
+        header[3] = slot->message_size;
+        buffer_append(buffer, (const char *)header, sizeof(header));
+        buffer_append(buffer, slot->timestamp, header[1]);
+        buffer_append(buffer, slot->info, header[2]);
+        buffer_append(buffer, slot->message, header[3]);
+        break;
+    }
+    }
+}
+
+/*
+ * info is "#{context address}|#{mark}" or
+ * "#{context address}|#{mark}#{elapsed time in nanoseconds} ".
+ */
+static grn_bool
+rb_grn_native_query_logger_parse_info (const char *info,
+                                       char *context_id,
+                                       char *mark,
+                                       uint64_t *elapsed_time)
+{
+    const char *separator;
+    size_t context_id_size;
+
+    separator = strchr(info, '|');
+    if (!separator)
+        return GRN_FALSE;
+
+    context_id_size = separator - info;
+    if (context_id_size >= CONTEXT_ID_SIZE)
+        context_id_size = CONTEXT_ID_SIZE - 1;
+    memcpy(context_id, info, context_id_size);
+    context_id[context_id_size] = '\0';
+
+    *mark = separator[1];
+    if (*mark == '\0')
+        return GRN_FALSE;
+    *elapsed_time = strtoull(separator + 2, NULL, 10);
+    return GRN_TRUE;
+}
+
+static PendingQuery *
+rb_grn_native_query_logger_find_pending_query (RbGrnNativeQueryLogger *logger,
+                                               const char *context_id,
+                                               grn_bool create)
+{
+    size_t i;
+    PendingQuery *pending_queries;
+    PendingQuery *pending_query;
+
+    for (i = 0; i < logger->n_pending_queries; i++) {
+        pending_query = &(logger->pending_queries[i]);
+        if (strcmp(pending_query->context_id, context_id) == 0)
+            return pending_query;
+    }
+
+    if (!create)
+        return NULL;
+
+    pending_queries = realloc(logger->pending_queries,
+                              sizeof(PendingQuery) *
+                              (logger->n_pending_queries + 1));
+    if (!pending_queries)
+        return NULL;
+    logger->pending_queries = pending_queries;
+    pending_query = &(logger->pending_queries[logger->n_pending_queries]);
+    logger->n_pending_queries++;
+    copy_string(pending_query->context_id, CONTEXT_ID_SIZE, context_id);
+    pending_query->events.data = NULL;
+    pending_query->events.size = 0;
+    pending_query->events.capacity = 0;
+    return pending_query;
+}
+
+static void
+rb_grn_native_query_logger_remove_pending_query (RbGrnNativeQueryLogger *logger,
+                                                 PendingQuery *pending_query)
+{
+    PendingQuery *last_pending_query;
+
+    buffer_free(&(pending_query->events));
+    last_pending_query =
+        &(logger->pending_queries[logger->n_pending_queries - 1]);
+    if (pending_query != last_pending_query)
+        *pending_query = *last_pending_query;
+    logger->n_pending_queries--;
+}
+
+static grn_bool
+rb_grn_native_query_logger_need_filter (RbGrnNativeQueryLogger *logger)
+{
+    return logger->sample_rate < 1.0 || logger->slow_threshold > 0;
+}
+
+/*
+ * Events of a query are kept until the query is finished. They
+ * are written only when the query is slow and sampled.
+ */
+static void
+rb_grn_native_query_logger_filter (RbGrnNativeQueryLogger *logger,
+                                   Slot *slot)
+{
+    char context_id[CONTEXT_ID_SIZE];
+    char mark;
+    uint64_t elapsed_time;
+    PendingQuery *pending_query;
+    grn_bool slow_p, sampled_p;
+
+    if (!rb_grn_native_query_logger_parse_info(slot->info,
+                                               context_id,
+                                               &mark,
+                                               &elapsed_time))
+        return;
+
+    pending_query =
+        rb_grn_native_query_logger_find_pending_query(logger,
+                                                      context_id,
+                                                      mark == '>');
+    if (!pending_query)
+        return;
+
+    if (mark == '>')
+        pending_query->events.size = 0;
+    rb_grn_native_query_logger_format(logger, slot, &(pending_query->events));
+    if (mark != '<')
+        return;
+
+    slow_p = (elapsed_time >= logger->slow_threshold);
+    logger->sample_accumulator += logger->sample_rate;
+    sampled_p = (logger->sample_accumulator >= 1.0);
+    if (sampled_p)
+        logger->sample_accumulator -= 1.0;
+    if (slow_p && sampled_p) {
+        buffer_append(&(logger->output),
+                      pending_query->events.data,
+                      pending_query->events.size);
+    }
+    rb_grn_native_query_logger_remove_pending_query(logger, pending_query);
+}
+
+static void
+rb_grn_native_query_logger_sleep (void)
+{
+#ifdef WIN32
+    Sleep(DRAIN_POLL_INTERVAL_MSEC);
+#else
+    struct timespec interval;
+
+    interval.tv_sec = 0;
+    interval.tv_nsec = DRAIN_POLL_INTERVAL_MSEC * 1000 * 1000;
+    nanosleep(&interval, NULL);
+#endif
+}
+
+typedef struct _DrainData
+{
+    RbGrnNativeQueryLogger *logger;
+    double timeout;
+    long n_events;
+} DrainData;
+
+static void *
+rb_grn_native_query_logger_drain_body (void *user_data)
+{
+    DrainData *data = user_data;
+    RbGrnNativeQueryLogger *logger = data->logger;
+    double waited_time = 0.0;
+    grn_bool need_filter;
+    Slot *slot;
+
+    while (!rb_grn_native_query_logger_peek(logger) &&
+           !logger->interrupted &&
+           !logger->closed &&
+           waited_time < data->timeout) {
+        rb_grn_native_query_logger_sleep();
+        waited_time += DRAIN_POLL_INTERVAL_MSEC / 1000.0;
+    }
+
+    if (logger->reopen_requested) {
+        logger->reopen_requested = GRN_FALSE;
+        if (logger->file)
+            fclose(logger->file);
+        logger->file = fopen(logger->path, "ab");
+        if (!logger->file)
+            logger->open_errno = errno;
+    }
+
+    need_filter = rb_grn_native_query_logger_need_filter(logger);
+    while ((slot = rb_grn_native_query_logger_peek(logger))) {
+        if (need_filter) {
+            rb_grn_native_query_logger_filter(logger, slot);
+        } else {
+            rb_grn_native_query_logger_format(logger, slot, &(logger->output));
+        }
+        rb_grn_native_query_logger_release(logger, slot);
+        data->n_events++;
+    }
+
+    if (logger->output.size > 0 && logger->file) {
+        fwrite(logger->output.data, 1, logger->output.size, logger->file);
+        fflush(logger->file);
+    }
+    logger->output.size = 0;
+    logger->n_drained_events += data->n_events;
+
+    return NULL;
+}
+
+static void
+rb_grn_native_query_logger_drain_interrupt (void *user_data)
+{
+    RbGrnNativeQueryLogger *logger = user_data;
+
+    logger->interrupted = GRN_TRUE;
+}
+
+static void
+rb_grn_native_query_logger_close_raw (RbGrnNativeQueryLogger *logger)
+{
+    DrainData data;
+    size_t i;
+
+    if (logger->closed)
+        return;
+
+    logger->closed = GRN_TRUE;
+    if (rb_grn_native_query_logger_current == logger)
+        rb_grn_native_query_logger_current = NULL;
+    MEMORY_BARRIER();
+    data.logger = logger;
+    data.timeout = 0.0;
+    data.n_events = 0;
+    rb_grn_native_query_logger_drain_body(&data);
+
+    if (logger->file) {
+        fclose(logger->file);
+        logger->file = NULL;
+    }
+    for (i = 0; i < logger->n_pending_queries; i++) {
+        buffer_free(&(logger->pending_queries[i].events));
+    }
+    free(logger->pending_queries);
+    logger->pending_queries = NULL;
+    logger->n_pending_queries = 0;
+    buffer_free(&(logger->output));
+}
+
+static void
+rb_grn_native_query_logger_free_raw (RbGrnNativeQueryLogger *logger)
+{
+    free(logger->slots);
+    xfree(logger->path);
+    xfree(logger);
+}
+
+static void
+rb_grn_native_query_logger_free (void *object)
+{
+    RbGrnNativeQueryLogger *logger = object;
+
+    if (!logger)
+        return;
+
+    rb_grn_native_query_logger_close_raw(logger);
+
+    /* A producer that is running without the GVL may still write
+     * into the slots. */
+    logger->next_retired = rb_grn_native_query_logger_retired;
+    rb_grn_native_query_logger_retired = logger;
+    MEMORY_BARRIER();
+    if (rb_grn_native_query_logger_n_producers > 0)
+        return;
+
+    while (rb_grn_native_query_logger_retired) {
+        logger = rb_grn_native_query_logger_retired;
+        rb_grn_native_query_logger_retired = logger->next_retired;
+        rb_grn_native_query_logger_free_raw(logger);
+    }
+}
+
+static VALUE
+rb_grn_native_query_logger_alloc (VALUE klass)
+{
+    return Data_Wrap_Struct(klass, NULL, rb_grn_native_query_logger_free, NULL);
+}
+
+static RbGrnNativeQueryLogger *
+rb_grn_native_query_logger_get (VALUE object)
+{
+    RbGrnNativeQueryLogger *logger;
+
+    Data_Get_Struct(object, RbGrnNativeQueryLogger, logger);
+    if (!logger) {
+        rb_raise(rb_eGrnError,
+                 "native query logger isn't initialized: %s",
+                 rb_grn_inspect(object));
+    }
+    return logger;
+}
+
+/*
+ * Returns the +grn_query_logger+ that writes events into the ring
+ * buffer of _object_. It is used by
+ * {Groonga::QueryLogger.register}.
+ */
+grn_query_logger *
+rb_grn_native_query_logger_get_query_logger (VALUE object,
+                                             unsigned int flags)
+{
+    RbGrnNativeQueryLogger *logger;
+
+    logger = SELF(object);
+    if (logger->closed) {
+        rb_raise(rb_eGrnClosed,
+                 "native query logger is closed: %s",
+                 rb_grn_inspect(object));
+    }
+    rb_grn_native_query_logger.flags = flags;
+    rb_grn_native_query_logger_current = logger;
+    MEMORY_BARRIER();
+    return &rb_grn_native_query_logger;
+}
+
+/*
+ * Creates a native query logger that writes to _path_.
+ *
+ * @example Log only slow queries as JSON lines
+ *   logger = Groonga::NativeQueryLogger.new("query.log",
+ *                                           :format => :json,
+ *                                           :slow_threshold => 0.1)
+ *   Groonga::QueryLogger.register(logger, :all => true)
+ *
+ * @overload new(path, options={})
+ *   @param path [String] The path of the log file. Events are
+ *     appended to the file.
+ *   @param options [::Hash] The name and value
+ *     pairs. Omitted names are initialized as the default value.
+ *   @option options [Symbol] :format (:text)
+ *     The output format. +:text+ is the same format as
+ *     {Groonga::FileQueryLogger}. +:json+ writes a JSON object
+ *     that has +timestamp+, +flag+, +info+ and +message+ per line.
+ *     +:binary+ writes flag, timestamp size, info size and
+ *     message size as 32bit unsigned integers in native byte
+ *     order and timestamp, info and message for each event.
+ *   @option options [Integer] :buffer_size (1024)
+ *     The number of events that can be buffered. It is rounded
+ *     up to a power of 2.
+ *   @option options [Integer] :max_message_size (4096)
+ *     The max size of a message in bytes. Longer messages are
+ *     truncated.
+ *   @option options [Float] :sample_rate (1.0)
+ *     The rate of logged queries. For example, one in ten queries
+ *     is logged when it is +0.1+.
+ *   @option options [Float] :slow_threshold (0.0)
+ *     Only queries that take the seconds or more are logged.
+ *
+ *     Events of a query are kept until the query is finished
+ *     when +:sample_rate+ or +:slow_threshold+ is specified.
+ *     Events of a query that is started before the logger is
+ *     registered are ignored in the case.
+ *   @option options [Float] :flush_interval (0.1)
+ *     The max seconds that an event is kept in the ring buffer
+ *     before it is written.
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_native_query_logger_initialize (int argc, VALUE *argv, VALUE self)
+{
+    RbGrnNativeQueryLogger *logger;
+    VALUE rb_path, options;
+    VALUE rb_format, rb_buffer_size, rb_max_message_size;
+    VALUE rb_sample_rate, rb_slow_threshold, rb_flush_interval;
+    Format format = FORMAT_TEXT;
+    uint32_t buffer_size = 1024, requested_buffer_size, i;
+    size_t max_message_size = 4096;
+    double sample_rate = 1.0;
+    double slow_threshold = 0.0;
+    FILE *file;
+
+    rb_scan_args(argc, argv, "11", &rb_path, &options);
+    rb_grn_scan_options(options,
+                        "format", &rb_format,
+                        "buffer_size", &rb_buffer_size,
+                        "max_message_size", &rb_max_message_size,
+                        "sample_rate", &rb_sample_rate,
+                        "slow_threshold", &rb_slow_threshold,
+                        "flush_interval", &rb_flush_interval,
+                        NULL);
+
+    if (!NIL_P(rb_format)) {
+        if (rb_grn_equal_option(rb_format, "text")) {
+            format = FORMAT_TEXT;
+        } else if (rb_grn_equal_option(rb_format, "json")) {
+            format = FORMAT_JSON;
+        } else if (rb_grn_equal_option(rb_format, "binary")) {
+            format = FORMAT_BINARY;
+        } else {
+            rb_raise(rb_eArgError,
+                     "format should be one of "
+                     "[:text, :json, :binary]: %s",
+                     rb_grn_inspect(rb_format));
+        }
+    }
+    if (!NIL_P(rb_buffer_size)) {
+        requested_buffer_size = NUM2UINT(rb_buffer_size);
+        if (requested_buffer_size == 0 || requested_buffer_size > (1U << 30)) {
+            rb_raise(rb_eArgError,
+                     "buffer size should be 1..%u: %u",
+                     1U << 30, requested_buffer_size);
+        }
+        buffer_size = 1;
+        while (buffer_size < requested_buffer_size) {
+            buffer_size <<= 1;
+        }
+    }
+    if (!NIL_P(rb_max_message_size))
+        max_message_size = NUM2UINT(rb_max_message_size);
+    if (!NIL_P(rb_sample_rate))
+        sample_rate = NUM2DBL(rb_sample_rate);
+    if (!NIL_P(rb_slow_threshold))
+        slow_threshold = NUM2DBL(rb_slow_threshold);
+    if (NIL_P(rb_flush_interval))
+        rb_flush_interval = rb_float_new(0.1);
+
+    SafeStringValue(rb_path);
+    file = fopen(StringValueCStr(rb_path), "ab");
+    if (!file)
+        rb_sys_fail(StringValueCStr(rb_path));
+
+    logger = ALLOC(RbGrnNativeQueryLogger);
+    memset(logger, 0, sizeof(RbGrnNativeQueryLogger));
+    DATA_PTR(self) = logger;
+
+    logger->path = ruby_strdup(StringValueCStr(rb_path));
+    logger->file = file;
+    logger->format = format;
+    logger->sample_rate = sample_rate;
+    logger->sample_accumulator = 0.0;
+    logger->slow_threshold = (uint64_t)(slow_threshold * 1000000000.0);
+    logger->buffer_size = buffer_size;
+    logger->max_message_size = max_message_size;
+    logger->slot_size = sizeof(Slot) + max_message_size;
+    logger->slot_size =
+        (logger->slot_size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+    logger->slots = malloc(logger->slot_size * buffer_size);
+    if (!logger->slots) {
+        rb_raise(rb_eNoMemError,
+                 "failed to allocate ring buffer for native query logger: "
+                 "<%u> events", buffer_size);
+    }
+    for (i = 0; i < buffer_size; i++) {
+        SLOT(logger, i)->sequence = i;
+    }
+
+    rb_iv_set(self, "@flush_interval", rb_flush_interval);
+    rb_iv_set(self, "@drain_thread", Qnil);
+    rb_iv_set(self, "@stop_requested", Qfalse);
+    rb_iv_set(self, "@last_error", Qnil);
+
+    return Qnil;
+}
+
+/*
+ * Writes buffered events to the file. It waits at most _timeout_
+ * seconds for an event. The GVL is released while it is waiting
+ * and writing.
+ *
+ * It is called by the drain thread that is started by
+ * {Groonga::QueryLogger.register}. You don't need to call it
+ * usually.
+ *
+ * @overload drain(timeout=0)
+ *   @param timeout [Numeric] The max seconds to wait for an event.
+ *   @return [Integer] The number of drained events.
+ */
+static VALUE
+rb_grn_native_query_logger_drain (int argc, VALUE *argv, VALUE self)
+{
+    RbGrnNativeQueryLogger *logger;
+    VALUE rb_timeout;
+    DrainData data;
+
+    rb_scan_args(argc, argv, "01", &rb_timeout);
+
+    logger = SELF(self);
+    if (logger->closed)
+        return INT2NUM(0);
+
+    data.logger = logger;
+    data.timeout = NIL_P(rb_timeout) ? 0.0 : NUM2DBL(rb_timeout);
+    data.n_events = 0;
+    logger->interrupted = GRN_FALSE;
+#ifdef HAVE_RB_THREAD_CALL_WITHOUT_GVL
+    rb_thread_call_without_gvl(rb_grn_native_query_logger_drain_body, &data,
+                               rb_grn_native_query_logger_drain_interrupt,
+                               logger);
+#else
+    rb_grn_native_query_logger_drain_body(&data);
+#endif
+
+    if (!logger->file && logger->open_errno != 0) {
+        int open_errno = logger->open_errno;
+
+        logger->open_errno = 0;
+        errno = open_errno;
+        rb_sys_fail(logger->path);
+    }
+
+    return LONG2NUM(data.n_events);
+}
+
+/*
+ * Writes all buffered events and closes the file. Events emitted
+ * after it is closed are ignored.
+ *
+ * Don't call it while {#drain} is running in another
+ * thread. {Groonga::QueryLogger.unregister} stops the drain thread
+ * and closes the registered logger.
+ *
+ * @overload close
+ *   @return [void]
+ */
+static VALUE
+rb_grn_native_query_logger_close (VALUE self)
+{
+    rb_grn_native_query_logger_close_raw(SELF(self));
+    return Qnil;
+}
+
+/*
+ * @overload closed?
+ *   @return [Boolean] +true+ if {#close} is called, +false+ otherwise.
+ */
+static VALUE
+rb_grn_native_query_logger_closed_p (VALUE self)
+{
+    return CBOOL2RVAL(SELF(self)->closed);
+}
+
+/*
+ * @overload n_dropped_events
+ *   @return [Integer] The number of events dropped because the
+ *     ring buffer was full.
+ */
+static VALUE
+rb_grn_native_query_logger_get_n_dropped_events (VALUE self)
+{
+    return UINT2NUM(SELF(self)->n_dropped_events);
+}
+
+/*
+ * @overload n_drained_events
+ *   @return [Integer] The number of events taken from the ring
+ *     buffer. It includes events that are filtered out by
+ *     +:sample_rate+ and +:slow_threshold+.
+ */
+static VALUE
+rb_grn_native_query_logger_get_n_drained_events (VALUE self)
+{
+    return ULL2NUM(SELF(self)->n_drained_events);
+}
+
+void
+rb_grn_init_native_query_logger (VALUE mGrn)
+{
+    rb_grn_native_query_logger.log    = rb_grn_native_query_logger_log;
+    rb_grn_native_query_logger.reopen = rb_grn_native_query_logger_reopen;
+    rb_grn_native_query_logger.fin    = rb_grn_native_query_logger_fin;
+    rb_grn_native_query_logger.user_data = NULL;
+
+    rb_cGrnNativeQueryLogger =
+        rb_define_class_under(mGrn, "NativeQueryLogger", rb_cObject);
+    rb_define_alloc_func(rb_cGrnNativeQueryLogger,
+                         rb_grn_native_query_logger_alloc);
+
+    rb_define_method(rb_cGrnNativeQueryLogger, "initialize",
+                     rb_grn_native_query_logger_initialize, -1);
+    rb_define_method(rb_cGrnNativeQueryLogger, "drain",
+                     rb_grn_native_query_logger_drain, -1);
+    rb_define_method(rb_cGrnNativeQueryLogger, "close",
+                     rb_grn_native_query_logger_close, 0);
+    rb_define_method(rb_cGrnNativeQueryLogger, "closed?",
+                     rb_grn_native_query_logger_closed_p, 0);
+    rb_define_method(rb_cGrnNativeQueryLogger, "n_dropped_events",
+                     rb_grn_native_query_logger_get_n_dropped_events, 0);
+    rb_define_method(rb_cGrnNativeQueryLogger, "n_drained_events",
+                     rb_grn_native_query_logger_get_n_drained_events, 0);
+}
@@ -1478,6 +1478,8 @@ rb_grn_object_remove (VALUE self)
         return Qnil;
 
     context = rb_grn_object->context;
+    /* The removed object can't be referred after it is removed. */
+    rb_grn_table_expire_column_caches(context, rb_grn_object->object);
     grn_obj_remove(context, rb_grn_object->object);
     rb_grn_context_check(context, self);
 
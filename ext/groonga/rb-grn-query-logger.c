@@ -36,6 +36,8 @@ static ID id_parse;
 static ID id_log;
 static ID id_reopen;
 static ID id_fin;
+static ID id_start;
+static ID id_stop;
 
 static grn_query_logger rb_grn_query_logger;
 
@@ -45,22 +47,48 @@ rb_grn_query_log_flags_to_ruby_object (unsigned int flags)
     return UINT2NUM(flags);
 }
 
+typedef struct _RbGrnQueryLoggerLogData RbGrnQueryLoggerLogData;
+struct _RbGrnQueryLoggerLogData
+{
+    VALUE handler;
+    unsigned int flag;
+    const char *timestamp;
+    const char *info;
+    const char *message;
+};
+
+static void *
+rb_grn_query_logger_log_body (void *user_data)
+{
+    RbGrnQueryLoggerLogData *data = user_data;
+
+    /* TODO: use rb_protect(). */
+    rb_funcall(data->handler, id_log, 4,
+               GRNQUERYLOGFLAGS2RVAL(data->flag),
+               rb_str_new2(data->timestamp),
+               rb_str_new2(data->info),
+               rb_str_new2(data->message));
+    return NULL;
+}
+
 static void
 rb_grn_query_logger_log (grn_ctx *ctx, unsigned int flag,
                          const char *timestamp, const char *info,
                          const char *message, void *user_data)
 {
     VALUE handler = (VALUE)user_data;
+    RbGrnQueryLoggerLogData data;
 
     if (NIL_P(handler))
         return;
 
-    /* TODO: use rb_protect(). */
-    rb_funcall(handler, id_log, 4,
-               GRNQUERYLOGFLAGS2RVAL(flag),
-               rb_str_new2(timestamp),
-               rb_str_new2(info),
-               rb_str_new2(message));
+    data.handler = handler;
+    data.flag = flag;
+    data.timestamp = timestamp;
+    data.info = info;
+    data.message = message;
+    /* ctx may be processing an operation without the GVL. */
+    rb_grn_context_call_with_gvl(ctx, rb_grn_query_logger_log_body, &data);
 }
 
 static void
@@ -87,6 +115,17 @@ rb_grn_query_logger_fin (grn_ctx *ctx, void *user_data)
     rb_funcall(handler, id_fin, 0);
 }
 
+static void
+rb_grn_query_logger_stop_native_logger (VALUE rb_logger, VALUE rb_new_logger)
+{
+    if (rb_logger == rb_new_logger)
+        return;
+    if (!RVAL2CBOOL(rb_obj_is_kind_of(rb_logger, rb_cGrnNativeQueryLogger)))
+        return;
+
+    rb_funcall(rb_logger, id_stop, 0);
+}
+
 /*
  * Registers a query logger or a callback that is called when a
  * query log event is emitted.
@@ -104,6 +143,17 @@ rb_grn_query_logger_fin (grn_ctx *ctx, void *user_data)
  *
  *   @return void
  *
+ * @overload register(native_logger, options={})
+ *   @param native_logger [Groonga::NativeQueryLogger] The native
+ *     query logger. Query log events are written without calling
+ *     Ruby. A thread that writes buffered events is started.
+ *
+ *   @!macro query-logger.register.options
+ *
+ *   @return void
+ *
+ *   @since 4.0.5
+ *
  * @overload register(options={})
  *   @yield [action, flag, timestamp, info, message]
  *     ...
@@ -167,12 +217,22 @@ rb_grn_query_logger_s_register (int argc, VALUE *argv, VALUE klass)
                            UINT2NUM(flags), rb_flags);
     }
 
-    rb_grn_query_logger.flags     = flags;
-    rb_grn_query_logger.user_data = (void *)rb_logger;
-
     context = rb_grn_context_ensure(&rb_context);
-    grn_query_logger_set(context, &rb_grn_query_logger);
+    if (RVAL2CBOOL(rb_obj_is_kind_of(rb_logger, rb_cGrnNativeQueryLogger))) {
+        grn_query_logger *native_logger;
+
+        native_logger =
+            rb_grn_native_query_logger_get_query_logger(rb_logger, flags);
+        rb_funcall(rb_logger, id_start, 0);
+        grn_query_logger_set(context, native_logger);
+    } else {
+        rb_grn_query_logger.flags     = flags;
+        rb_grn_query_logger.user_data = (void *)rb_logger;
+        grn_query_logger_set(context, &rb_grn_query_logger);
+    }
     rb_grn_context_check(context, rb_logger);
+    rb_grn_query_logger_stop_native_logger(rb_cv_get(klass, "@@current_logger"),
+                                           rb_logger);
     rb_cv_set(klass, "@@current_logger", rb_logger);
 
     return Qnil;
@@ -195,6 +255,8 @@ rb_grn_query_logger_s_unregister (VALUE klass)
     grn_query_logger_set(context, NULL);
     rb_grn_context_check(context, klass);
 
+    rb_grn_query_logger_stop_native_logger(current_logger, Qnil);
+
     return Qnil;
 }
 
@@ -295,6 +357,8 @@ rb_grn_init_query_logger (VALUE mGrn)
     id_log    = rb_intern("log");
     id_reopen = rb_intern("reopen");
     id_fin    = rb_intern("fin");
+    id_start  = rb_intern("start");
+    id_stop   = rb_intern("stop");
 
     rb_grn_query_logger.log    = rb_grn_query_logger_log;
     rb_grn_query_logger.reopen = rb_grn_query_logger_reopen;
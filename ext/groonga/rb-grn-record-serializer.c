@@ -0,0 +1,997 @@
+/* -*- coding: utf-8; mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+  Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License version 2.1 as published by the Free Software Foundation.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "rb-grn.h"
+
+static ID id_iso8601;
+static ID id_to_json;
+
+typedef enum {
+    SERIALIZE_FORMAT_ATTRIBUTES,
+    SERIALIZE_FORMAT_AS_JSON,
+    SERIALIZE_FORMAT_JSON
+} SerializeFormat;
+
+typedef struct {
+    grn_obj *object;
+    grn_bool need_to_unlink;
+    grn_obj *range;
+    grn_bool vector_p;
+    grn_bool key_p;
+    VALUE rb_name;
+} SerializeColumn;
+
+typedef struct _SerializeTable SerializeTable;
+struct _SerializeTable {
+    grn_obj *table;
+    SerializeColumn *columns;
+    int n_columns;
+    st_table *records;
+    SerializeTable *next;
+};
+
+typedef struct {
+    VALUE self;
+    grn_ctx *context;
+    grn_obj *table;
+    VALUE rb_records;
+    VALUE rb_column_names;
+    SerializeFormat format;
+    int max_depth;
+    grn_bool share_p;
+    grn_bool utf8_p;
+    SerializeTable *tables;
+    grn_bool *selected_columns;
+    grn_bool id_selected_p;
+    VALUE rb_names;
+    VALUE rb_id_name;
+    grn_obj buffer;
+    grn_table_cursor *cursor;
+    grn_obj *columns_table;
+    grn_table_cursor *columns_cursor;
+} SerializeData;
+
+typedef struct {
+    SerializeData *data;
+    SerializeColumn *column;
+    grn_id id;
+    int depth;
+    grn_obj value;
+} SerializeColumnData;
+
+static VALUE rb_grn_record_serializer_serialize_record (SerializeData *data,
+                                                        SerializeTable *table,
+                                                        grn_id id,
+                                                        int depth,
+                                                        grn_bool *selected_columns);
+
+static VALUE
+rb_grn_record_serializer_create_name (SerializeData *data,
+                                      const char *name, int name_size)
+{
+    VALUE rb_name;
+
+    rb_name = rb_grn_context_rb_string_new(data->context, name, name_size);
+    OBJ_FREEZE(rb_name);
+    rb_ary_push(data->rb_names, rb_name);
+    return rb_name;
+}
+
+static void
+rb_grn_record_serializer_add_column (SerializeData *data,
+                                     SerializeTable *table,
+                                     grn_obj *object,
+                                     grn_bool need_to_unlink,
+                                     grn_bool key_p)
+{
+    grn_ctx *context = data->context;
+    SerializeColumn *column;
+    char name[GRN_TABLE_MAX_KEY_SIZE];
+    int name_size;
+
+    column = &(table->columns[table->n_columns++]);
+    column->object = object;
+    column->need_to_unlink = need_to_unlink;
+    column->range = grn_ctx_at(context, grn_obj_get_range(context, object));
+    column->vector_p =
+        ((object->header.type == GRN_COLUMN_FIX_SIZE ||
+          object->header.type == GRN_COLUMN_VAR_SIZE) &&
+         (object->header.flags & GRN_OBJ_COLUMN_TYPE_MASK) ==
+         GRN_OBJ_COLUMN_VECTOR);
+    column->key_p = key_p;
+    name_size = grn_column_name(context, object, name, GRN_TABLE_MAX_KEY_SIZE);
+    column->rb_name = rb_grn_record_serializer_create_name(data,
+                                                           name, name_size);
+}
+
+static void
+rb_grn_record_serializer_add_accessor (SerializeData *data,
+                                       SerializeTable *table,
+                                       const char *name,
+                                       grn_bool key_p)
+{
+    grn_obj *accessor;
+
+    accessor = grn_obj_column(data->context, table->table,
+                              name, strlen(name));
+    if (!accessor)
+        return;
+    rb_grn_record_serializer_add_column(data, table, accessor, GRN_TRUE, key_p);
+}
+
+/*
+ * Resolves columns of _target_table_ once for each call. Pseudo
+ * columns are placed before real columns in the same order as
+ * {Groonga::Record#attributes} in the pure Ruby
+ * implementation. Index columns are ignored.
+ *
+ * The temporary columns table and its cursor are kept in _data_
+ * so that they are released by
+ * rb_grn_record_serializer_serialize_ensure() when an exception
+ * is raised.
+ */
+static SerializeTable *
+rb_grn_record_serializer_get_table (SerializeData *data,
+                                    grn_obj *target_table)
+{
+    grn_ctx *context = data->context;
+    SerializeTable *table;
+    int n_columns;
+
+    for (table = data->tables; table; table = table->next) {
+        if (table->table == target_table)
+            return table;
+    }
+
+    data->columns_table = grn_table_create(context, NULL, 0, NULL,
+                                           GRN_TABLE_HASH_KEY, NULL, 0);
+    rb_grn_context_check(context, data->self);
+    n_columns = grn_table_columns(context, target_table, NULL, 0,
+                                  data->columns_table);
+    rb_grn_context_check(context, data->self);
+
+    table = ALLOC(SerializeTable);
+    table->table = target_table;
+    table->columns = ALLOC_N(SerializeColumn, n_columns + 4);
+    table->n_columns = 0;
+    table->records = st_init_numtable();
+    table->next = data->tables;
+    data->tables = table;
+
+    switch (target_table->header.type) {
+      case GRN_TABLE_HASH_KEY:
+      case GRN_TABLE_PAT_KEY:
+      case GRN_TABLE_DAT_KEY:
+        rb_grn_record_serializer_add_accessor(data, table, "_key", GRN_TRUE);
+        break;
+      default:
+        break;
+    }
+    if (grn_obj_get_range(context, target_table) != GRN_ID_NIL)
+        rb_grn_record_serializer_add_accessor(data, table, "_value", GRN_FALSE);
+    rb_grn_record_serializer_add_accessor(data, table, "_score", GRN_FALSE);
+    if (grn_table_is_grouped(context, target_table))
+        rb_grn_record_serializer_add_accessor(data, table, "_nsubrecs",
+                                              GRN_FALSE);
+
+    if (n_columns > 0) {
+        grn_table_cursor *cursor;
+
+        data->columns_cursor = grn_table_cursor_open(context,
+                                                     data->columns_table,
+                                                     NULL, 0, NULL, 0,
+                                                     0, -1,
+                                                     GRN_CURSOR_ASCENDING);
+        cursor = data->columns_cursor;
+        while (cursor && grn_table_cursor_next(context, cursor) != GRN_ID_NIL) {
+            void *key;
+            grn_obj *column;
+
+            grn_table_cursor_get_key(context, cursor, &key);
+            column = grn_ctx_at(context, *((grn_id *)key));
+            if (!column || column->header.type == GRN_COLUMN_INDEX)
+                continue;
+            rb_grn_record_serializer_add_column(data, table, column,
+                                                GRN_FALSE, GRN_FALSE);
+        }
+        if (cursor) {
+            data->columns_cursor = NULL;
+            grn_table_cursor_close(context, cursor);
+        }
+    }
+    grn_obj_unlink(context, data->columns_table);
+    data->columns_table = NULL;
+
+    return table;
+}
+
+static void
+rb_grn_record_serializer_dump_string (SerializeData *data,
+                                      const char *raw_string,
+                                      unsigned int length)
+{
+    grn_ctx *context = data->context;
+    grn_obj *buffer = &(data->buffer);
+    const unsigned char *string = (const unsigned char *)raw_string;
+    unsigned int i;
+
+    GRN_TEXT_PUTC(context, buffer, '"');
+    for (i = 0; i < length;) {
+        unsigned char character = string[i];
+        int char_length;
+
+        if (character >= 0x80) {
+            char_length = rb_grn_utf8_char_length(string + i, length - i);
+            if (char_length == 0)
+                char_length = 1;
+            GRN_TEXT_PUT(context, buffer, string + i, char_length);
+            i += char_length;
+            continue;
+        }
+
+        switch (character) {
+          case '"':
+            GRN_TEXT_PUTS(context, buffer, "\\\"");
+            break;
+          case '\\':
+            GRN_TEXT_PUTS(context, buffer, "\\\\");
+            break;
+          case '\b':
+            GRN_TEXT_PUTS(context, buffer, "\\b");
+            break;
+          case '\f':
+            GRN_TEXT_PUTS(context, buffer, "\\f");
+            break;
+          case '\n':
+            GRN_TEXT_PUTS(context, buffer, "\\n");
+            break;
+          case '\r':
+            GRN_TEXT_PUTS(context, buffer, "\\r");
+            break;
+          case '\t':
+            GRN_TEXT_PUTS(context, buffer, "\\t");
+            break;
+          default:
+            if (character < 0x20) {
+                char escaped[sizeof("\\u0000")];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", character);
+                GRN_TEXT_PUTS(context, buffer, escaped);
+            } else {
+                GRN_TEXT_PUTC(context, buffer, character);
+            }
+            break;
+        }
+        i++;
+    }
+    GRN_TEXT_PUTC(context, buffer, '"');
+}
+
+static grn_bool
+rb_grn_record_serializer_valid_utf8_p (const char *raw_string,
+                                       unsigned int length)
+{
+    const unsigned char *string = (const unsigned char *)raw_string;
+    unsigned int i;
+
+    for (i = 0; i < length;) {
+        int char_length;
+
+        char_length = rb_grn_utf8_char_length(string + i, length - i);
+        if (char_length == 0)
+            return GRN_FALSE;
+        i += char_length;
+    }
+    return GRN_TRUE;
+}
+
+/*
+ * Writes scalar values that don't need Ruby objects. +Float+,
+ * +Time+, geo points and strings in non UTF-8 encoding are
+ * returned as +GRN_FALSE+. They are serialized by Ruby.
+ */
+static grn_bool
+rb_grn_record_serializer_dump_bulk (SerializeData *data,
+                                    const char *value, unsigned int size,
+                                    grn_id domain_id)
+{
+    grn_ctx *context = data->context;
+    grn_obj *buffer = &(data->buffer);
+
+    switch (domain_id) {
+      case GRN_DB_BOOL:
+        GRN_TEXT_PUTS(context, buffer, *((grn_bool *)value) ? "true" : "false");
+        return GRN_TRUE;
+      case GRN_DB_INT8:
+        grn_text_itoa(context, buffer, *((int8_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_UINT8:
+        grn_text_itoa(context, buffer, *((uint8_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_INT16:
+        grn_text_itoa(context, buffer, *((int16_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_UINT16:
+        grn_text_itoa(context, buffer, *((uint16_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_INT32:
+        grn_text_itoa(context, buffer, *((int32_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_UINT32:
+        grn_text_lltoa(context, buffer, *((uint32_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_INT64:
+        grn_text_lltoa(context, buffer, *((int64_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_UINT64:
+      {
+          char formatted[sizeof("18446744073709551615")];
+          snprintf(formatted, sizeof(formatted),
+                   "%llu", (unsigned long long)(*((uint64_t *)value)));
+          GRN_TEXT_PUTS(context, buffer, formatted);
+          return GRN_TRUE;
+      }
+      case GRN_DB_SHORT_TEXT:
+      case GRN_DB_TEXT:
+      case GRN_DB_LONG_TEXT:
+        if (!data->utf8_p)
+            return GRN_FALSE;
+        if (!rb_grn_record_serializer_valid_utf8_p(value, size))
+            return GRN_FALSE;
+        rb_grn_record_serializer_dump_string(data, value, size);
+        return GRN_TRUE;
+      default:
+        break;
+    }
+
+    return GRN_FALSE;
+}
+
+static VALUE
+rb_grn_record_serializer_serialize_bulk (SerializeData *data,
+                                         const char *value, unsigned int size,
+                                         grn_id domain_id, int depth)
+{
+    grn_ctx *context = data->context;
+    grn_obj *domain;
+    grn_obj bulk;
+    VALUE rb_value;
+
+    if (size == 0) {
+        if (data->format == SERIALIZE_FORMAT_JSON)
+            GRN_TEXT_PUTS(context, &(data->buffer), "null");
+        return Qnil;
+    }
+
+    if (data->format == SERIALIZE_FORMAT_JSON &&
+        rb_grn_record_serializer_dump_bulk(data, value, size, domain_id))
+        return Qnil;
+
+    domain = grn_ctx_at(context, domain_id);
+    if (domain) {
+        switch (domain->header.type) {
+          case GRN_TABLE_HASH_KEY:
+          case GRN_TABLE_PAT_KEY:
+          case GRN_TABLE_DAT_KEY:
+          case GRN_TABLE_NO_KEY:
+          {
+              grn_id id;
+              SerializeTable *table;
+
+              id = *((grn_id *)value);
+              if (id == GRN_ID_NIL) {
+                  if (data->format == SERIALIZE_FORMAT_JSON)
+                      GRN_TEXT_PUTS(context, &(data->buffer), "null");
+                  return Qnil;
+              }
+              table = rb_grn_record_serializer_get_table(data, domain);
+              return rb_grn_record_serializer_serialize_record(data, table, id,
+                                                               depth + 1,
+                                                               NULL);
+          }
+          default:
+            break;
+        }
+    }
+
+    GRN_OBJ_INIT(&bulk, GRN_BULK, GRN_OBJ_DO_SHALLOW_COPY, domain_id);
+    GRN_TEXT_SET(context, &bulk, value, size);
+    rb_value = GRNBULK2RVAL(context, &bulk, domain, data->self);
+    GRN_OBJ_FIN(context, &bulk);
+
+    if (data->format != SERIALIZE_FORMAT_ATTRIBUTES &&
+        RVAL2CBOOL(rb_obj_is_kind_of(rb_value, rb_cTime))) {
+        rb_value = rb_funcall(rb_value, id_iso8601, 0);
+    }
+
+    if (data->format == SERIALIZE_FORMAT_JSON) {
+        VALUE rb_json;
+
+        rb_json = rb_funcall(rb_value, id_to_json, 0);
+        GRN_TEXT_PUT(context, &(data->buffer),
+                     RSTRING_PTR(rb_json), RSTRING_LEN(rb_json));
+        return Qnil;
+    }
+
+    return rb_value;
+}
+
+static VALUE
+rb_grn_record_serializer_serialize_column_body (VALUE user_data)
+{
+    SerializeColumnData *column_data = (SerializeColumnData *)user_data;
+    SerializeData *data = column_data->data;
+    SerializeColumn *column = column_data->column;
+    int depth = column_data->depth;
+    grn_ctx *context = data->context;
+    grn_obj *buffer = &(data->buffer);
+    grn_bool json_p = (data->format == SERIALIZE_FORMAT_JSON);
+    grn_id range_id;
+    grn_obj *value = &(column_data->value);
+    VALUE rb_value = Qnil;
+
+    range_id = value->header.domain;
+    grn_obj_get_value(context, column->object, column_data->id, value);
+    rb_grn_context_check(context, data->self);
+
+    switch (value->header.type) {
+      case GRN_BULK:
+      {
+          grn_id domain_id = value->header.domain;
+
+          if (domain_id == GRN_ID_NIL)
+              domain_id = range_id;
+          rb_value =
+              rb_grn_record_serializer_serialize_bulk(data,
+                                                      GRN_BULK_HEAD(value),
+                                                      GRN_BULK_VSIZE(value),
+                                                      domain_id,
+                                                      depth);
+          break;
+      }
+      case GRN_UVECTOR:
+      {
+          unsigned int element_size, i, n;
+          const char *head;
+
+          switch (column->range->header.type) {
+            case GRN_TYPE:
+              element_size = grn_obj_get_range(context, column->range);
+              break;
+            default:
+              element_size = sizeof(grn_id);
+              break;
+          }
+          head = GRN_BULK_HEAD(value);
+          n = GRN_BULK_VSIZE(value) / element_size;
+          if (json_p) {
+              GRN_TEXT_PUTC(context, buffer, '[');
+          } else {
+              rb_value = rb_ary_new2(n);
+          }
+          for (i = 0; i < n; i++) {
+              VALUE rb_element;
+
+              if (json_p && i > 0)
+                  GRN_TEXT_PUTC(context, buffer, ',');
+              rb_element =
+                  rb_grn_record_serializer_serialize_bulk(data,
+                                                          head + element_size * i,
+                                                          element_size,
+                                                          range_id,
+                                                          depth);
+              if (!json_p)
+                  rb_ary_push(rb_value, rb_element);
+          }
+          if (json_p)
+              GRN_TEXT_PUTC(context, buffer, ']');
+          break;
+      }
+      case GRN_VECTOR:
+      {
+          unsigned int i, n;
+
+          n = grn_vector_size(context, value);
+          if (json_p) {
+              GRN_TEXT_PUTC(context, buffer, '[');
+          } else {
+              rb_value = rb_ary_new2(n);
+          }
+          for (i = 0; i < n; i++) {
+              const char *element;
+              unsigned int element_size;
+              grn_id domain_id;
+              VALUE rb_element;
+
+              element_size = grn_vector_get_element(context, value, i,
+                                                    &element, NULL,
+                                                    &domain_id);
+              if (json_p && i > 0)
+                  GRN_TEXT_PUTC(context, buffer, ',');
+              rb_element =
+                  rb_grn_record_serializer_serialize_bulk(data,
+                                                          element,
+                                                          element_size,
+                                                          domain_id,
+                                                          depth);
+              if (!json_p)
+                  rb_ary_push(rb_value, rb_element);
+          }
+          if (json_p)
+              GRN_TEXT_PUTC(context, buffer, ']');
+          break;
+      }
+      default:
+        if (json_p)
+            GRN_TEXT_PUTS(context, buffer, "null");
+        break;
+    }
+
+    return rb_value;
+}
+
+static VALUE
+rb_grn_record_serializer_serialize_column_ensure (VALUE user_data)
+{
+    SerializeColumnData *column_data = (SerializeColumnData *)user_data;
+
+    GRN_OBJ_FIN(column_data->data->context, &(column_data->value));
+    return Qnil;
+}
+
+/*
+ * Serializes the value of _column_ for the record _id_. The value
+ * buffer is released even when an exception is raised by
+ * serializing the value such as an exception from +to_json+.
+ */
+static VALUE
+rb_grn_record_serializer_serialize_column (SerializeData *data,
+                                           SerializeColumn *column,
+                                           grn_id id,
+                                           int depth)
+{
+    grn_ctx *context = data->context;
+    SerializeColumnData column_data;
+    grn_id range_id;
+
+    range_id = column->range ? grn_obj_id(context, column->range) : GRN_ID_NIL;
+    column_data.data = data;
+    column_data.column = column;
+    column_data.id = id;
+    column_data.depth = depth;
+    if (column->vector_p) {
+        GRN_OBJ_INIT(&(column_data.value), GRN_VECTOR, 0, range_id);
+    } else {
+        GRN_OBJ_INIT(&(column_data.value), GRN_BULK, 0, range_id);
+    }
+
+    return rb_ensure(rb_grn_record_serializer_serialize_column_body,
+                     (VALUE)&column_data,
+                     rb_grn_record_serializer_serialize_column_ensure,
+                     (VALUE)&column_data);
+}
+
+static void
+rb_grn_record_serializer_dump_member_name (SerializeData *data,
+                                           VALUE rb_name,
+                                           int n_members)
+{
+    grn_ctx *context = data->context;
+    grn_obj *buffer = &(data->buffer);
+
+    if (n_members > 0)
+        GRN_TEXT_PUTC(context, buffer, ',');
+    rb_grn_record_serializer_dump_string(data,
+                                         RSTRING_PTR(rb_name),
+                                         RSTRING_LEN(rb_name));
+    GRN_TEXT_PUTC(context, buffer, ':');
+}
+
+/*
+ * Serializes a record. References deeper than +max_depth+ and
+ * references to a record that is being serialized are serialized
+ * only with +_id+ and +_key+. When Hashes are shared, the same
+ * Hash is used for the same record like the pure Ruby
+ * implementation. It is also how a cycle is terminated.
+ */
+static VALUE
+rb_grn_record_serializer_serialize_record (SerializeData *data,
+                                           SerializeTable *table,
+                                           grn_id id,
+                                           int depth,
+                                           grn_bool *selected_columns)
+{
+    grn_ctx *context = data->context;
+    grn_bool json_p = (data->format == SERIALIZE_FORMAT_JSON);
+    grn_bool expand_p;
+    grn_bool visiting_p = GRN_FALSE;
+    st_data_t built_attributes;
+    VALUE rb_attributes = Qnil;
+    int i, n_members = 0;
+
+    expand_p = (data->max_depth < 0 || depth <= data->max_depth);
+    if (data->share_p) {
+        if (st_lookup(table->records, (st_data_t)id, &built_attributes))
+            return (VALUE)built_attributes;
+    } else if (expand_p) {
+        if (st_lookup(table->records, (st_data_t)id, NULL)) {
+            expand_p = GRN_FALSE;
+        } else {
+            st_insert(table->records, (st_data_t)id, (st_data_t)Qtrue);
+            visiting_p = GRN_TRUE;
+        }
+    }
+
+    if (json_p) {
+        GRN_TEXT_PUTC(context, &(data->buffer), '{');
+    } else {
+        rb_attributes = rb_hash_new();
+        if (data->share_p)
+            st_insert(table->records, (st_data_t)id, (st_data_t)rb_attributes);
+    }
+
+    if (!selected_columns || data->id_selected_p) {
+        if (json_p) {
+            rb_grn_record_serializer_dump_member_name(data, data->rb_id_name,
+                                                      n_members);
+            grn_text_lltoa(context, &(data->buffer), id);
+        } else {
+            rb_hash_aset(rb_attributes, data->rb_id_name, UINT2NUM(id));
+        }
+        n_members++;
+    }
+
+    for (i = 0; i < table->n_columns; i++) {
+        SerializeColumn *column = &(table->columns[i]);
+        VALUE rb_value;
+
+        if (selected_columns && !selected_columns[i])
+            continue;
+        if (!expand_p && !column->key_p)
+            continue;
+        if (json_p)
+            rb_grn_record_serializer_dump_member_name(data, column->rb_name,
+                                                      n_members);
+        rb_value = rb_grn_record_serializer_serialize_column(data, column, id,
+                                                             depth);
+        if (!json_p)
+            rb_hash_aset(rb_attributes, column->rb_name, rb_value);
+        n_members++;
+    }
+
+    if (json_p)
+        GRN_TEXT_PUTC(context, &(data->buffer), '}');
+    if (visiting_p) {
+        st_data_t key = (st_data_t)id;
+        st_delete(table->records, &key, NULL);
+    }
+
+    return rb_attributes;
+}
+
+static void
+rb_grn_record_serializer_select_columns (SerializeData *data,
+                                         SerializeTable *table)
+{
+    VALUE rb_column_names;
+    int i, j, n;
+
+    rb_column_names = rb_grn_convert_to_array(data->rb_column_names);
+    n = RARRAY_LEN(rb_column_names);
+    data->selected_columns = ALLOC_N(grn_bool, table->n_columns);
+    for (j = 0; j < table->n_columns; j++) {
+        data->selected_columns[j] = GRN_FALSE;
+    }
+    data->id_selected_p = GRN_FALSE;
+
+    for (i = 0; i < n; i++) {
+        VALUE rb_name = RARRAY_PTR(rb_column_names)[i];
+        const char *name;
+        long name_size;
+        grn_bool found = GRN_FALSE;
+
+        if (SYMBOL_P(rb_name))
+            rb_name = rb_id2str(SYM2ID(rb_name));
+        name = StringValuePtr(rb_name);
+        name_size = RSTRING_LEN(rb_name);
+
+        if (name_size == (long)strlen("_id") &&
+            memcmp(name, "_id", name_size) == 0) {
+            data->id_selected_p = GRN_TRUE;
+            continue;
+        }
+        for (j = 0; j < table->n_columns; j++) {
+            VALUE rb_column_name = table->columns[j].rb_name;
+            if (RSTRING_LEN(rb_column_name) == name_size &&
+                memcmp(RSTRING_PTR(rb_column_name), name, name_size) == 0) {
+                data->selected_columns[j] = GRN_TRUE;
+                found = GRN_TRUE;
+                break;
+            }
+        }
+        if (!found) {
+            rb_raise(rb_eGrnNoSuchColumn,
+                     "no such column: <%s>: <%s>",
+                     rb_grn_inspect(rb_name), rb_grn_inspect(data->self));
+        }
+    }
+}
+
+static void
+rb_grn_record_serializer_clear_records (SerializeData *data)
+{
+    SerializeTable *table;
+
+    if (!data->share_p)
+        return;
+    for (table = data->tables; table; table = table->next) {
+        st_clear(table->records);
+    }
+}
+
+static VALUE
+rb_grn_record_serializer_serialize_root (SerializeData *data,
+                                         SerializeTable *table,
+                                         grn_id id)
+{
+    VALUE rb_attributes;
+
+    rb_attributes =
+        rb_grn_record_serializer_serialize_record(data, table, id, 0,
+                                                  data->selected_columns);
+    rb_grn_record_serializer_clear_records(data);
+    return rb_attributes;
+}
+
+static VALUE
+rb_grn_record_serializer_serialize_body (VALUE user_data)
+{
+    SerializeData *data = (SerializeData *)user_data;
+    grn_ctx *context = data->context;
+    grn_obj *buffer = &(data->buffer);
+    grn_bool json_p = (data->format == SERIALIZE_FORMAT_JSON);
+    SerializeTable *table;
+    VALUE rb_result = Qnil;
+    int n_records = 0;
+
+    table = rb_grn_record_serializer_get_table(data, data->table);
+    if (!NIL_P(data->rb_column_names))
+        rb_grn_record_serializer_select_columns(data, table);
+
+    if (!NIL_P(data->rb_records) &&
+        NIL_P(rb_grn_check_convert_to_array(data->rb_records))) {
+        grn_id id;
+
+        id = RVAL2GRNID(data->rb_records, context, data->table, data->self);
+        rb_result = rb_grn_record_serializer_serialize_root(data, table, id);
+    } else {
+        if (json_p) {
+            GRN_TEXT_PUTC(context, buffer, '[');
+        } else {
+            rb_result = rb_ary_new();
+        }
+        if (NIL_P(data->rb_records)) {
+            grn_id id;
+
+            data->cursor = grn_table_cursor_open(context, data->table,
+                                                 NULL, 0, NULL, 0,
+                                                 0, -1, GRN_CURSOR_ASCENDING);
+            rb_grn_context_check(context, data->self);
+            while ((id = grn_table_cursor_next(context, data->cursor))) {
+                VALUE rb_attributes;
+
+                if (json_p && n_records > 0)
+                    GRN_TEXT_PUTC(context, buffer, ',');
+                rb_attributes =
+                    rb_grn_record_serializer_serialize_root(data, table, id);
+                if (!json_p)
+                    rb_ary_push(rb_result, rb_attributes);
+                n_records++;
+            }
+        } else {
+            VALUE rb_records;
+            int i, n;
+
+            rb_records = rb_grn_convert_to_array(data->rb_records);
+            n = RARRAY_LEN(rb_records);
+            for (i = 0; i < n; i++) {
+                grn_id id;
+                VALUE rb_attributes;
+
+                id = RVAL2GRNID(RARRAY_PTR(rb_records)[i],
+                                context, data->table, data->self);
+                if (json_p && n_records > 0)
+                    GRN_TEXT_PUTC(context, buffer, ',');
+                rb_attributes =
+                    rb_grn_record_serializer_serialize_root(data, table, id);
+                if (!json_p)
+                    rb_ary_push(rb_result, rb_attributes);
+                n_records++;
+            }
+        }
+        if (json_p)
+            GRN_TEXT_PUTC(context, buffer, ']');
+    }
+
+    if (json_p) {
+        rb_result = rb_grn_context_rb_string_new(context,
+                                                 GRN_TEXT_VALUE(buffer),
+                                                 GRN_TEXT_LEN(buffer));
+    }
+
+    return rb_result;
+}
+
+static VALUE
+rb_grn_record_serializer_serialize_ensure (VALUE user_data)
+{
+    SerializeData *data = (SerializeData *)user_data;
+    SerializeTable *table, *next_table;
+
+    for (table = data->tables; table; table = next_table) {
+        int i;
+
+        next_table = table->next;
+        for (i = 0; i < table->n_columns; i++) {
+            if (table->columns[i].need_to_unlink)
+                grn_obj_unlink(data->context, table->columns[i].object);
+        }
+        xfree(table->columns);
+        st_free_table(table->records);
+        xfree(table);
+    }
+    if (data->selected_columns)
+        xfree(data->selected_columns);
+    if (data->cursor)
+        grn_table_cursor_close(data->context, data->cursor);
+    if (data->columns_cursor)
+        grn_table_cursor_close(data->context, data->columns_cursor);
+    if (data->columns_table)
+        grn_obj_unlink(data->context, data->columns_table);
+    GRN_OBJ_FIN(data->context, &(data->buffer));
+
+    return Qnil;
+}
+
+/*
+ * Serializes records of _table_ in C. It is the implementation of
+ * {Groonga::Record#attributes}, {Groonga::Record#as_json} and
+ * {Groonga::Record#to_json}. Use it directly to serialize a page
+ * of search result in one call.
+ *
+ * Pseudo columns such as +_key+ and +_score+ and all columns
+ * except index columns are serialized. A reference is serialized
+ * as a nested attributes of the referenced record.
+ *
+ * @example Serialize a page as JSON
+ *   page = entries.select {|record| record.content =~ "groonga"}
+ *   page = page.sort(["_score"], :limit => 10)
+ *   page.serialize_records(nil, :format => :json)
+ *   # => "[{\"_id\":1,\"_value\":{\"_id\":3,...}},...]"
+ *
+ * @overload serialize_records(records=nil, options={})
+ *   @param records [Integer, Groonga::Record, ::Array, nil] The
+ *     records to be serialized. They should be IDs or records of
+ *     _table_. If it is +nil+, all records of _table_ are
+ *     serialized in ID order. For a sorted table, it is the sorted
+ *     order.
+ *   @param options [::Hash] The name and value pairs.
+ *     Omitted names are initialized as the default value.
+ *   @option options :format (:attributes)
+ *     The format. +:attributes+ returns Hashes like
+ *     {Groonga::Record#attributes}. The same Hash is used for the
+ *     same referenced record and cycled references are terminated
+ *     by it. +:as_json+ is the same as +:attributes+ but +Time+
+ *     values are formatted by +Time#iso8601+. +:json+ returns a
+ *     JSON String of +:as_json+ result. Hashes aren't shared in
+ *     JSON. So a reference to a record that is being serialized
+ *     is serialized only with +_id+ and +_key+.
+ *   @option options [::Array<String>] :columns (nil)
+ *     The names of the columns to be serialized. +"_id"+ and
+ *     pseudo columns such as +"_key"+ can be included. It is
+ *     applied only to _records_, not referenced records. All
+ *     columns are serialized if it is +nil+.
+ *   @option options [Integer] :max_depth (nil)
+ *     The max depth of references to be serialized. Referenced
+ *     records deeper than it are serialized only with +_id+ and
+ *     +_key+. For example, +0+ doesn't serialize columns of
+ *     referenced records. Hashes aren't shared with it. So a
+ *     reference to a record that is being serialized is also
+ *     serialized only with +_id+ and +_key+. It is also applied
+ *     to +:json+ format. There is no limit if it is +nil+.
+ *   @return [::Hash, ::Array<::Hash>, String] The attributes of
+ *     the record if _records_ is an ID or a record. An Array of
+ *     them otherwise. A JSON String of them with +:json+ format.
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_record_serializer_serialize_records (int argc, VALUE *argv, VALUE self)
+{
+    SerializeData data;
+    VALUE rb_records, rb_options, rb_format, rb_columns, rb_max_depth;
+    VALUE rb_result;
+
+    rb_scan_args(argc, argv, "02", &rb_records, &rb_options);
+    rb_grn_scan_options(rb_options,
+                        "format", &rb_format,
+                        "columns", &rb_columns,
+                        "max_depth", &rb_max_depth,
+                        NULL);
+
+    data.self = self;
+    data.context = NULL;
+    data.table = RVAL2GRNOBJECT(self, &(data.context));
+    data.rb_records = rb_records;
+    data.rb_column_names = rb_columns;
+
+    if (NIL_P(rb_format) || rb_grn_equal_option(rb_format, "attributes")) {
+        data.format = SERIALIZE_FORMAT_ATTRIBUTES;
+    } else if (rb_grn_equal_option(rb_format, "as_json")) {
+        data.format = SERIALIZE_FORMAT_AS_JSON;
+    } else if (rb_grn_equal_option(rb_format, "json")) {
+        data.format = SERIALIZE_FORMAT_JSON;
+    } else {
+        rb_raise(rb_eArgError,
+                 "format should be one of "
+                 "[:attributes, :as_json, :json]: <%s>",
+                 rb_grn_inspect(rb_format));
+    }
+
+    if (NIL_P(rb_max_depth)) {
+        data.max_depth = -1;
+    } else {
+        data.max_depth = NUM2INT(rb_max_depth);
+        if (data.max_depth < 0) {
+            rb_raise(rb_eArgError,
+                     "max depth should be zero or positive: <%s>",
+                     rb_grn_inspect(rb_max_depth));
+        }
+    }
+    data.share_p = (data.format != SERIALIZE_FORMAT_JSON &&
+                    data.max_depth < 0);
+    data.utf8_p = (data.context->encoding == GRN_ENC_UTF8);
+    data.tables = NULL;
+    data.selected_columns = NULL;
+    data.id_selected_p = GRN_FALSE;
+    data.rb_names = rb_ary_new();
+    data.rb_id_name = rb_grn_record_serializer_create_name(&data, "_id",
+                                                           strlen("_id"));
+    data.cursor = NULL;
+    data.columns_table = NULL;
+    data.columns_cursor = NULL;
+    GRN_TEXT_INIT(&(data.buffer), 0);
+
+    rb_result = rb_ensure(rb_grn_record_serializer_serialize_body,
+                          (VALUE)&data,
+                          rb_grn_record_serializer_serialize_ensure,
+                          (VALUE)&data);
+
+    RB_GC_GUARD(data.rb_names);
+
+    return rb_result;
+}
+
+void
+rb_grn_init_record_serializer (VALUE mGrn)
+{
+    id_iso8601 = rb_intern("iso8601");
+    id_to_json = rb_intern("to_json");
+
+    rb_define_method(rb_cGrnTable, "serialize_records",
+                     rb_grn_record_serializer_serialize_records, -1);
+}
@@ -20,6 +20,16 @@
 
 VALUE rb_cGrnRecord;
 
+static ID id_at_id;
+static ID id_at_key;
+static ID id_at_added;
+static ID id_at_table;
+static ID id_at_column_names;
+static ID id_new;
+static ID id_added_set;
+static ID id_array_reference;
+static ID id_array_set;
+
 VALUE
 rb_grn_record_new (VALUE table, grn_id id, VALUE values)
 {
@@ -32,19 +42,124 @@ rb_grn_record_new_added (VALUE table, grn_id id, VALUE values)
     VALUE record;
 
     record = rb_grn_record_new(table, id, values);
-    rb_funcall(record, rb_intern("added="), 1, Qtrue);
+    rb_funcall(record, id_added_set, 1, Qtrue);
     return record;
 }
 
 VALUE
 rb_grn_record_new_raw (VALUE table, VALUE rb_id, VALUE values)
 {
-    return rb_funcall(rb_cGrnRecord, rb_intern("new"), 3,
-                      table, rb_id, values);
+    VALUE klass = rb_cGrnRecord;
+
+    if (RVAL2CBOOL(rb_obj_is_kind_of(table, rb_cGrnTable)))
+        klass = rb_grn_table_get_record_class(table);
+    return rb_funcall(klass, id_new, 3, table, rb_id, values);
+}
+
+VALUE
+rb_grn_record_reuse (VALUE record, grn_id id)
+{
+    rb_ivar_set(record, id_at_id, UINT2NUM(id));
+    rb_ivar_set(record, id_at_key, Qnil);
+    rb_ivar_set(record, id_at_added, Qfalse);
+    return record;
+}
+
+static VALUE
+rb_grn_record_resolve_attribute_column (VALUE self)
+{
+    VALUE rb_column_names;
+    VALUE rb_column_name;
+    VALUE rb_column;
+
+    rb_column_names = rb_ivar_get(rb_obj_class(self), id_at_column_names);
+    rb_column_name = rb_hash_aref(rb_column_names,
+                                  ID2SYM(rb_frame_this_func()));
+    rb_column = rb_grn_table_get_column(rb_ivar_get(self, id_at_table),
+                                        rb_column_name);
+    if (NIL_P(rb_column)) {
+        rb_raise(rb_eGrnNoSuchColumn,
+                 "no such column: <%s>: <%s>",
+                 rb_grn_inspect(rb_column_name),
+                 rb_grn_inspect(rb_ivar_get(self, id_at_table)));
+    }
+    return rb_column;
+}
+
+static VALUE
+rb_grn_record_read_attribute (VALUE self)
+{
+    return rb_funcall(rb_grn_record_resolve_attribute_column(self),
+                      id_array_reference, 1,
+                      rb_ivar_get(self, id_at_id));
+}
+
+static VALUE
+rb_grn_record_write_attribute (VALUE self, VALUE rb_value)
+{
+    return rb_funcall(rb_grn_record_resolve_attribute_column(self),
+                      id_array_set, 2,
+                      rb_ivar_get(self, id_at_id), rb_value);
+}
+
+/*
+ * @private
+ *
+ * Defines _name_ and _name_= methods that read and write the value
+ * of column _name_ of the record. The column is resolved by the
+ * column cache of the table of the record.
+ *
+ * It is used by {Groonga::Record.class_for}.
+ *
+ * @overload define_column_accessor(name)
+ *   @param name [String] The column name.
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_record_s_define_column_accessor (VALUE klass, VALUE rb_name)
+{
+    VALUE rb_column_names;
+    VALUE rb_column_name;
+    VALUE rb_writer_name;
+
+    if (RTEST(rb_ivar_defined(klass, id_at_column_names))) {
+        rb_column_names = rb_ivar_get(klass, id_at_column_names);
+    } else {
+        rb_column_names = rb_hash_new();
+        rb_ivar_set(klass, id_at_column_names, rb_column_names);
+    }
+
+    rb_name = rb_obj_as_string(rb_name);
+    rb_column_name = rb_str_intern(rb_name);
+    rb_writer_name = rb_str_plus(rb_name, rb_str_new_cstr("="));
+
+    rb_hash_aset(rb_column_names, rb_column_name, rb_column_name);
+    rb_hash_aset(rb_column_names, rb_str_intern(rb_writer_name),
+                 rb_column_name);
+    rb_define_method(klass, StringValueCStr(rb_name),
+                     rb_grn_record_read_attribute, 0);
+    rb_define_method(klass, StringValueCStr(rb_writer_name),
+                     rb_grn_record_write_attribute, 1);
+
+    return Qnil;
 }
 
 void
 rb_grn_init_record (VALUE mGrn)
 {
+    id_at_id = rb_intern("@id");
+    id_at_key = rb_intern("@key");
+    id_at_added = rb_intern("@added");
+    id_at_table = rb_intern("@table");
+    id_at_column_names = rb_intern("@column_names");
+    id_new = rb_intern("new");
+    id_added_set = rb_intern("added=");
+    id_array_reference = rb_intern("[]");
+    id_array_set = rb_intern("[]=");
+
     rb_cGrnRecord = rb_const_get(mGrn, rb_intern("Record"));
+
+    rb_define_singleton_method(rb_cGrnRecord, "define_column_accessor",
+                               rb_grn_record_s_define_column_accessor, 1);
 }
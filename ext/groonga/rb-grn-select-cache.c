@@ -0,0 +1,318 @@
+/* -*- coding: utf-8; mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+  Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License version 2.1 as published by the Free Software Foundation.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "rb-grn.h"
+
+#include <time.h>
+
+/*
+ * The LRU cache of Groonga::Table#select results. An entry has
+ * record IDs and scores of a result table. Entries are ordered
+ * from the newest used entry to the oldest used entry. The oldest
+ * entry is evicted when the cache is full.
+ *
+ * An entry is expired when the last modified time of the
+ * database is changed. The last modified time is in seconds. So
+ * a result isn't stored when the database is modified in the
+ * current second. A modification after the result is stored
+ * always changes the last modified time.
+ */
+
+struct _RbGrnSelectCacheEntry
+{
+    RbGrnSelectCacheEntry *newer;
+    RbGrnSelectCacheEntry *older;
+    grn_id id;
+    uint32_t last_modified;
+    unsigned int n_records;
+    grn_id *record_ids;
+    int *scores;
+};
+
+static grn_bool
+rb_grn_select_cache_get_last_modified (grn_ctx *context,
+                                       uint32_t *last_modified)
+{
+#ifdef HAVE_GRN_DB_GET_LAST_MODIFIED
+    grn_obj *database;
+
+    database = grn_ctx_db(context);
+    if (!database)
+        return GRN_FALSE;
+    *last_modified = grn_db_get_last_modified(context, database);
+    return GRN_TRUE;
+#else
+    return GRN_FALSE;
+#endif
+}
+
+static void
+rb_grn_select_cache_unlink_entry (RbGrnSelectCache *cache,
+                                  RbGrnSelectCacheEntry *entry)
+{
+    if (entry->newer) {
+        entry->newer->older = entry->older;
+    } else {
+        cache->newest = entry->older;
+    }
+    if (entry->older) {
+        entry->older->newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+    entry->newer = NULL;
+    entry->older = NULL;
+}
+
+static void
+rb_grn_select_cache_push_entry (RbGrnSelectCache *cache,
+                                RbGrnSelectCacheEntry *entry)
+{
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if (cache->newest) {
+        cache->newest->newer = entry;
+    } else {
+        cache->oldest = entry;
+    }
+    cache->newest = entry;
+}
+
+static void
+rb_grn_select_cache_free_entry (grn_ctx *context,
+                                RbGrnSelectCache *cache,
+                                RbGrnSelectCacheEntry *entry)
+{
+    rb_grn_select_cache_unlink_entry(cache, entry);
+    grn_hash_delete_by_id(context, cache->entries, entry->id, NULL);
+    cache->size--;
+    xfree(entry->record_ids);
+    xfree(entry->scores);
+    xfree(entry);
+}
+
+static void
+rb_grn_select_cache_evict (grn_ctx *context,
+                           RbGrnSelectCache *cache,
+                           unsigned int max_size)
+{
+    while (cache->size > max_size && cache->oldest) {
+        rb_grn_select_cache_free_entry(context, cache, cache->oldest);
+        cache->n_evictions++;
+    }
+}
+
+RbGrnSelectCache *
+rb_grn_select_cache_new (grn_ctx *context, unsigned int max_size)
+{
+    RbGrnSelectCache *cache;
+
+    cache = ALLOC(RbGrnSelectCache);
+    cache->entries = grn_hash_create(context, NULL,
+                                     GRN_TABLE_MAX_KEY_SIZE,
+                                     sizeof(RbGrnSelectCacheEntry *),
+                                     GRN_OBJ_KEY_VAR_SIZE);
+    if (!cache->entries) {
+        xfree(cache);
+        rb_grn_context_check(context, Qnil);
+        rb_raise(rb_eGrnNoMemoryAvailable,
+                 "failed to create select cache");
+    }
+    cache->newest = NULL;
+    cache->oldest = NULL;
+    cache->size = 0;
+    cache->max_size = max_size;
+    cache->n_hits = 0;
+    cache->n_misses = 0;
+    cache->n_evictions = 0;
+
+    return cache;
+}
+
+void
+rb_grn_select_cache_free (grn_ctx *context, RbGrnSelectCache *cache)
+{
+    if (!cache)
+        return;
+
+    rb_grn_select_cache_clear(context, cache);
+    grn_hash_close(context, cache->entries);
+    xfree(cache);
+}
+
+void
+rb_grn_select_cache_set_max_size (grn_ctx *context,
+                                  RbGrnSelectCache *cache,
+                                  unsigned int max_size)
+{
+    cache->max_size = max_size;
+    rb_grn_select_cache_evict(context, cache, max_size);
+}
+
+void
+rb_grn_select_cache_clear (grn_ctx *context, RbGrnSelectCache *cache)
+{
+    while (cache->oldest) {
+        rb_grn_select_cache_free_entry(context, cache, cache->oldest);
+    }
+}
+
+/*
+ * Adds records in the cached result to _result_. _result_ must
+ * be an empty result table of Groonga::Table#select.
+ */
+grn_bool
+rb_grn_select_cache_fetch (grn_ctx *context,
+                           RbGrnSelectCache *cache,
+                           const char *key,
+                           unsigned int key_size,
+                           grn_obj *result)
+{
+    RbGrnSelectCacheEntry *entry;
+    void *value;
+    grn_id id;
+    uint32_t last_modified;
+    grn_obj *score_column;
+    grn_obj score;
+    unsigned int i;
+
+    if (key_size > GRN_TABLE_MAX_KEY_SIZE)
+        return GRN_FALSE;
+
+    id = grn_hash_get(context, cache->entries, key, key_size, &value);
+    if (id == GRN_ID_NIL) {
+        cache->n_misses++;
+        return GRN_FALSE;
+    }
+
+    entry = *((RbGrnSelectCacheEntry **)value);
+    if (!rb_grn_select_cache_get_last_modified(context, &last_modified) ||
+        entry->last_modified != last_modified) {
+        rb_grn_select_cache_free_entry(context, cache, entry);
+        cache->n_misses++;
+        return GRN_FALSE;
+    }
+
+    score_column = grn_obj_column(context, result, "_score", strlen("_score"));
+    GRN_INT32_INIT(&score, 0);
+    for (i = 0; i < entry->n_records; i++) {
+        grn_id result_id;
+
+        result_id = grn_table_add(context, result,
+                                  &(entry->record_ids[i]), sizeof(grn_id),
+                                  NULL);
+        if (result_id == GRN_ID_NIL)
+            continue;
+        GRN_INT32_SET(context, &score, entry->scores[i]);
+        grn_obj_set_value(context, score_column, result_id, &score,
+                          GRN_OBJ_SET);
+    }
+    GRN_OBJ_FIN(context, &score);
+    grn_obj_unlink(context, score_column);
+
+    rb_grn_select_cache_unlink_entry(cache, entry);
+    rb_grn_select_cache_push_entry(cache, entry);
+    cache->n_hits++;
+
+    return GRN_TRUE;
+}
+
+/*
+ * Stores record IDs and scores in _result_ that is a result table
+ * of Groonga::Table#select.
+ */
+void
+rb_grn_select_cache_store (grn_ctx *context,
+                           RbGrnSelectCache *cache,
+                           const char *key,
+                           unsigned int key_size,
+                           grn_obj *result)
+{
+    RbGrnSelectCacheEntry *entry;
+    void *value;
+    int added = 0;
+    uint32_t last_modified;
+    grn_table_cursor *cursor;
+    grn_obj *score_column;
+    grn_obj score;
+    grn_id result_id;
+    unsigned int i, n_records;
+
+    if (cache->max_size == 0)
+        return;
+    if (key_size > GRN_TABLE_MAX_KEY_SIZE)
+        return;
+    if (!rb_grn_select_cache_get_last_modified(context, &last_modified))
+        return;
+    if ((uint32_t)time(NULL) <= last_modified)
+        return;
+
+    cursor = grn_table_cursor_open(context, result,
+                                   NULL, 0, NULL, 0,
+                                   0, -1, GRN_CURSOR_ASCENDING);
+    if (!cursor)
+        return;
+
+    n_records = grn_table_size(context, result);
+    entry = ALLOC(RbGrnSelectCacheEntry);
+    entry->newer = NULL;
+    entry->older = NULL;
+    entry->last_modified = last_modified;
+    entry->record_ids = ALLOC_N(grn_id, n_records);
+    entry->scores = ALLOC_N(int, n_records);
+
+    score_column = grn_obj_column(context, result, "_score", strlen("_score"));
+    GRN_INT32_INIT(&score, 0);
+    i = 0;
+    while (i < n_records &&
+           (result_id = grn_table_cursor_next(context, cursor)) != GRN_ID_NIL) {
+        grn_table_get_key(context, result, result_id,
+                          &(entry->record_ids[i]), sizeof(grn_id));
+        GRN_BULK_REWIND(&score);
+        grn_obj_get_value(context, score_column, result_id, &score);
+        entry->scores[i] = GRN_INT32_VALUE(&score);
+        i++;
+    }
+    entry->n_records = i;
+    GRN_OBJ_FIN(context, &score);
+    grn_obj_unlink(context, score_column);
+    grn_table_cursor_close(context, cursor);
+
+    entry->id = grn_hash_add(context, cache->entries, key, key_size,
+                             &value, &added);
+    if (entry->id == GRN_ID_NIL) {
+        xfree(entry->record_ids);
+        xfree(entry->scores);
+        xfree(entry);
+        return;
+    }
+    if (!added) {
+        RbGrnSelectCacheEntry *old_entry;
+
+        old_entry = *((RbGrnSelectCacheEntry **)value);
+        rb_grn_select_cache_unlink_entry(cache, old_entry);
+        cache->size--;
+        xfree(old_entry->record_ids);
+        xfree(old_entry->scores);
+        xfree(old_entry);
+    }
+    *((RbGrnSelectCacheEntry **)value) = entry;
+    rb_grn_select_cache_push_entry(cache, entry);
+    cache->size++;
+    rb_grn_select_cache_evict(context, cache, cache->max_size);
+}
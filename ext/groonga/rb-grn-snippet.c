@@ -266,6 +266,248 @@ rb_grn_snippet_execute (VALUE self, VALUE rb_string)
     return rb_results;
 }
 
+typedef struct _ExecuteBatchData ExecuteBatchData;
+struct _ExecuteBatchData
+{
+    grn_ctx *context;
+    grn_obj *snippet;
+    grn_obj *column;
+    const grn_id *ids;
+    long n_ids;
+    grn_obj text;
+    grn_obj results;
+    grn_obj lengths;
+    grn_rc rc;
+};
+
+static VALUE
+rb_grn_snippet_collect_ids (grn_ctx *context, VALUE rb_ids, VALUE self)
+{
+    VALUE rb_packed_ids;
+
+    if (TYPE(rb_ids) == T_STRING) {
+        if (RSTRING_LEN(rb_ids) % sizeof(grn_id) != 0) {
+            rb_raise(rb_eArgError,
+                     "packed IDs size should be a multiple of %u: <%ld>: <%s>",
+                     (unsigned int)sizeof(grn_id),
+                     RSTRING_LEN(rb_ids),
+                     rb_grn_inspect(self));
+        }
+        /* Copy IDs because the String may be changed by other
+           threads while the GVL is released. */
+        return rb_str_new(RSTRING_PTR(rb_ids), RSTRING_LEN(rb_ids));
+    }
+
+    if (RVAL2CBOOL(rb_obj_is_kind_of(rb_ids, rb_cGrnTable))) {
+        grn_obj *table;
+        grn_table_cursor *cursor;
+        grn_id id;
+
+        table = RVAL2GRNTABLE(rb_ids, &context);
+        rb_packed_ids =
+            rb_str_buf_new(sizeof(grn_id) * grn_table_size(context, table));
+        cursor = grn_table_cursor_open(context, table,
+                                       NULL, 0, NULL, 0,
+                                       0, -1, GRN_CURSOR_ASCENDING);
+        rb_grn_context_check(context, rb_ids);
+        while ((id = grn_table_cursor_next(context, cursor)) != GRN_ID_NIL) {
+            rb_str_cat(rb_packed_ids, (const char *)&id, sizeof(grn_id));
+        }
+        grn_table_cursor_close(context, cursor);
+    } else {
+        VALUE *rb_id_values;
+        long i, n_ids;
+
+        rb_ids = rb_Array(rb_ids);
+        n_ids = RARRAY_LEN(rb_ids);
+        rb_id_values = RARRAY_PTR(rb_ids);
+        rb_packed_ids = rb_str_buf_new(sizeof(grn_id) * n_ids);
+        for (i = 0; i < n_ids; i++) {
+            grn_id id;
+
+            id = RVAL2GRNID(rb_id_values[i], context, NULL, self);
+            rb_str_cat(rb_packed_ids, (const char *)&id, sizeof(grn_id));
+        }
+    }
+
+    return rb_packed_ids;
+}
+
+static void *
+rb_grn_snippet_execute_batch_body (void *user_data)
+{
+    ExecuteBatchData *data = user_data;
+    grn_ctx *context = data->context;
+    long i;
+
+    for (i = 0; i < data->n_ids; i++) {
+        unsigned int j, n_results = 0, max_tagged_length = 0;
+
+        if (context->rc != GRN_SUCCESS)
+            break;
+
+        GRN_BULK_REWIND(&(data->text));
+        grn_obj_get_value(context, data->column, data->ids[i], &(data->text));
+        if (GRN_TEXT_LEN(&(data->text)) > 0) {
+            data->rc = grn_snip_exec(context, data->snippet,
+                                     GRN_TEXT_VALUE(&(data->text)),
+                                     GRN_TEXT_LEN(&(data->text)),
+                                     &n_results, &max_tagged_length);
+            if (data->rc != GRN_SUCCESS)
+                break;
+        }
+
+        GRN_UINT32_PUT(context, &(data->lengths), n_results);
+        for (j = 0; j < n_results; j++) {
+            unsigned int result_length;
+
+            data->rc = grn_bulk_reserve(context, &(data->results),
+                                        max_tagged_length);
+            if (data->rc != GRN_SUCCESS)
+                return NULL;
+            data->rc = grn_snip_get_result(context, data->snippet, j,
+                                           GRN_BULK_CURR(&(data->results)),
+                                           &result_length);
+            if (data->rc != GRN_SUCCESS)
+                return NULL;
+            GRN_BULK_INCR_LEN(&(data->results), result_length);
+            GRN_UINT32_PUT(context, &(data->lengths), result_length);
+        }
+    }
+
+    return NULL;
+}
+
+static VALUE
+rb_grn_snippet_execute_batch_build_results (ExecuteBatchData *data)
+{
+    VALUE rb_results;
+    const char *result;
+    const uint32_t *lengths, *lengths_end;
+
+    rb_results = rb_ary_new2(data->n_ids);
+    result = GRN_TEXT_VALUE(&(data->results));
+    lengths = (const uint32_t *)GRN_BULK_HEAD(&(data->lengths));
+    lengths_end = (const uint32_t *)GRN_BULK_CURR(&(data->lengths));
+    while (lengths < lengths_end) {
+        VALUE rb_snippets;
+        uint32_t i, n_results;
+
+        n_results = *lengths++;
+        rb_snippets = rb_ary_new2(n_results);
+        for (i = 0; i < n_results; i++) {
+            uint32_t result_length = *lengths++;
+
+            rb_ary_push(rb_snippets,
+                        rb_grn_context_rb_string_new(data->context,
+                                                     result,
+                                                     result_length));
+            result += result_length;
+        }
+        rb_ary_push(rb_results, rb_snippets);
+    }
+
+    return rb_results;
+}
+
+/*
+ * Creates snippets of text values of records in a batch. Text
+ * values are read from _column_ in C. It is faster than calling
+ * {#execute} with text values read in Ruby for each record.
+ *
+ * @example Create snippets of search result
+ *   expression = Groonga::Expression.new
+ *   expression.parse("groonga")
+ *   snippet = expression.snippet(["<em>", "</em>"])
+ *   records = entries.select {|record| record.content =~ "groonga"}
+ *   snippet.execute_batch(entries.column("content"),
+ *                         records.collect(&:key))
+ *     # => [["<em>groonga</em> is ..."], ...]
+ *
+ * @overload execute_batch(column, ids, options={})
+ *   @param column [Groonga::Column, Groonga::Accessor] The text
+ *     column that has text values.
+ *   @param ids [::Array<Integer, Groonga::Record>, String, Groonga::Table]
+ *     The records. It is an Array of IDs or records, a String
+ *     that packs IDs like {Groonga::Table#each_id_slice} or a
+ *     table. All records in the table are used in ID order if it
+ *     is a table.
+ *   @param options [::Hash] The name and value
+ *     pairs. Omitted names are initialized as the default value.
+ *   @option options :release_gvl (nil)
+ *     Whether the GVL is released while snippets are created. If
+ *     it is +nil+, {Groonga::Context#release_gvl?} is used.
+ *   @return [::Array<::Array<String>>] Snippets of each record in
+ *     the same order as _ids_.
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_snippet_execute_batch (int argc, VALUE *argv, VALUE self)
+{
+    ExecuteBatchData data;
+    grn_ctx *context;
+    grn_obj *snippet, *column, *range;
+    grn_id range_id;
+    VALUE rb_column, rb_ids, options, rb_release_gvl;
+    VALUE rb_packed_ids, rb_results = Qnil;
+
+    rb_grn_snippet_deconstruct(SELF(self), &snippet, &context);
+
+    rb_scan_args(argc, argv, "21", &rb_column, &rb_ids, &options);
+
+    rb_grn_scan_options(options,
+                        "release_gvl", &rb_release_gvl,
+                        NULL);
+
+    column = RVAL2GRNOBJECT(rb_column, &context);
+    range_id = grn_obj_get_range(context, column);
+    range = grn_ctx_at(context, range_id);
+    if (!(GRN_DB_SHORT_TEXT <= range_id && range_id <= GRN_DB_LONG_TEXT) ||
+        (column->header.type == GRN_COLUMN_VAR_SIZE &&
+         (column->header.flags & GRN_OBJ_COLUMN_TYPE_MASK) ==
+         GRN_OBJ_COLUMN_VECTOR)) {
+        rb_raise(rb_eArgError,
+                 "snippet column should be a scalar text column: <%s>: <%s>",
+                 rb_grn_inspect(rb_column),
+                 rb_grn_inspect(GRNOBJECT2RVAL(Qnil, context, range,
+                                               GRN_FALSE)));
+    }
+
+    rb_packed_ids = rb_grn_snippet_collect_ids(context, rb_ids, self);
+
+    data.context = context;
+    data.snippet = snippet;
+    data.column = column;
+    data.ids = (const grn_id *)RSTRING_PTR(rb_packed_ids);
+    data.n_ids = RSTRING_LEN(rb_packed_ids) / sizeof(grn_id);
+    data.rc = GRN_SUCCESS;
+    GRN_TEXT_INIT(&(data.text), 0);
+    GRN_TEXT_INIT(&(data.results), 0);
+    GRN_UINT32_INIT(&(data.lengths), 0);
+
+    if (rb_grn_context_need_release_gvl(context, rb_release_gvl)) {
+        rb_grn_context_call_without_gvl(context,
+                                        rb_grn_snippet_execute_batch_body,
+                                        &data);
+    } else {
+        rb_grn_snippet_execute_batch_body(&data);
+    }
+    RB_GC_GUARD(rb_packed_ids);
+
+    if (context->rc == GRN_SUCCESS && data.rc == GRN_SUCCESS)
+        rb_results = rb_grn_snippet_execute_batch_build_results(&data);
+
+    GRN_OBJ_FIN(context, &(data.text));
+    GRN_OBJ_FIN(context, &(data.results));
+    GRN_OBJ_FIN(context, &(data.lengths));
+
+    rb_grn_context_check(context, self);
+    rb_grn_rc_check(data.rc, self);
+
+    return rb_results;
+}
+
 void
 rb_grn_init_snippet (VALUE mGrn)
 {
@@ -277,4 +519,6 @@ rb_grn_init_snippet (VALUE mGrn)
                      rb_grn_snippet_add_keyword, -1);
     rb_define_method(rb_cGrnSnippet, "execute",
                      rb_grn_snippet_execute, 1);
+    rb_define_method(rb_cGrnSnippet, "execute_batch",
+                     rb_grn_snippet_execute_batch, -1);
 }
@@ -0,0 +1,561 @@
+/* -*- coding: utf-8; mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+  Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License version 2.1 as published by the Free Software Foundation.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "rb-grn.h"
+
+#define FLUSH_THRESHOLD_SIZE (64 * 1024)
+
+VALUE rb_cGrnTableDumper;
+
+static ID id_write;
+static ID id_error_write;
+static ID id_resolve_value;
+static ID id_to_json;
+static ID id_array_reference;
+static ID id_name;
+static ID id_local_name;
+static ID id_record_id;
+
+typedef struct {
+    VALUE self;
+    VALUE rb_table;
+    VALUE rb_columns;
+    grn_ctx *context;
+    grn_obj *table;
+    grn_table_cursor *cursor;
+    grn_obj **columns;
+    grn_obj *values;
+    int n_columns;
+    int n_initialized_values;
+    grn_obj buffer;
+    grn_id id;
+    int column_index;
+} DumpRecordsData;
+
+static void
+rb_grn_table_dumper_flush (DumpRecordsData *data)
+{
+    VALUE rb_content;
+
+    if (GRN_TEXT_LEN(&(data->buffer)) == 0)
+        return;
+
+    rb_content = rb_grn_context_rb_string_new(data->context,
+                                              GRN_TEXT_VALUE(&(data->buffer)),
+                                              GRN_TEXT_LEN(&(data->buffer)));
+    GRN_BULK_REWIND(&(data->buffer));
+    rb_funcall(data->self, id_write, 1, rb_content);
+}
+
+static void
+rb_grn_table_dumper_warn_invalid_byte (DumpRecordsData *data,
+                                       const unsigned char *string,
+                                       unsigned int invalid_byte_offset)
+{
+    VALUE rb_record, rb_column, rb_message;
+    unsigned int i;
+    char invalid_byte[sizeof("0xff")];
+
+    rb_record = rb_grn_record_new(data->rb_table, data->id, Qnil);
+    rb_column = RARRAY_PTR(data->rb_columns)[data->column_index];
+
+    rb_message = rb_str_new_cstr("warning: ignore invalid encoding character: <");
+    rb_str_append(rb_message,
+                  rb_obj_as_string(rb_funcall(data->rb_table, id_name, 0)));
+    rb_str_cat2(rb_message, "[");
+    rb_str_append(rb_message,
+                  rb_obj_as_string(rb_funcall(rb_record, id_record_id, 0)));
+    rb_str_cat2(rb_message, "].");
+    rb_str_append(rb_message,
+                  rb_obj_as_string(rb_funcall(rb_column, id_local_name, 0)));
+    rb_str_cat2(rb_message, ">: <");
+    if (string[invalid_byte_offset] == 0) {
+        rb_str_cat2(rb_message, "0");
+    } else {
+        snprintf(invalid_byte, sizeof(invalid_byte),
+                 "%#x", string[invalid_byte_offset]);
+        rb_str_cat2(rb_message, invalid_byte);
+    }
+    rb_str_cat2(rb_message, ">: before: <");
+    for (i = 0; i < invalid_byte_offset;) {
+        int char_length;
+        char_length =
+            rb_grn_utf8_char_length(string + i, invalid_byte_offset - i);
+        if (char_length == 0) {
+            i++;
+        } else {
+            rb_str_cat(rb_message, (const char *)(string + i), char_length);
+            i += char_length;
+        }
+    }
+    rb_str_cat2(rb_message, ">\n");
+    rb_funcall(data->self, id_error_write, 1,
+               rb_grn_context_rb_string_new(data->context,
+                                            RSTRING_PTR(rb_message),
+                                            RSTRING_LEN(rb_message)));
+}
+
+static void
+rb_grn_table_dumper_dump_string (DumpRecordsData *data,
+                                 const char *raw_string,
+                                 unsigned int length)
+{
+    grn_ctx *context = data->context;
+    grn_obj *buffer = &(data->buffer);
+    const unsigned char *string = (const unsigned char *)raw_string;
+    unsigned int i;
+
+    GRN_TEXT_PUTC(context, buffer, '"');
+    for (i = 0; i < length;) {
+        unsigned char character = string[i];
+        int char_length;
+
+        if (character < 0x80) {
+            switch (character) {
+              case '"':
+                GRN_TEXT_PUTS(context, buffer, "\\\"");
+                break;
+              case '\\':
+                GRN_TEXT_PUTS(context, buffer, "\\\\");
+                break;
+              case '\b':
+                GRN_TEXT_PUTS(context, buffer, "\\b");
+                break;
+              case '\f':
+                GRN_TEXT_PUTS(context, buffer, "\\f");
+                break;
+              case '\n':
+                GRN_TEXT_PUTS(context, buffer, "\\n");
+                break;
+              case '\r':
+                GRN_TEXT_PUTS(context, buffer, "\\r");
+                break;
+              case '\t':
+                GRN_TEXT_PUTS(context, buffer, "\\t");
+                break;
+              default:
+                if (character < 0x20) {
+                    char escaped[sizeof("\\u0000")];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", character);
+                    GRN_TEXT_PUTS(context, buffer, escaped);
+                } else {
+                    GRN_TEXT_PUTC(context, buffer, character);
+                }
+                break;
+            }
+            i++;
+            continue;
+        }
+
+        char_length = rb_grn_utf8_char_length(string + i, length - i);
+        if (char_length == 0) {
+            rb_grn_table_dumper_warn_invalid_byte(data, string, i);
+            i++;
+        } else {
+            GRN_TEXT_PUT(context, buffer, string + i, char_length);
+            i += char_length;
+        }
+    }
+    GRN_TEXT_PUTC(context, buffer, '"');
+}
+
+static grn_bool
+rb_grn_table_dumper_dump_bulk (DumpRecordsData *data,
+                               const char *value, unsigned int size,
+                               grn_id domain_id)
+{
+    grn_ctx *context = data->context;
+    grn_obj *buffer = &(data->buffer);
+    grn_obj *domain;
+
+    if (size == 0) {
+        GRN_TEXT_PUTS(context, buffer, "\"\"");
+        return GRN_TRUE;
+    }
+
+    switch (domain_id) {
+      case GRN_DB_BOOL:
+        GRN_TEXT_PUTS(context, buffer, *((grn_bool *)value) ? "true" : "false");
+        return GRN_TRUE;
+      case GRN_DB_INT8:
+        grn_text_itoa(context, buffer, *((int8_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_UINT8:
+        grn_text_itoa(context, buffer, *((uint8_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_INT16:
+        grn_text_itoa(context, buffer, *((int16_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_UINT16:
+        grn_text_itoa(context, buffer, *((uint16_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_INT32:
+        grn_text_itoa(context, buffer, *((int32_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_UINT32:
+        grn_text_lltoa(context, buffer, *((uint32_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_INT64:
+        grn_text_lltoa(context, buffer, *((int64_t *)value));
+        return GRN_TRUE;
+      case GRN_DB_UINT64:
+      {
+          char formatted[sizeof("18446744073709551615")];
+          snprintf(formatted, sizeof(formatted),
+                   "%llu", (unsigned long long)(*((uint64_t *)value)));
+          GRN_TEXT_PUTS(context, buffer, formatted);
+          return GRN_TRUE;
+      }
+      case GRN_DB_SHORT_TEXT:
+      case GRN_DB_TEXT:
+      case GRN_DB_LONG_TEXT:
+        rb_grn_table_dumper_dump_string(data, value, size);
+        return GRN_TRUE;
+      default:
+        break;
+    }
+
+    domain = grn_ctx_at(context, domain_id);
+    if (!domain)
+        return GRN_FALSE;
+
+    switch (domain->header.type) {
+      case GRN_TABLE_HASH_KEY:
+      case GRN_TABLE_PAT_KEY:
+      case GRN_TABLE_DAT_KEY:
+      {
+          grn_id id;
+          grn_obj key;
+          grn_bool dumped;
+
+          id = *((grn_id *)value);
+          if (id == GRN_ID_NIL) {
+              GRN_TEXT_PUTS(context, buffer, "\"\"");
+              return GRN_TRUE;
+          }
+          GRN_OBJ_INIT(&key, GRN_BULK, 0, domain->header.domain);
+          grn_table_get_key2(context, domain, id, &key);
+          dumped = rb_grn_table_dumper_dump_bulk(data,
+                                                 GRN_BULK_HEAD(&key),
+                                                 GRN_BULK_VSIZE(&key),
+                                                 domain->header.domain);
+          GRN_OBJ_FIN(context, &key);
+          return dumped;
+      }
+      case GRN_TABLE_NO_KEY:
+      {
+          grn_id id;
+
+          id = *((grn_id *)value);
+          if (id == GRN_ID_NIL) {
+              GRN_TEXT_PUTS(context, buffer, "\"\"");
+          } else {
+              grn_text_lltoa(context, buffer, id);
+          }
+          return GRN_TRUE;
+      }
+      default:
+        break;
+    }
+
+    return GRN_FALSE;
+}
+
+static unsigned int
+rb_grn_table_dumper_element_size (grn_ctx *context, grn_id domain_id)
+{
+    grn_obj *domain;
+
+    switch (domain_id) {
+      case GRN_DB_BOOL:
+      case GRN_DB_INT8:
+      case GRN_DB_UINT8:
+        return sizeof(int8_t);
+      case GRN_DB_INT16:
+      case GRN_DB_UINT16:
+        return sizeof(int16_t);
+      case GRN_DB_INT32:
+      case GRN_DB_UINT32:
+        return sizeof(int32_t);
+      case GRN_DB_INT64:
+      case GRN_DB_UINT64:
+        return sizeof(int64_t);
+      default:
+        break;
+    }
+
+    domain = grn_ctx_at(context, domain_id);
+    if (!domain)
+        return 0;
+    switch (domain->header.type) {
+      case GRN_TABLE_HASH_KEY:
+      case GRN_TABLE_PAT_KEY:
+      case GRN_TABLE_DAT_KEY:
+      case GRN_TABLE_NO_KEY:
+        return sizeof(grn_id);
+      default:
+        break;
+    }
+
+    return 0;
+}
+
+static grn_bool
+rb_grn_table_dumper_dump_value (DumpRecordsData *data, grn_obj *value)
+{
+    grn_ctx *context = data->context;
+    grn_obj *buffer = &(data->buffer);
+
+    switch (value->header.type) {
+      case GRN_VOID:
+        GRN_TEXT_PUTS(context, buffer, "\"\"");
+        return GRN_TRUE;
+      case GRN_BULK:
+        return rb_grn_table_dumper_dump_bulk(data,
+                                             GRN_BULK_HEAD(value),
+                                             GRN_BULK_VSIZE(value),
+                                             value->header.domain);
+      case GRN_UVECTOR:
+      {
+          unsigned int element_size, i, n;
+          const char *head;
+
+          element_size = rb_grn_table_dumper_element_size(context,
+                                                          value->header.domain);
+          if (element_size == 0)
+              return GRN_FALSE;
+          head = GRN_BULK_HEAD(value);
+          n = GRN_BULK_VSIZE(value) / element_size;
+          GRN_TEXT_PUTC(context, buffer, '[');
+          for (i = 0; i < n; i++) {
+              if (i > 0)
+                  GRN_TEXT_PUTC(context, buffer, ',');
+              if (!rb_grn_table_dumper_dump_bulk(data,
+                                                 head + element_size * i,
+                                                 element_size,
+                                                 value->header.domain))
+                  return GRN_FALSE;
+          }
+          GRN_TEXT_PUTC(context, buffer, ']');
+          return GRN_TRUE;
+      }
+      case GRN_VECTOR:
+      {
+          unsigned int i, n;
+
+          n = grn_vector_size(context, value);
+          GRN_TEXT_PUTC(context, buffer, '[');
+          for (i = 0; i < n; i++) {
+              const char *element;
+              unsigned int element_size;
+              grn_id domain_id;
+
+              element_size = grn_vector_get_element(context, value, i,
+                                                    &element, NULL,
+                                                    &domain_id);
+              if (i > 0)
+                  GRN_TEXT_PUTC(context, buffer, ',');
+              if (!rb_grn_table_dumper_dump_bulk(data,
+                                                 element, element_size,
+                                                 domain_id))
+                  return GRN_FALSE;
+          }
+          GRN_TEXT_PUTC(context, buffer, ']');
+          return GRN_TRUE;
+      }
+      default:
+        break;
+    }
+
+    return GRN_FALSE;
+}
+
+static void
+rb_grn_table_dumper_dump_value_by_ruby (DumpRecordsData *data)
+{
+    VALUE rb_column, rb_record, rb_value, rb_json;
+
+    rb_column = RARRAY_PTR(data->rb_columns)[data->column_index];
+    rb_record = rb_grn_record_new(data->rb_table, data->id, Qnil);
+    rb_value = rb_funcall(rb_column, id_array_reference, 1, UINT2NUM(data->id));
+    rb_value = rb_funcall(data->self, id_resolve_value, 3,
+                          rb_record, rb_column, rb_value);
+    rb_json = rb_funcall(rb_value, id_to_json, 0);
+    GRN_TEXT_PUT(data->context, &(data->buffer),
+                 RSTRING_PTR(rb_json), RSTRING_LEN(rb_json));
+}
+
+static void
+rb_grn_table_dumper_dump_column (DumpRecordsData *data)
+{
+    grn_ctx *context = data->context;
+    grn_obj *column = data->columns[data->column_index];
+    grn_obj *value = &(data->values[data->column_index]);
+    unsigned int start_offset;
+
+    if (column->header.flags & GRN_OBJ_WITH_WEIGHT) {
+        rb_grn_table_dumper_dump_value_by_ruby(data);
+        return;
+    }
+
+    start_offset = GRN_TEXT_LEN(&(data->buffer));
+    GRN_BULK_REWIND(value);
+    grn_obj_get_value(context, column, data->id, value);
+    rb_grn_context_check(context, data->self);
+    if (!rb_grn_table_dumper_dump_value(data, value)) {
+        grn_bulk_truncate(context, &(data->buffer), start_offset);
+        rb_grn_table_dumper_dump_value_by_ruby(data);
+    }
+}
+
+static VALUE
+rb_grn_table_dumper_dump_records_body (VALUE user_data)
+{
+    DumpRecordsData *data = (DumpRecordsData *)user_data;
+    grn_ctx *context = data->context;
+    grn_obj *buffer = &(data->buffer);
+
+    for (; data->n_initialized_values < data->n_columns;
+         data->n_initialized_values++) {
+        grn_obj *column = data->columns[data->n_initialized_values];
+        grn_obj *value = &(data->values[data->n_initialized_values]);
+        grn_id range_id;
+
+        range_id = grn_obj_get_range(context, column);
+        if ((column->header.type == GRN_COLUMN_FIX_SIZE ||
+             column->header.type == GRN_COLUMN_VAR_SIZE) &&
+            (column->header.flags & GRN_OBJ_COLUMN_TYPE_MASK) ==
+            GRN_OBJ_COLUMN_VECTOR) {
+            GRN_OBJ_INIT(value, GRN_VECTOR, 0, range_id);
+        } else {
+            GRN_OBJ_INIT(value, GRN_BULK, 0, range_id);
+        }
+    }
+
+    while ((data->id = grn_table_cursor_next(context, data->cursor))) {
+        GRN_TEXT_PUTS(context, buffer, ",\n[");
+        for (data->column_index = 0;
+             data->column_index < data->n_columns;
+             data->column_index++) {
+            if (data->column_index > 0)
+                GRN_TEXT_PUTC(context, buffer, ',');
+            rb_grn_table_dumper_dump_column(data);
+        }
+        GRN_TEXT_PUTC(context, buffer, ']');
+        if (GRN_TEXT_LEN(buffer) >= FLUSH_THRESHOLD_SIZE)
+            rb_grn_table_dumper_flush(data);
+    }
+    rb_grn_table_dumper_flush(data);
+
+    return Qtrue;
+}
+
+static VALUE
+rb_grn_table_dumper_dump_records_ensure (VALUE user_data)
+{
+    DumpRecordsData *data = (DumpRecordsData *)user_data;
+    int i;
+
+    for (i = 0; i < data->n_initialized_values; i++) {
+        GRN_OBJ_FIN(data->context, &(data->values[i]));
+    }
+    GRN_OBJ_FIN(data->context, &(data->buffer));
+    grn_table_cursor_close(data->context, data->cursor);
+
+    return Qnil;
+}
+
+/*
+ * Dumps records of _table_ as rows of +load+ command. Each row is
+ * serialized from a table cursor into an output buffer in C and
+ * the buffer is written to the output in chunks.
+ *
+ * Values that can't be serialized in C such as +Float+, +Time+
+ * and weight vector are resolved by +resolve_value+ as the pure
+ * Ruby dumper does.
+ *
+ * @overload dump_records_native(table, columns, order_by)
+ *   @return [Boolean] +true+ if records are dumped, +false+
+ *     if the encoding of the context of _table_ isn't UTF-8.
+ *     Nothing is written if +false+ is returned.
+ *
+ * @since 4.0.5
+ * @private
+ */
+static VALUE
+rb_grn_table_dumper_dump_records_native (VALUE self,
+                                         VALUE rb_table,
+                                         VALUE rb_columns,
+                                         VALUE rb_order_by)
+{
+    DumpRecordsData data;
+    int i, flags;
+
+    data.context = NULL;
+    data.table = RVAL2GRNOBJECT(rb_table, &(data.context));
+    if (data.context->encoding != GRN_ENC_UTF8)
+        return Qfalse;
+
+    data.self = self;
+    data.rb_table = rb_table;
+    data.rb_columns = rb_grn_convert_to_array(rb_columns);
+    data.n_columns = RARRAY_LEN(data.rb_columns);
+    data.columns = ALLOCA_N(grn_obj *, data.n_columns);
+    data.values = ALLOCA_N(grn_obj, data.n_columns);
+    data.n_initialized_values = 0;
+    for (i = 0; i < data.n_columns; i++) {
+        data.columns[i] = RVAL2GRNOBJECT(RARRAY_PTR(data.rb_columns)[i],
+                                         &(data.context));
+    }
+
+    flags = rb_grn_table_cursor_order_by_to_flag(data.table->header.type,
+                                                 rb_table,
+                                                 rb_order_by);
+    data.cursor = grn_table_cursor_open(data.context, data.table,
+                                        NULL, 0, NULL, 0,
+                                        0, -1, flags);
+    rb_grn_context_check(data.context, rb_table);
+    GRN_TEXT_INIT(&(data.buffer), 0);
+    data.id = GRN_ID_NIL;
+    data.column_index = 0;
+
+    rb_ensure(rb_grn_table_dumper_dump_records_body, (VALUE)&data,
+              rb_grn_table_dumper_dump_records_ensure, (VALUE)&data);
+
+    RB_GC_GUARD(rb_columns);
+
+    return Qtrue;
+}
+
+void
+rb_grn_init_table_dumper (VALUE mGrn)
+{
+    id_write = rb_intern("write");
+    id_error_write = rb_intern("error_write");
+    id_resolve_value = rb_intern("resolve_value");
+    id_to_json = rb_intern("to_json");
+    id_array_reference = rb_intern("[]");
+    id_name = rb_intern("name");
+    id_local_name = rb_intern("local_name");
+    id_record_id = rb_intern("record_id");
+
+    rb_cGrnTableDumper = rb_define_class_under(mGrn, "TableDumper", rb_cObject);
+
+    rb_define_private_method(rb_cGrnTableDumper, "dump_records_native",
+                             rb_grn_table_dumper_dump_records_native, 3);
+}
@@ -330,6 +330,307 @@ rb_grn_table_key_support_get_key (VALUE self, VALUE rb_id)
     return rb_key;
 }
 
+typedef struct _KeyLookupEntry
+{
+    const char *key;
+    size_t offset;
+    unsigned int key_size;
+    long index;
+} KeyLookupEntry;
+
+static int
+key_lookup_entry_compare (const void *data1, const void *data2)
+{
+    const KeyLookupEntry *entry1 = data1;
+    const KeyLookupEntry *entry2 = data2;
+    unsigned int key_size;
+    int result = 0;
+
+    key_size = entry1->key_size;
+    if (key_size > entry2->key_size)
+        key_size = entry2->key_size;
+    if (key_size > 0)
+        result = memcmp(entry1->key, entry2->key, key_size);
+    if (result == 0) {
+        if (entry1->key_size < entry2->key_size) {
+            result = -1;
+        } else if (entry1->key_size > entry2->key_size) {
+            result = 1;
+        } else if (entry1->index < entry2->index) {
+            result = -1;
+        } else if (entry1->index > entry2->index) {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+static unsigned int
+rb_grn_table_key_support_fixed_key_size (grn_id domain_id, grn_obj *domain)
+{
+    switch (domain_id) {
+    case GRN_DB_BOOL:
+    case GRN_DB_INT8:
+    case GRN_DB_UINT8:
+        return 1;
+    case GRN_DB_INT16:
+    case GRN_DB_UINT16:
+        return 2;
+    case GRN_DB_INT32:
+    case GRN_DB_UINT32:
+        return 4;
+    case GRN_DB_INT64:
+    case GRN_DB_UINT64:
+    case GRN_DB_FLOAT:
+    case GRN_DB_TIME:
+        return 8;
+    case GRN_DB_TOKYO_GEO_POINT:
+    case GRN_DB_WGS84_GEO_POINT:
+        return sizeof(grn_geo_point);
+    default:
+        break;
+    }
+
+    if (domain) {
+        switch (domain->header.type) {
+        case GRN_TABLE_HASH_KEY:
+        case GRN_TABLE_PAT_KEY:
+        case GRN_TABLE_DAT_KEY:
+        case GRN_TABLE_NO_KEY:
+            return sizeof(grn_id);
+        default:
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Returns IDs of records for _keys_ in one call. It is faster
+ * than calling {#id} for each key.
+ *
+ * @example Resolve tag names to IDs
+ *   tags.ids_for(["groonga", "ruby", "unknown"]) # => [1, 2, nil]
+ *
+ * @example Resolve packed keys to packed IDs
+ *   packed_ids = users.ids_for([10, 20].pack("L*")) # UInt32 keys
+ *   packed_ids.unpack("L*")                         # => [1, 2]
+ *
+ * @overload ids_for(keys, options={})
+ *   @param keys [::Array, String] The keys. If the key type of
+ *     the table is a fixed size type such as +UInt32+, you can
+ *     also pass a String that packs keys in the internal
+ *     representation such as +[10, 20].pack("L*")+.
+ *   @param options [::Hash] The name and value
+ *     pairs. Omitted names are initialized as the default value.
+ *   @option options :sort (false)
+ *     If it is +true+, keys are looked up in the order of their
+ *     bytes. It may improve locality for many keys. The order of
+ *     returned IDs isn't changed.
+ *   @option options :packed (nil)
+ *     If it is +true+, IDs are returned as a String that packs IDs
+ *     like {Groonga::Table#each_id_slice}. The ID of a nonexistent
+ *     key is +0+. If it is +nil+, it is +true+ when _keys_ is a
+ *     String.
+ *   @return [::Array<Integer or nil>, String] The IDs in the same
+ *     order as _keys_. The ID of a nonexistent key is +nil+.
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_table_key_support_ids_for (int argc, VALUE *argv, VALUE self)
+{
+    grn_ctx *context;
+    grn_obj *table, *key, *domain;
+    grn_id domain_id;
+    VALUE rb_keys, options, rb_sort_p, rb_packed_p;
+    VALUE rb_packed_keys, rb_entries, rb_packed_ids;
+    KeyLookupEntry *entries;
+    grn_id *ids;
+    const char *keys_head;
+    long i, n_keys;
+
+    rb_scan_args(argc, argv, "11", &rb_keys, &options);
+    rb_grn_scan_options(options,
+                        "sort", &rb_sort_p,
+                        "packed", &rb_packed_p,
+                        NULL);
+
+    rb_grn_table_key_support_deconstruct(SELF(self), &table, &context,
+                                         &key, &domain_id, &domain,
+                                         NULL, NULL, NULL,
+                                         NULL);
+
+    if (TYPE(rb_keys) == T_STRING) {
+        unsigned int key_size;
+
+        key_size = rb_grn_table_key_support_fixed_key_size(domain_id, domain);
+        if (key_size == 0) {
+            rb_raise(rb_eArgError,
+                     "packed keys are only available "
+                     "for fixed size key type: %s: %s",
+                     rb_grn_inspect(rb_keys), rb_grn_inspect(self));
+        }
+        if (RSTRING_LEN(rb_keys) % key_size != 0) {
+            rb_raise(rb_eArgError,
+                     "packed keys size should be a multiple of %u: <%ld>: %s",
+                     key_size, RSTRING_LEN(rb_keys), rb_grn_inspect(self));
+        }
+        if (NIL_P(rb_packed_p))
+            rb_packed_p = Qtrue;
+
+        rb_packed_keys = rb_keys;
+        n_keys = RSTRING_LEN(rb_packed_keys) / key_size;
+        rb_entries = rb_str_new(NULL, sizeof(KeyLookupEntry) * n_keys);
+        entries = (KeyLookupEntry *)RSTRING_PTR(rb_entries);
+        for (i = 0; i < n_keys; i++) {
+            entries[i].offset = key_size * i;
+            entries[i].key_size = key_size;
+            entries[i].index = i;
+        }
+    } else {
+        VALUE *rb_key_values;
+
+        rb_keys = rb_Array(rb_keys);
+        n_keys = RARRAY_LEN(rb_keys);
+        rb_key_values = RARRAY_PTR(rb_keys);
+        rb_packed_keys = rb_str_buf_new(0);
+        rb_entries = rb_str_new(NULL, sizeof(KeyLookupEntry) * n_keys);
+        entries = (KeyLookupEntry *)RSTRING_PTR(rb_entries);
+        for (i = 0; i < n_keys; i++) {
+            GRN_BULK_REWIND(key);
+            RVAL2GRNKEY(rb_key_values[i], context, key, domain_id, domain, self);
+            entries[i].offset = RSTRING_LEN(rb_packed_keys);
+            entries[i].key_size = GRN_BULK_VSIZE(key);
+            entries[i].index = i;
+            rb_str_cat(rb_packed_keys, GRN_BULK_HEAD(key), GRN_BULK_VSIZE(key));
+        }
+    }
+
+    keys_head = RSTRING_PTR(rb_packed_keys);
+    for (i = 0; i < n_keys; i++) {
+        entries[i].key = keys_head + entries[i].offset;
+    }
+    if (RVAL2CBOOL(rb_sort_p)) {
+        qsort(entries, n_keys, sizeof(KeyLookupEntry),
+              key_lookup_entry_compare);
+    }
+
+    rb_packed_ids = rb_str_new(NULL, sizeof(grn_id) * n_keys);
+    ids = (grn_id *)RSTRING_PTR(rb_packed_ids);
+    for (i = 0; i < n_keys; i++) {
+        KeyLookupEntry *entry = &(entries[i]);
+
+        if (entry->key_size == 0) {
+            ids[entry->index] = GRN_ID_NIL;
+        } else {
+            ids[entry->index] = grn_table_get(context, table,
+                                              entry->key, entry->key_size);
+        }
+    }
+    RB_GC_GUARD(rb_packed_keys);
+    RB_GC_GUARD(rb_entries);
+    rb_grn_context_check(context, self);
+
+    if (RVAL2CBOOL(rb_packed_p)) {
+        return rb_packed_ids;
+    } else {
+        VALUE rb_ids;
+
+        rb_ids = rb_ary_new2(n_keys);
+        for (i = 0; i < n_keys; i++) {
+            if (ids[i] == GRN_ID_NIL) {
+                rb_ary_push(rb_ids, Qnil);
+            } else {
+                rb_ary_push(rb_ids, UINT2NUM(ids[i]));
+            }
+        }
+        RB_GC_GUARD(rb_packed_ids);
+        return rb_ids;
+    }
+}
+
+/*
+ * Returns keys of records for _ids_ in one call. It is faster
+ * than calling {#key} for each ID.
+ *
+ * @example Resolve tag IDs to names
+ *   tags.keys_for([1, 2, 100]) # => ["groonga", "ruby", nil]
+ *
+ * @overload keys_for(ids)
+ *   @param ids [::Array<Integer or Groonga::Record>, String] The
+ *     IDs. It may be a String that packs IDs like
+ *     {Groonga::Table#each_id_slice}.
+ *   @return [::Array] The keys in the same order as _ids_. The
+ *     key of a nonexistent record is +nil+.
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_table_key_support_keys_for (VALUE self, VALUE rb_ids)
+{
+    grn_ctx *context;
+    grn_obj *table, *key;
+    VALUE rb_keys;
+    long i, n_ids;
+
+    rb_grn_table_key_support_deconstruct(SELF(self), &table, &context,
+                                         &key, NULL, NULL,
+                                         NULL, NULL, NULL,
+                                         NULL);
+
+    if (TYPE(rb_ids) == T_STRING) {
+        if (RSTRING_LEN(rb_ids) % sizeof(grn_id) != 0) {
+            rb_raise(rb_eArgError,
+                     "packed IDs size should be a multiple of %u: <%ld>: %s",
+                     (unsigned int)sizeof(grn_id),
+                     RSTRING_LEN(rb_ids),
+                     rb_grn_inspect(self));
+        }
+        n_ids = RSTRING_LEN(rb_ids) / sizeof(grn_id);
+    } else {
+        rb_ids = rb_Array(rb_ids);
+        n_ids = RARRAY_LEN(rb_ids);
+    }
+
+    GRN_BULK_REWIND(key);
+    grn_bulk_reserve(context, key, GRN_TABLE_MAX_KEY_SIZE);
+    rb_grn_context_check(context, self);
+
+    rb_keys = rb_ary_new2(n_ids);
+    for (i = 0; i < n_ids; i++) {
+        grn_id id;
+        int key_size;
+
+        if (TYPE(rb_ids) == T_STRING) {
+            memcpy(&id, RSTRING_PTR(rb_ids) + sizeof(grn_id) * i,
+                   sizeof(grn_id));
+        } else {
+            VALUE rb_id = RARRAY_PTR(rb_ids)[i];
+
+            if (NIL_P(rb_id)) {
+                rb_ary_push(rb_keys, Qnil);
+                continue;
+            }
+            id = RVAL2GRNID(rb_id, context, table, self);
+        }
+        key_size = grn_table_get_key(context, table, id,
+                                     GRN_BULK_HEAD(key),
+                                     GRN_TABLE_MAX_KEY_SIZE);
+        if (key_size == 0) {
+            rb_ary_push(rb_keys, Qnil);
+        } else {
+            rb_ary_push(rb_keys,
+                        GRNKEY2RVAL(context, GRN_BULK_HEAD(key), key_size,
+                                    table, self));
+        }
+    }
+
+    return rb_keys;
+}
+
 /*
  * テーブルに主キーが _key_ のレコードがあるならtrueを返す。
  *
@@ -952,6 +1253,10 @@ rb_grn_init_table_key_support (VALUE mGrn)
                      rb_grn_table_key_support_get_key, 1);
     rb_define_method(rb_mGrnTableKeySupport, "has_key?",
                      rb_grn_table_key_support_has_key, 1);
+    rb_define_method(rb_mGrnTableKeySupport, "ids_for",
+                     rb_grn_table_key_support_ids_for, -1);
+    rb_define_method(rb_mGrnTableKeySupport, "keys_for",
+                     rb_grn_table_key_support_keys_for, 1);
 
     rb_define_method(rb_mGrnTableKeySupport, "delete",
                      rb_grn_table_key_support_delete, -1);
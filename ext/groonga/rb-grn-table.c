@@ -30,6 +30,7 @@ VALUE rb_cGrnTable;
 
 static ID id_array_reference;
 static ID id_array_set;
+static ID id_class_for;
 
 /*
  * Document-class: Groonga::Table < Groonga::Object
@@ -58,6 +59,91 @@ rb_grn_table_to_ruby_object (grn_ctx *context, grn_obj *table,
     return GRNOBJECT2RVAL(Qnil, context, table, owner);
 }
 
+/*
+ * Resolved columns and accessors are cached by name for each
+ * table. All caches are expired when a column of a named table is
+ * defined, renamed or removed. An accessor path such as
+ * "author.name" refers columns in other tables. So caches aren't
+ * expired per table.
+ *
+ * Columns of an anonymous table such as a search result can't be
+ * referred from other tables. So only caches of the anonymous
+ * table are expired for them.
+ */
+static unsigned int rb_grn_column_cache_generation = 0;
+
+static void
+rb_grn_table_expire_own_column_cache (RbGrnTable *rb_grn_table,
+                                      grn_ctx *context)
+{
+    if (!rb_grn_table->column_cache)
+        return;
+
+    grn_hash_close(context, rb_grn_table->column_cache);
+    rb_grn_table->column_cache = NULL;
+    rb_ary_clear(rb_grn_table->columns);
+}
+
+/*
+ * _object_ is a table or a column that is changed.
+ */
+void
+rb_grn_table_expire_column_caches (grn_ctx *context, grn_obj *object)
+{
+    grn_obj *table = object;
+    grn_user_data *user_data;
+
+    if (context && object) {
+        switch (object->header.type) {
+          case GRN_COLUMN_FIX_SIZE:
+          case GRN_COLUMN_VAR_SIZE:
+          case GRN_COLUMN_INDEX:
+            table = grn_ctx_at(context, object->header.domain);
+            break;
+          default:
+            break;
+        }
+    }
+
+    if (context && table) {
+        switch (table->header.type) {
+          case GRN_TABLE_HASH_KEY:
+          case GRN_TABLE_PAT_KEY:
+          case GRN_TABLE_DAT_KEY:
+          case GRN_TABLE_NO_KEY:
+            if (grn_obj_name(context, table, NULL, 0) > 0)
+                break;
+            user_data = grn_obj_user_data(context, table);
+            if (user_data && user_data->ptr)
+                rb_grn_table_expire_own_column_cache(RB_GRN_TABLE(user_data->ptr),
+                                                     context);
+            return;
+          default:
+            break;
+        }
+    }
+
+    rb_grn_column_cache_generation++;
+}
+
+/*
+ * @private
+ *
+ * Returns a number that is changed when a column of a named table
+ * is defined, renamed or removed. It is used to expire objects that depend on
+ * the schema such as {Groonga::PreparedExpression}.
+ *
+ * @overload column_cache_generation
+ *   @return [Integer]
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_table_s_get_column_cache_generation (VALUE klass)
+{
+    return UINT2NUM(rb_grn_column_cache_generation);
+}
+
 void
 rb_grn_table_finalizer (grn_ctx *context, grn_obj *object,
                         RbGrnTable *rb_grn_table)
@@ -65,7 +151,11 @@ rb_grn_table_finalizer (grn_ctx *context, grn_obj *object,
     if (context && rb_grn_table->value)
         grn_obj_unlink(context, rb_grn_table->value);
     rb_grn_table->value = NULL;
+    if (context && rb_grn_table->column_cache)
+        grn_hash_close(context, rb_grn_table->column_cache);
+    rb_grn_table->column_cache = NULL;
     rb_grn_table->columns = Qnil;
+    rb_grn_table->record_class = Qnil;
 }
 
 void
@@ -79,6 +169,10 @@ rb_grn_table_bind (RbGrnTable *rb_grn_table,
                                        rb_grn_object->range_id);
     rb_grn_table->columns = Qnil; /* For GC while the below rb_ary_new(). */
     rb_grn_table->columns = rb_ary_new();
+    rb_grn_table->column_cache = NULL;
+    rb_grn_table->column_cache_generation = rb_grn_column_cache_generation;
+    rb_grn_table->record_class = Qnil;
+    rb_grn_table->record_class_generation = rb_grn_column_cache_generation;
 }
 
 void
@@ -117,6 +211,7 @@ rb_grn_table_mark (void *data)
         return;
 
     rb_gc_mark(rb_grn_table->columns);
+    rb_gc_mark(rb_grn_table->record_class);
 
     context = rb_grn_object->context;
     table = rb_grn_object->object;
@@ -332,6 +427,7 @@ rb_grn_table_define_column (int argc, VALUE *argv, VALUE self)
     rb_ary_push(columns, rb_column);
     rb_grn_named_object_set_name(RB_GRN_NAMED_OBJECT(DATA_PTR(rb_column)),
                                  name, name_size);
+    rb_grn_table_expire_column_caches(context, table);
 
     return rb_column;
 }
@@ -452,6 +548,7 @@ rb_grn_table_define_index_column (int argc, VALUE *argv, VALUE self)
     }
 
     rb_column = GRNCOLUMN2RVAL(Qnil, context, column, GRN_TRUE);
+    rb_grn_table_expire_column_caches(context, table);
     if (!NIL_P(rb_source))
         rb_funcall(rb_column, rb_intern("source="), 1, rb_source);
     if (!NIL_P(rb_sources))
@@ -485,45 +582,66 @@ ruby_object_to_column_name (VALUE rb_name,
     }
 }
 
+static grn_hash *
+rb_grn_table_ensure_column_cache (RbGrnTable *rb_grn_table, grn_ctx *context)
+{
+    if (rb_grn_table->column_cache &&
+        rb_grn_table->column_cache_generation == rb_grn_column_cache_generation)
+        return rb_grn_table->column_cache;
+
+    rb_grn_table_expire_own_column_cache(rb_grn_table, context);
+    rb_grn_table->column_cache = grn_hash_create(context, NULL,
+                                                 GRN_TABLE_MAX_KEY_SIZE,
+                                                 sizeof(VALUE),
+                                                 GRN_OBJ_KEY_VAR_SIZE);
+    rb_grn_table->column_cache_generation = rb_grn_column_cache_generation;
+    return rb_grn_table->column_cache;
+}
+
 /*
  * テーブルの _name_ に対応するカラムを返す。カラムが存在しな
  * い場合は +nil+ を返す。
  *
+ * Resolved columns and accessors are cached by name. So it is
+ * O(1) for wide tables.
+ *
  * @overload column(name)
  *   @return [Groonga::Column or nil]
  */
 VALUE
 rb_grn_table_get_column (VALUE self, VALUE rb_name)
 {
+    RbGrnTable *rb_grn_table;
     grn_user_data *user_data;
     grn_ctx *context = NULL;
     grn_obj *table;
     grn_obj *column;
+    grn_hash *column_cache;
     const char *name = NULL;
     unsigned name_size = 0;
     grn_bool owner;
-    VALUE rb_column;
+    VALUE rb_column = Qnil;
     VALUE columns;
-    VALUE *raw_columns;
-    long i, n;
+    void *value;
 
-    rb_grn_table_deconstruct(SELF(self), &table, &context,
+    rb_grn_table = SELF(self);
+    rb_grn_table_deconstruct(rb_grn_table, &table, &context,
                              NULL, NULL,
                              NULL, NULL, NULL,
                              &columns);
 
     ruby_object_to_column_name(rb_name, &name, &name_size);
-    raw_columns = RARRAY_PTR(columns);
-    n = RARRAY_LEN(columns);
-    for (i = 0; i < n; i++) {
-        VALUE rb_column = raw_columns[i];
-        RbGrnNamedObject *rb_grn_named_object;
-
-        rb_grn_named_object = RB_GRN_NAMED_OBJECT(DATA_PTR(rb_column));
-        if (name_size == rb_grn_named_object->name_size &&
-            memcmp(name, rb_grn_named_object->name, name_size) == 0) {
-            return rb_column;
-        }
+    column_cache = rb_grn_table_ensure_column_cache(rb_grn_table, context);
+    if (name_size > GRN_TABLE_MAX_KEY_SIZE)
+        column_cache = NULL;
+    if (column_cache &&
+        grn_hash_get(context, column_cache, name, name_size, &value)) {
+        VALUE rb_cached_column = *((VALUE *)value);
+        /* Cached accessors are floating objects. They are closed by
+           Groonga::Context#pop_memory_pool and so on. */
+        if (RB_GRN_OBJECT(DATA_PTR(rb_cached_column))->object)
+            return rb_cached_column;
+        grn_hash_delete(context, column_cache, name, name_size, NULL);
     }
 
     column = grn_obj_column(context, table, name, name_size);
@@ -536,22 +654,62 @@ rb_grn_table_get_column (VALUE self, VALUE rb_name)
         RbGrnObject *rb_grn_object;
         rb_grn_object = user_data->ptr;
         if (rb_grn_object) {
-            rb_ary_push(columns, rb_grn_object->self);
-            return rb_grn_object->self;
+            rb_column = rb_grn_object->self;
         }
     }
 
-    owner = column->header.type == GRN_ACCESSOR;
-    rb_column = GRNCOLUMN2RVAL(Qnil, context, column, owner);
-    if (owner) {
-        rb_grn_context_register_floating_object(DATA_PTR(rb_column));
+    if (NIL_P(rb_column)) {
+        owner = column->header.type == GRN_ACCESSOR;
+        rb_column = GRNCOLUMN2RVAL(Qnil, context, column, owner);
+        if (owner) {
+            rb_grn_context_register_floating_object(DATA_PTR(rb_column));
+        }
+        rb_grn_named_object_set_name(RB_GRN_NAMED_OBJECT(DATA_PTR(rb_column)),
+                                     name, name_size);
+    }
+
+    if (column_cache &&
+        grn_hash_add(context, column_cache, name, name_size, &value, NULL)) {
+        *((VALUE *)value) = rb_column;
+        /* For GC. */
+        rb_ary_push(columns, rb_column);
     }
-    rb_grn_named_object_set_name(RB_GRN_NAMED_OBJECT(DATA_PTR(rb_column)),
-                                 name, name_size);
 
     return rb_column;
 }
 
+/*
+ * Returns the class of records in the table. It is a subclass of
+ * {Groonga::Record} that has reader and writer methods for
+ * columns. The class is created again when a column of a named
+ * table is defined, renamed or removed.
+ *
+ * Anonymous tables such as search results share the class of the
+ * named source table. Columns defined on an anonymous table don't
+ * create the class again. They are accessed by
+ * {Groonga::Record#method_missing}.
+ *
+ * @overload record_class
+ *   @return [Class] The subclass of {Groonga::Record}.
+ *
+ * @since 4.0.5
+ */
+VALUE
+rb_grn_table_get_record_class (VALUE self)
+{
+    RbGrnTable *rb_grn_table;
+
+    rb_grn_table = SELF(self);
+    if (NIL_P(rb_grn_table->record_class) ||
+        rb_grn_table->record_class_generation != rb_grn_column_cache_generation) {
+        rb_grn_table->record_class = Qnil;
+        rb_grn_table->record_class =
+            rb_funcall(rb_cGrnRecord, id_class_for, 1, self);
+        rb_grn_table->record_class_generation = rb_grn_column_cache_generation;
+    }
+    return rb_grn_table->record_class;
+}
+
 VALUE
 rb_grn_table_get_column_surely (VALUE self, VALUE rb_name)
 {
@@ -687,9 +845,15 @@ rb_grn_table_have_column (VALUE self, VALUE rb_name)
     }
 }
 
+/*
+ * _rb_reuse_record_ receives +:reuse_record+ option for
+ * {Groonga::Table#each}. +:reuse_record+ option is an error when
+ * it is NULL.
+ */
 static grn_table_cursor *
-rb_grn_table_open_grn_cursor (int argc, VALUE *argv, VALUE self,
-                              grn_ctx **context)
+rb_grn_table_open_grn_cursor_full (int argc, VALUE *argv, VALUE self,
+                                   grn_ctx **context,
+                                   VALUE *rb_reuse_record)
 {
     grn_obj *table;
     grn_table_cursor *cursor;
@@ -699,6 +863,7 @@ rb_grn_table_open_grn_cursor (int argc, VALUE *argv, VALUE self,
     int flags = 0;
     VALUE options, rb_min, rb_max, rb_order, rb_order_by;
     VALUE rb_greater_than, rb_less_than, rb_offset, rb_limit;
+    VALUE rb_reuse_record_value;
 
     rb_grn_table_deconstruct(SELF(self), &table, context,
                              NULL, NULL,
@@ -716,8 +881,17 @@ rb_grn_table_open_grn_cursor (int argc, VALUE *argv, VALUE self,
                         "order_by", &rb_order_by,
                         "greater_than", &rb_greater_than,
                         "less_than", &rb_less_than,
+                        "reuse_record", &rb_reuse_record_value,
                         NULL);
 
+    if (rb_reuse_record) {
+        *rb_reuse_record = rb_reuse_record_value;
+    } else if (!NIL_P(rb_reuse_record_value)) {
+        rb_raise(rb_eArgError,
+                 "unexpected key(s) exist: [:reuse_record]: %s",
+                 rb_grn_inspect(options));
+    }
+
     if (!NIL_P(rb_min)) {
         min_key = StringValuePtr(rb_min);
         min_key_size = RSTRING_LEN(rb_min);
@@ -750,6 +924,13 @@ rb_grn_table_open_grn_cursor (int argc, VALUE *argv, VALUE self,
     return cursor;
 }
 
+static grn_table_cursor *
+rb_grn_table_open_grn_cursor (int argc, VALUE *argv, VALUE self,
+                              grn_ctx **context)
+{
+    return rb_grn_table_open_grn_cursor_full(argc, argv, self, context, NULL);
+}
+
 /*
  * カーソルを生成して返す。ブロックを指定すると、そのブロッ
  * クに生成したカーソルが渡され、ブロックを抜けると自動的に
@@ -888,78 +1069,877 @@ rb_grn_table_get_size (VALUE self)
  * @overload empty?
  */
 static VALUE
-rb_grn_table_empty_p (VALUE self)
+rb_grn_table_empty_p (VALUE self)
+{
+    grn_ctx *context = NULL;
+    grn_obj *table;
+    unsigned int size;
+
+    rb_grn_table_deconstruct(SELF(self), &table, &context,
+                             NULL, NULL,
+                             NULL, NULL, NULL,
+                             NULL);
+    size = grn_table_size(context, table);
+    return CBOOL2RVAL(size == 0);
+}
+
+/*
+ * テーブルの全レコードを一括して削除する。
+ *
+ * @overload truncate
+ */
+static VALUE
+rb_grn_table_truncate (VALUE self)
+{
+    grn_ctx *context = NULL;
+    grn_obj *table;
+    grn_rc rc;
+
+    rb_grn_table_deconstruct(SELF(self), &table, &context,
+                             NULL, NULL,
+                             NULL, NULL, NULL,
+                             NULL);
+    rc = grn_table_truncate(context, table);
+    rb_grn_rc_check(rc, self);
+
+    return Qnil;
+}
+
+/*
+ * テーブルに登録されているレコードを順番にブロックに渡す。
+ *
+ * _options_ is the same as {#open_cursor} 's one except
+ * +:reuse_record+.
+ *
+ * If +:reuse_record+ is +true+, the same {Groonga::Record} object
+ * is passed to the block for all records. Its ID is replaced with
+ * the current record's ID for each iteration. It reduces object
+ * allocations for large scan but you must not keep the passed
+ * record after the block is returned. Use {Groonga::Record#id}
+ * and {#[]} if you need to keep it.
+ *
+ * @overload each
+ *   @!macro [new] table.each.metadata
+ *     @yield [record]
+ *     @return [nil]
+ *   @!macro table.each.metadata
+ * @overload each(options={})
+ *   @!macro table.each.metadata
+ *   @option options :reuse_record (false)
+ *     Whether the same {Groonga::Record} is reused for all
+ *     records. It is available since 4.0.5.
+ */
+static VALUE
+rb_grn_table_each (int argc, VALUE *argv, VALUE self)
+{
+    RbGrnTable *rb_table;
+    RbGrnObject *rb_grn_object;
+    grn_ctx *context = NULL;
+    grn_table_cursor *cursor;
+    VALUE rb_cursor;
+    VALUE rb_reuse_record, rb_record = Qnil;
+    grn_bool reuse_record;
+    grn_id id;
+
+    RETURN_ENUMERATOR(self, argc, argv);
+
+    cursor = rb_grn_table_open_grn_cursor_full(argc, argv, self, &context,
+                                               &rb_reuse_record);
+    reuse_record = RVAL2CBOOL(rb_reuse_record);
+    rb_cursor = GRNTABLECURSOR2RVAL(Qnil, context, cursor);
+    rb_table = SELF(self);
+    rb_grn_object = RB_GRN_OBJECT(rb_table);
+    while (rb_grn_object->object &&
+           (id = grn_table_cursor_next(context, cursor)) != GRN_ID_NIL) {
+        if (!reuse_record) {
+            rb_yield(rb_grn_record_new(self, id, Qnil));
+        } else if (NIL_P(rb_record)) {
+            rb_record = rb_grn_record_new(self, id, Qnil);
+            rb_yield(rb_record);
+        } else {
+            rb_yield(rb_grn_record_reuse(rb_record, id));
+        }
+    }
+    rb_grn_object_close(rb_cursor);
+
+    return Qnil;
+}
+
+/*
+ * Iterates IDs of records in the table. It is faster than {#each}
+ * because no {Groonga::Record} is created.
+ *
+ * @example
+ *   bookmarks.each_id do |id|
+ *     p bookmarks.column_value(id, "title", :id => true)
+ *   end
+ *
+ * @overload each_id(options={})
+ *   @param options [::Hash] The same as {#open_cursor} 's one.
+ *   @yield [id] Gives an ID of a record to the block.
+ *   @yieldparam id [Integer] An ID of a record.
+ *   @return [nil]
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_table_each_id (int argc, VALUE *argv, VALUE self)
+{
+    RbGrnObject *rb_grn_object;
+    grn_ctx *context = NULL;
+    grn_table_cursor *cursor;
+    VALUE rb_cursor;
+    grn_id id;
+
+    RETURN_ENUMERATOR(self, argc, argv);
+
+    cursor = rb_grn_table_open_grn_cursor(argc, argv, self, &context);
+    rb_cursor = GRNTABLECURSOR2RVAL(Qnil, context, cursor);
+    rb_grn_object = RB_GRN_OBJECT(SELF(self));
+    while (rb_grn_object->object &&
+           (id = grn_table_cursor_next(context, cursor)) != GRN_ID_NIL) {
+        rb_yield(UINT2NUM(id));
+    }
+    rb_grn_object_close(rb_cursor);
+
+    return Qnil;
+}
+
+/*
+ * Iterates IDs of records in the table by _n_ IDs. IDs are passed
+ * to the block as a String that packs IDs as 32bit unsigned
+ * integers in native byte order. Use +String#unpack("L*")+ to
+ * get IDs as an Array. The last String may have less than _n_
+ * IDs.
+ *
+ * It is useful to process many records in a batch without
+ * creating an object for each record.
+ *
+ * @example
+ *   bookmarks.each_id_slice(1000) do |packed_ids|
+ *     ids = packed_ids.unpack("L*")
+ *     # ...
+ *   end
+ *
+ * @overload each_id_slice(n, options={})
+ *   @param n [Integer] The max number of IDs in a slice.
+ *   @param options [::Hash] The same as {#open_cursor} 's one.
+ *   @yield [packed_ids] Gives packed IDs to the block.
+ *   @yieldparam packed_ids [String] Packed IDs.
+ *   @return [nil]
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_table_each_id_slice (int argc, VALUE *argv, VALUE self)
+{
+    RbGrnObject *rb_grn_object;
+    grn_ctx *context = NULL;
+    grn_table_cursor *cursor;
+    VALUE rb_cursor, rb_n, options, rb_packed_ids;
+    long n, n_ids;
+    grn_id id;
+
+    RETURN_ENUMERATOR(self, argc, argv);
+
+    rb_scan_args(argc, argv, "11", &rb_n, &options);
+    n = NUM2LONG(rb_n);
+    if (n <= 0) {
+        rb_raise(rb_eArgError,
+                 "slice size should be positive: <%ld>: <%s>",
+                 n, rb_grn_inspect(self));
+    }
+
+    cursor = rb_grn_table_open_grn_cursor(1, &options, self, &context);
+    rb_cursor = GRNTABLECURSOR2RVAL(Qnil, context, cursor);
+    rb_grn_object = RB_GRN_OBJECT(SELF(self));
+    rb_packed_ids = rb_str_buf_new(sizeof(grn_id) * n);
+    n_ids = 0;
+    while (rb_grn_object->object &&
+           (id = grn_table_cursor_next(context, cursor)) != GRN_ID_NIL) {
+        rb_str_cat(rb_packed_ids, (const char *)&id, sizeof(grn_id));
+        n_ids++;
+        if (n_ids == n) {
+            rb_yield(rb_packed_ids);
+            rb_packed_ids = rb_str_buf_new(sizeof(grn_id) * n);
+            n_ids = 0;
+        }
+    }
+    rb_grn_object_close(rb_cursor);
+    if (n_ids > 0)
+        rb_yield(rb_packed_ids);
+
+    return Qnil;
+}
+
+typedef struct {
+    grn_obj *column;
+    grn_obj *range;
+    grn_obj value;
+    size_t packed_value_size;
+    VALUE rb_values;
+} FetchColumn;
+
+typedef struct {
+    VALUE self;
+    grn_ctx *context;
+    grn_obj *table;
+    grn_table_cursor *cursor;
+    VALUE rb_column_names;
+    grn_bool packed;
+    int offset;
+    int limit;
+    int flags;
+    FetchColumn *columns;
+    int n_columns;
+    int n_initialized_columns;
+    VALUE rb_result;
+} FetchColumnsData;
+
+static size_t
+rb_grn_table_fetch_columns_packed_value_size (grn_ctx *context,
+                                              grn_obj *column,
+                                              grn_obj *range)
+{
+    grn_id range_id;
+
+    if (column->header.type == GRN_COLUMN_INDEX)
+        return sizeof(uint32_t);
+    if ((column->header.type == GRN_COLUMN_FIX_SIZE ||
+         column->header.type == GRN_COLUMN_VAR_SIZE) &&
+        (column->header.flags & GRN_OBJ_COLUMN_TYPE_MASK) !=
+        GRN_OBJ_COLUMN_SCALAR)
+        return 0;
+    if (!range)
+        return 0;
+
+    switch (range->header.type) {
+      case GRN_TABLE_HASH_KEY:
+      case GRN_TABLE_PAT_KEY:
+      case GRN_TABLE_DAT_KEY:
+      case GRN_TABLE_NO_KEY:
+        return sizeof(grn_id);
+      default:
+        break;
+    }
+
+    range_id = grn_obj_id(context, range);
+    switch (range_id) {
+      case GRN_DB_BOOL:
+        return sizeof(grn_bool);
+      case GRN_DB_INT8:
+      case GRN_DB_UINT8:
+        return sizeof(int8_t);
+      case GRN_DB_INT16:
+      case GRN_DB_UINT16:
+        return sizeof(int16_t);
+      case GRN_DB_INT32:
+      case GRN_DB_UINT32:
+        return sizeof(int32_t);
+      case GRN_DB_INT64:
+      case GRN_DB_UINT64:
+      case GRN_DB_TIME:
+        return sizeof(int64_t);
+      case GRN_DB_FLOAT:
+        return sizeof(double);
+      default:
+        break;
+    }
+
+    return 0;
+}
+
+static void
+rb_grn_table_fetch_columns_init_value (grn_ctx *context,
+                                       FetchColumn *fetch_column,
+                                       VALUE self)
+{
+    grn_obj *column = fetch_column->column;
+    grn_id range_id;
+
+    range_id = fetch_column->range ?
+        grn_obj_id(context, fetch_column->range) : GRN_ID_NIL;
+    switch (column->header.type) {
+      case GRN_ACCESSOR:
+        GRN_OBJ_INIT(&(fetch_column->value), GRN_BULK, 0, range_id);
+        break;
+      case GRN_COLUMN_VAR_SIZE:
+      case GRN_COLUMN_FIX_SIZE:
+        switch (column->header.flags & GRN_OBJ_COLUMN_TYPE_MASK) {
+          case GRN_OBJ_COLUMN_VECTOR:
+            GRN_OBJ_INIT(&(fetch_column->value), GRN_VECTOR, 0, range_id);
+            break;
+          case GRN_OBJ_COLUMN_SCALAR:
+            GRN_OBJ_INIT(&(fetch_column->value), GRN_BULK, 0, range_id);
+            break;
+          default:
+            rb_raise(rb_eGrnError, "unsupported column type: %s",
+                     rb_grn_inspect(self));
+            break;
+        }
+        break;
+      case GRN_COLUMN_INDEX:
+        GRN_UINT32_INIT(&(fetch_column->value), 0);
+        break;
+      default:
+        rb_raise(rb_eGrnError,
+                 "unsupported type: %s", rb_grn_inspect(self));
+        break;
+    }
+}
+
+static VALUE
+rb_grn_table_fetch_columns_body (VALUE user_data)
+{
+    FetchColumnsData *data = (FetchColumnsData *)user_data;
+    grn_ctx *context = data->context;
+    grn_id id;
+    int i;
+
+    while ((id = grn_table_cursor_next(context, data->cursor)) != GRN_ID_NIL) {
+        for (i = 0; i < data->n_columns; i++) {
+            FetchColumn *fetch_column = &(data->columns[i]);
+            grn_obj *value = &(fetch_column->value);
+            VALUE rb_value;
+
+            if (fetch_column->packed_value_size > 0) {
+                size_t value_size;
+
+                GRN_BULK_REWIND(value);
+                grn_obj_get_value(context, fetch_column->column, id, value);
+                rb_grn_context_check(context, data->self);
+                value_size = GRN_BULK_VSIZE(value);
+                if (value_size > fetch_column->packed_value_size)
+                    value_size = fetch_column->packed_value_size;
+                rb_str_cat(fetch_column->rb_values,
+                           GRN_BULK_HEAD(value), value_size);
+                if (value_size < fetch_column->packed_value_size) {
+                    static const char padding[sizeof(int64_t)] = {0};
+                    rb_str_cat(fetch_column->rb_values,
+                               padding,
+                               fetch_column->packed_value_size - value_size);
+                }
+            } else {
+                GRN_BULK_REWIND(value);
+                grn_obj_get_value(context, fetch_column->column, id, value);
+                rb_grn_context_check(context, data->self);
+                rb_value = GRNVALUE2RVAL(context, value, fetch_column->range,
+                                         data->self);
+                rb_ary_push(fetch_column->rb_values, rb_value);
+            }
+        }
+    }
+
+    return Qnil;
+}
+
+static VALUE
+rb_grn_table_fetch_columns_ensure (VALUE user_data)
+{
+    FetchColumnsData *data = (FetchColumnsData *)user_data;
+    grn_ctx *context = data->context;
+    int i;
+
+    if (data->cursor)
+        grn_table_cursor_close(context, data->cursor);
+    for (i = 0; i < data->n_columns; i++) {
+        FetchColumn *fetch_column = &(data->columns[i]);
+        if (i < data->n_initialized_columns)
+            GRN_OBJ_FIN(context, &(fetch_column->value));
+        if (fetch_column->column)
+            grn_obj_unlink(context, fetch_column->column);
+    }
+    xfree(data->columns);
+
+    return Qnil;
+}
+
+static VALUE
+rb_grn_table_fetch_columns_prepare (VALUE user_data)
+{
+    FetchColumnsData *data = (FetchColumnsData *)user_data;
+    grn_ctx *context = data->context;
+    int i;
+
+    for (i = 0; i < data->n_columns; i++) {
+        FetchColumn *fetch_column = &(data->columns[i]);
+        VALUE rb_name;
+        const char *name = NULL;
+        unsigned name_size = 0;
+
+        rb_name = RARRAY_PTR(data->rb_column_names)[i];
+        ruby_object_to_column_name(rb_name, &name, &name_size);
+        fetch_column->column = grn_obj_column(context, data->table,
+                                              name, name_size);
+        if (!fetch_column->column) {
+            rb_raise(rb_eGrnNoSuchColumn,
+                     "no such column: <%s>: <%s>",
+                     rb_grn_inspect(rb_name), rb_grn_inspect(data->self));
+        }
+        fetch_column->range =
+            grn_ctx_at(context,
+                       grn_obj_get_range(context, fetch_column->column));
+        if (data->packed) {
+            fetch_column->packed_value_size =
+                rb_grn_table_fetch_columns_packed_value_size(
+                    context, fetch_column->column, fetch_column->range);
+        }
+        if (fetch_column->packed_value_size > 0) {
+            fetch_column->rb_values = rb_str_buf_new(0);
+        } else {
+            fetch_column->rb_values = rb_ary_new();
+        }
+        rb_ary_push(data->rb_result, fetch_column->rb_values);
+    }
+
+    data->cursor = grn_table_cursor_open(context, data->table,
+                                         NULL, 0,
+                                         NULL, 0,
+                                         data->offset, data->limit,
+                                         data->flags);
+    if (!data->cursor) {
+        rb_grn_context_check(context, data->self);
+        return Qnil;
+    }
+
+    for (; data->n_initialized_columns < data->n_columns;
+         data->n_initialized_columns++) {
+        FetchColumn *fetch_column;
+
+        fetch_column = &(data->columns[data->n_initialized_columns]);
+        rb_grn_table_fetch_columns_init_value(data->context,
+                                              fetch_column,
+                                              data->self);
+    }
+
+    return rb_grn_table_fetch_columns_body(user_data);
+}
+
+/*
+ * Fetches values of the columns specified by _column_names_ for
+ * all records in the table in one pass. It is faster than
+ * reading values via {Groonga::Record#[]} for each record because
+ * no {Groonga::Record} is created and one value buffer is reused
+ * for each column.
+ *
+ * The return value is column-major. The Nth element is the
+ * values of the Nth column in _column_names_. Pseudo columns such
+ * as +_id+, +_key+ and +_score+ can also be specified.
+ *
+ * @example Fetch values of title and _score columns
+ *   result = bookmarks.select {|record| record.title =~ "groonga"}
+ *   titles, scores = result.fetch_columns(["title", "_score"])
+ *
+ * @example Fetch fixed size numeric values as packed String
+ *   ids, n_likes = bookmarks.fetch_columns(["_id", "n_likes"],
+ *                                          :packed => true)
+ *   ids.unpack("L*")     # => [1, 2, 3, ...]
+ *   n_likes.unpack("l*") # => [10, 0, 2, ...]
+ *
+ * @overload fetch_columns(column_names, options={})
+ *   @param column_names [::Array<String, Symbol>] The names of the
+ *     columns to be fetched.
+ *   @param options [::Hash] The name and value
+ *     pairs. Omitted names are initialized as the default value.
+ *   @option options :packed (false)
+ *     If it is +true+, values of fixed size scalar columns (+Bool+,
+ *     +Int8+ ... +UInt64+, +Float+, +Time+, references and
+ *     +_id+ / +_score+) are returned as a String that packs raw
+ *     values in native byte order instead of an Array. A +Time+
+ *     value is packed as microseconds since the epoch.
+ *     Other columns are returned as an Array even if it is +true+.
+ *   @option options :offset
+ *     The same as {#open_cursor} 's one.
+ *   @option options :limit
+ *     The same as {#open_cursor} 's one.
+ *   @option options :order
+ *     The same as {#open_cursor} 's one.
+ *   @option options :order_by
+ *     The same as {#open_cursor} 's one.
+ *   @return [::Array<::Array or String>] The values of each column.
+ *
+ * @since 4.0.5
+ */
+static VALUE
+rb_grn_table_fetch_columns (int argc, VALUE *argv, VALUE self)
+{
+    grn_ctx *context = NULL;
+    grn_obj *table;
+    FetchColumnsData data;
+    int i;
+    VALUE rb_column_names, options;
+    VALUE rb_packed, rb_offset, rb_limit, rb_order, rb_order_by;
+
+    rb_grn_table_deconstruct(SELF(self), &table, &context,
+                             NULL, NULL,
+                             NULL, NULL, NULL,
+                             NULL);
+
+    rb_scan_args(argc, argv, "11", &rb_column_names, &options);
+
+    rb_grn_scan_options(options,
+                        "packed", &rb_packed,
+                        "offset", &rb_offset,
+                        "limit", &rb_limit,
+                        "order", &rb_order,
+                        "order_by", &rb_order_by,
+                        NULL);
+
+    data.self = self;
+    data.context = context;
+    data.table = table;
+    data.cursor = NULL;
+    data.rb_column_names = rb_grn_convert_to_array(rb_column_names);
+    data.packed = RVAL2CBOOL(rb_packed);
+    data.offset = 0;
+    if (!NIL_P(rb_offset))
+        data.offset = NUM2INT(rb_offset);
+    data.limit = -1;
+    if (!NIL_P(rb_limit))
+        data.limit = NUM2INT(rb_limit);
+    data.flags = 0;
+    data.flags |= rb_grn_table_cursor_order_to_flag(rb_order);
+    data.flags |= rb_grn_table_cursor_order_by_to_flag(table->header.type,
+                                                       self,
+                                                       rb_order_by);
+    data.n_columns = RARRAY_LEN(data.rb_column_names);
+    data.n_initialized_columns = 0;
+    data.rb_result = rb_ary_new2(data.n_columns);
+    data.columns = ALLOC_N(FetchColumn, data.n_columns);
+    for (i = 0; i < data.n_columns; i++) {
+        data.columns[i].column = NULL;
+        data.columns[i].range = NULL;
+        data.columns[i].packed_value_size = 0;
+        data.columns[i].rb_values = Qnil;
+    }
+
+    rb_ensure(rb_grn_table_fetch_columns_prepare, (VALUE)&data,
+              rb_grn_table_fetch_columns_ensure, (VALUE)&data);
+
+    return data.rb_result;
+}
+
+typedef struct {
+    VALUE rb_column;
+    grn_obj *column;
+    grn_id range_id;
+    grn_obj *range;
+    grn_obj value;
+} LoadColumn;
+
+typedef struct {
+    VALUE self;
+    grn_ctx *context;
+    grn_obj *table;
+    grn_id key_domain_id;
+    grn_obj *key_domain;
+    grn_obj key;
+    int key_index;
+    LoadColumn *columns;
+    int n_columns;
+    VALUE rb_columns_values;
+    VALUE rb_row_values;
+    long row_index;
+    VALUE rb_errors;
+} LoadColumnsData;
+
+static VALUE
+rb_grn_table_load_columns_value (LoadColumnsData *data, int i)
+{
+    if (NIL_P(data->rb_row_values)) {
+        VALUE rb_column_values;
+        rb_column_values = RARRAY_PTR(data->rb_columns_values)[i];
+        return rb_ary_entry(rb_column_values, data->row_index);
+    } else {
+        return rb_ary_entry(data->rb_row_values, i);
+    }
+}
+
+static void
+rb_grn_table_load_columns_set_value (LoadColumnsData *data,
+                                     LoadColumn *load_column,
+                                     grn_id id,
+                                     VALUE rb_value)
+{
+    grn_ctx *context = data->context;
+    grn_obj *column = load_column->column;
+    grn_obj *value = &(load_column->value);
+    grn_rc rc;
+
+    if (column->header.type == GRN_COLUMN_FIX_SIZE) {
+        RVAL2GRNVALUE(rb_value, context, value,
+                      load_column->range_id, load_column->range);
+    } else if (column->header.type == GRN_COLUMN_VAR_SIZE &&
+               (column->header.flags & GRN_OBJ_COLUMN_TYPE_MASK) ==
+               GRN_OBJ_COLUMN_SCALAR &&
+               NIL_P(rb_grn_check_convert_to_array(rb_value))) {
+        grn_obj_reinit(context, value, GRN_ID_NIL, 0);
+        if (!NIL_P(rb_value))
+            RVAL2GRNBULK(rb_value, context, value);
+    } else {
+        rb_funcall(load_column->rb_column, id_array_set, 2,
+                   UINT2NUM(id), rb_value);
+        return;
+    }
+
+    rc = grn_obj_set_value(context, column, id, value, GRN_OBJ_SET);
+    rb_grn_context_check(context, load_column->rb_column);
+    rb_grn_rc_check(rc, load_column->rb_column);
+}
+
+static VALUE
+rb_grn_table_load_columns_load_row (VALUE user_data)
+{
+    LoadColumnsData *data = (LoadColumnsData *)user_data;
+    grn_ctx *context = data->context;
+    grn_id id;
+    int i;
+
+    if (data->key_index == -1) {
+        id = grn_table_add(context, data->table, NULL, 0, NULL);
+    } else {
+        VALUE rb_key;
+
+        rb_key = rb_grn_table_load_columns_value(data, data->key_index);
+        GRN_BULK_REWIND(&(data->key));
+        RVAL2GRNKEY(rb_key, context, &(data->key),
+                    data->key_domain_id, data->key_domain, data->self);
+        id = grn_table_add(context, data->table,
+                           GRN_BULK_HEAD(&(data->key)),
+                           GRN_BULK_VSIZE(&(data->key)),
+                           NULL);
+    }
+    rb_grn_context_check(context, data->self);
+    if (id == GRN_ID_NIL) {
+        rb_raise(rb_eGrnError,
+                 "failed to add record: <%ld>: <%s>",
+                 data->row_index, rb_grn_inspect(data->self));
+    }
+
+    for (i = 0; i < data->n_columns; i++) {
+        VALUE rb_value;
+
+        if (i == data->key_index)
+            continue;
+        rb_value = rb_grn_table_load_columns_value(data, i);
+        rb_grn_table_load_columns_set_value(data, &(data->columns[i]),
+                                            id, rb_value);
+    }
+
+    return Qnil;
+}
+
+static void
+rb_grn_table_load_columns_load_row_protected (LoadColumnsData *data)
+{
+    int state = 0;
+
+    rb_protect(rb_grn_table_load_columns_load_row, (VALUE)data, &state);
+    if (state != 0) {
+        VALUE rb_error;
+
+        rb_error = rb_errinfo();
+        if (!RVAL2CBOOL(rb_obj_is_kind_of(rb_error, rb_eStandardError)))
+            rb_jump_tag(state);
+        rb_set_errinfo(Qnil);
+        data->context->rc = GRN_SUCCESS;
+        rb_ary_push(data->rb_errors,
+                    rb_ary_new3(2, LONG2NUM(data->row_index), rb_error));
+    }
+    data->row_index++;
+}
+
+static VALUE
+rb_grn_table_load_columns_load_yielded_row (VALUE rb_row, VALUE user_data)
+{
+    LoadColumnsData *data = (LoadColumnsData *)user_data;
+
+    data->rb_row_values = rb_grn_convert_to_array(rb_row);
+    rb_grn_table_load_columns_load_row_protected(data);
+    data->rb_row_values = Qnil;
+
+    return Qnil;
+}
+
+static VALUE
+rb_grn_table_load_columns_body (VALUE user_data)
+{
+    LoadColumnsData *data = (LoadColumnsData *)user_data;
+    VALUE rb_values = data->rb_columns_values;
+    int i;
+
+    for (i = 0; i < data->n_columns; i++) {
+        LoadColumn *load_column = &(data->columns[i]);
+        GRN_OBJ_INIT(&(load_column->value), GRN_BULK, 0,
+                     load_column->range_id);
+    }
+
+    if (RVAL2CBOOL(rb_obj_is_kind_of(rb_values, rb_cArray))) {
+        long n_rows = 0;
+
+        if (RARRAY_LEN(rb_values) != data->n_columns) {
+            rb_raise(rb_eArgError,
+                     "the number of columns of values is different from "
+                     "the number of column names: <%d>: <%ld>: <%s>",
+                     data->n_columns, RARRAY_LEN(rb_values),
+                     rb_grn_inspect(data->self));
+        }
+        for (i = 0; i < data->n_columns; i++) {
+            VALUE rb_column_values;
+            rb_column_values = rb_grn_convert_to_array(RARRAY_PTR(rb_values)[i]);
+            rb_ary_store(rb_values, i, rb_column_values);
+            if (RARRAY_LEN(rb_column_values) > n_rows)
+                n_rows = RARRAY_LEN(rb_column_values);
+        }
+        while (data->row_index < n_rows) {
+            rb_grn_table_load_columns_load_row_protected(data);
+        }
+    } else {
+        data->rb_columns_values = Qnil;
+        rb_iterate(rb_each, rb_values,
+                   rb_grn_table_load_columns_load_yielded_row,
+                   (VALUE)data);
+    }
+
+    return data->rb_errors;
+}
+
+static VALUE
+rb_grn_table_load_columns_ensure (VALUE user_data)
 {
-    grn_ctx *context = NULL;
-    grn_obj *table;
-    unsigned int size;
+    LoadColumnsData *data = (LoadColumnsData *)user_data;
+    int i;
 
-    rb_grn_table_deconstruct(SELF(self), &table, &context,
-                             NULL, NULL,
-                             NULL, NULL, NULL,
-                             NULL);
-    size = grn_table_size(context, table);
-    return CBOOL2RVAL(size == 0);
+    for (i = 0; i < data->n_columns; i++) {
+        GRN_OBJ_FIN(data->context, &(data->columns[i].value));
+    }
+    GRN_OBJ_FIN(data->context, &(data->key));
+
+    return Qnil;
 }
 
 /*
- * テーブルの全レコードを一括して削除する。
+ * Loads many records in one call. It is faster than adding a
+ * record by {#add} and setting values by {Groonga::Record#[]=}
+ * for each record because conversion buffers are reused.
  *
- * @overload truncate
+ * _values_ is column-major values when it is an Array. The Nth
+ * element of _values_ is an Array of values of the Nth column in
+ * _column_names_. Otherwise _values_ should respond to +each+
+ * that yields row-major values such as an Enumerator. The Nth
+ * element of each row is the value of the Nth column.
+ *
+ * If the table has key, +"_key"+ must be included in
+ * _column_names_. The record for the key is added if it doesn't
+ * exist.
+ *
+ * An error for a row doesn't abort loading. It is reported in
+ * the returned errors and the next row is loaded.
+ *
+ * @example Load column-major values
+ *   errors = users.load_columns(["_key", "name", "age"],
+ *                               [
+ *                                 ["alice", "bob"],
+ *                                 ["Alice", "Bob"],
+ *                                 [29, 31],
+ *                               ])
+ *
+ * @example Load rows from an Enumerator
+ *   rows = CSV.foreach("users.csv")
+ *   errors = users.load_columns(["_key", "name", "age"], rows)
+ *   errors.each do |row_index, error|
+ *     puts("#{row_index}: #{error.message}")
+ *   end
+ *
+ * @overload load_columns(column_names, values)
+ *   @param column_names [::Array<String, Symbol>] The names of the
+ *     columns to be loaded.
+ *   @param values [::Array<::Array>, #each] The column-major
+ *     values or row-major values.
+ *   @return [::Array<[Integer, Exception]>] Pairs of the 0-based
+ *     index of the failed row and the raised exception. It is
+ *     empty when all rows are loaded.
+ *
+ * @since 4.0.5
  */
 static VALUE
-rb_grn_table_truncate (VALUE self)
+rb_grn_table_load_columns (VALUE self, VALUE rb_column_names, VALUE rb_values)
 {
     grn_ctx *context = NULL;
     grn_obj *table;
-    grn_rc rc;
+    LoadColumnsData data;
+    int i;
 
     rb_grn_table_deconstruct(SELF(self), &table, &context,
                              NULL, NULL,
                              NULL, NULL, NULL,
                              NULL);
-    rc = grn_table_truncate(context, table);
-    rb_grn_rc_check(rc, self);
-
-    return Qnil;
-}
 
-/*
- * テーブルに登録されているレコードを順番にブロックに渡す。
- *
- * _options_ is the same as {#open_cursor} 's one.
- *
- * @overload each
- *   @!macro [new] table.each.metadata
- *     @yield [record]
- *     @return [nil]
- *   @!macro table.each.metadata
- * @overload each(options={})
- *   @!macro table.each.metadata
- */
-static VALUE
-rb_grn_table_each (int argc, VALUE *argv, VALUE self)
-{
-    RbGrnTable *rb_table;
-    RbGrnObject *rb_grn_object;
-    grn_ctx *context = NULL;
-    grn_table_cursor *cursor;
-    VALUE rb_cursor;
-    grn_id id;
+    rb_column_names = rb_grn_convert_to_array(rb_column_names);
+
+    data.self = self;
+    data.context = context;
+    data.table = table;
+    data.key_domain_id = GRN_ID_NIL;
+    data.key_domain = NULL;
+    data.key_index = -1;
+    data.n_columns = RARRAY_LEN(rb_column_names);
+    data.columns = ALLOCA_N(LoadColumn, data.n_columns);
+    data.rb_columns_values = rb_values;
+    if (RVAL2CBOOL(rb_obj_is_kind_of(rb_values, rb_cArray)))
+        data.rb_columns_values = rb_ary_dup(rb_values);
+    data.rb_row_values = Qnil;
+    data.row_index = 0;
+    data.rb_errors = rb_ary_new();
+
+    for (i = 0; i < data.n_columns; i++) {
+        LoadColumn *load_column = &(data.columns[i]);
+        VALUE rb_name;
+        const char *name = NULL;
+        unsigned name_size = 0;
+
+        rb_name = RARRAY_PTR(rb_column_names)[i];
+        ruby_object_to_column_name(rb_name, &name, &name_size);
+        load_column->rb_column = Qnil;
+        load_column->column = NULL;
+        load_column->range_id = GRN_ID_NIL;
+        load_column->range = NULL;
+        if (name_size == strlen("_key") &&
+            memcmp(name, "_key", name_size) == 0) {
+            if (table->header.type == GRN_TABLE_NO_KEY) {
+                rb_raise(rb_eArgError,
+                         "_key is specified for table without key: <%s>",
+                         rb_grn_inspect(self));
+            }
+            data.key_index = i;
+            continue;
+        }
 
-    RETURN_ENUMERATOR(self, argc, argv);
+        load_column->rb_column = rb_grn_table_get_column_surely(self, rb_name);
+        load_column->column = RVAL2GRNOBJECT(load_column->rb_column, &context);
+        load_column->range_id = grn_obj_get_range(context,
+                                                  load_column->column);
+        load_column->range = grn_ctx_at(context, load_column->range_id);
+    }
 
-    cursor = rb_grn_table_open_grn_cursor(argc, argv, self, &context);
-    rb_cursor = GRNTABLECURSOR2RVAL(Qnil, context, cursor);
-    rb_table = SELF(self);
-    rb_grn_object = RB_GRN_OBJECT(rb_table);
-    while (rb_grn_object->object &&
-           (id = grn_table_cursor_next(context, cursor)) != GRN_ID_NIL) {
-        rb_yield(rb_grn_record_new(self, id, Qnil));
+    if (table->header.type != GRN_TABLE_NO_KEY && data.key_index == -1) {
+        rb_raise(rb_eArgError,
+                 "_key must be specified for table with key: <%s>",
+                 rb_grn_inspect(self));
     }
-    rb_grn_object_close(rb_cursor);
+    if (data.key_index != -1) {
+        data.key_domain_id = table->header.domain;
+        data.key_domain = grn_ctx_at(context, data.key_domain_id);
+    }
+    GRN_OBJ_INIT(&(data.key), GRN_BULK, 0, data.key_domain_id);
 
-    return Qnil;
+    rb_ensure(rb_grn_table_load_columns_body, (VALUE)&data,
+              rb_grn_table_load_columns_ensure, (VALUE)&data);
+
+    RB_GC_GUARD(rb_column_names);
+    RB_GC_GUARD(rb_values);
+
+    return data.rb_errors;
 }
 
 VALUE
@@ -1073,6 +2053,507 @@ rb_grn_table_delete (int argc, VALUE *argv, VALUE self)
     return Qnil;
 }
 
+typedef struct _SortData SortData;
+struct _SortData
+{
+    grn_ctx *context;
+    grn_obj *table;
+    int offset;
+    int limit;
+    grn_obj *result;
+    grn_table_sort_key *keys;
+    int n_keys;
+};
+
+static void *
+rb_grn_table_sort_raw (void *user_data)
+{
+    SortData *data = user_data;
+
+    grn_table_sort(data->context, data->table,
+                   data->offset, data->limit,
+                   data->result,
+                   data->keys, data->n_keys);
+    return NULL;
+}
+
+typedef enum {
+    TOP_K_VALUE_INT,
+    TOP_K_VALUE_UINT,
+    TOP_K_VALUE_FLOAT,
+    TOP_K_VALUE_TEXT
+} TopKValueType;
+
+typedef struct _TopKValue TopKValue;
+struct _TopKValue
+{
+    union {
+        int64_t int_value;
+        uint64_t uint_value;
+        double float_value;
+    } number;
+    char *text;
+    unsigned int text_size;
+    unsigned int text_capacity;
+};
+
+typedef struct _TopKEntry TopKEntry;
+struct _TopKEntry
+{
+    grn_id id;
+    TopKValue *values;
+};
+
+/*
+ * It picks the first offset + limit records by a bounded max heap
+ * instead of sorting all records. The root of the heap is the
+ * record that is sorted at the last in the picked records. So a
+ * record that is sorted before the root replaces the root.
+ *
+ * It must not use Ruby API because it may run without the GVL.
+ */
+typedef struct _TopKSortData TopKSortData;
+struct _TopKSortData
+{
+    grn_ctx *context;
+    grn_obj *table;
+    grn_table_sort_key *keys;
+    int n_keys;
+    TopKValueType *types;
+    grn_obj *buffers;
+    int offset;
+    int k;
+    grn_obj *result;
+    TopKEntry *entries;
+    int n_entries;
+    TopKValue *candidate_values;
+    grn_bool supported;
+};
+
+static grn_bool
+rb_grn_table_sort_top_k_resolve_type (grn_ctx *context, grn_obj *key,
+                                      TopKValueType *type)
+{
+    switch (key->header.type) {
+    case GRN_COLUMN_FIX_SIZE:
+    case GRN_COLUMN_VAR_SIZE:
+        if ((key->header.flags & GRN_OBJ_COLUMN_TYPE_MASK) !=
+            GRN_OBJ_COLUMN_SCALAR)
+            return GRN_FALSE;
+        break;
+    case GRN_ACCESSOR:
+        break;
+    default:
+        return GRN_FALSE;
+    }
+
+    switch (grn_obj_get_range(context, key)) {
+    case GRN_DB_BOOL:
+    case GRN_DB_UINT8:
+    case GRN_DB_UINT16:
+    case GRN_DB_UINT32:
+    case GRN_DB_UINT64:
+        *type = TOP_K_VALUE_UINT;
+        return GRN_TRUE;
+    case GRN_DB_INT8:
+    case GRN_DB_INT16:
+    case GRN_DB_INT32:
+    case GRN_DB_INT64:
+    case GRN_DB_TIME:
+        *type = TOP_K_VALUE_INT;
+        return GRN_TRUE;
+    case GRN_DB_FLOAT:
+        *type = TOP_K_VALUE_FLOAT;
+        return GRN_TRUE;
+    case GRN_DB_SHORT_TEXT:
+    case GRN_DB_TEXT:
+    case GRN_DB_LONG_TEXT:
+        *type = TOP_K_VALUE_TEXT;
+        return GRN_TRUE;
+    default:
+        return GRN_FALSE;
+    }
+}
+
+static grn_bool
+rb_grn_table_sort_top_k_read (TopKSortData *data, grn_id id,
+                              TopKValue *values)
+{
+    grn_ctx *context = data->context;
+    int i;
+
+    for (i = 0; i < data->n_keys; i++) {
+        grn_obj *buffer = &(data->buffers[i]);
+        TopKValue *value = &(values[i]);
+        const char *head;
+        unsigned int size;
+
+        GRN_BULK_REWIND(buffer);
+        grn_obj_get_value(context, data->keys[i].key, id, buffer);
+        if (buffer->header.type != GRN_BULK) {
+            /* Vector values aren't supported. */
+            data->supported = GRN_FALSE;
+            return GRN_FALSE;
+        }
+        head = GRN_BULK_HEAD(buffer);
+        size = GRN_BULK_VSIZE(buffer);
+        switch (data->types[i]) {
+        case TOP_K_VALUE_INT:
+            switch (size) {
+            case 1:
+                value->number.int_value = *((int8_t *)head);
+                break;
+            case 2:
+                value->number.int_value = *((int16_t *)head);
+                break;
+            case 4:
+                value->number.int_value = *((int32_t *)head);
+                break;
+            case 8:
+                value->number.int_value = *((int64_t *)head);
+                break;
+            default:
+                value->number.int_value = 0;
+                break;
+            }
+            break;
+        case TOP_K_VALUE_UINT:
+            switch (size) {
+            case 1:
+                value->number.uint_value = *((uint8_t *)head);
+                break;
+            case 2:
+                value->number.uint_value = *((uint16_t *)head);
+                break;
+            case 4:
+                value->number.uint_value = *((uint32_t *)head);
+                break;
+            case 8:
+                value->number.uint_value = *((uint64_t *)head);
+                break;
+            default:
+                value->number.uint_value = 0;
+                break;
+            }
+            break;
+        case TOP_K_VALUE_FLOAT:
+            if (size == sizeof(double)) {
+                value->number.float_value = *((double *)head);
+            } else {
+                value->number.float_value = 0.0;
+            }
+            break;
+        case TOP_K_VALUE_TEXT:
+            /* It refers the buffer. It's copied when it's picked. */
+            value->text = (char *)head;
+            value->text_size = size;
+            break;
+        }
+    }
+
+    return GRN_TRUE;
+}
+
+static int
+rb_grn_table_sort_top_k_compare (TopKSortData *data,
+                                 grn_id id1, TopKValue *values1,
+                                 grn_id id2, TopKValue *values2)
+{
+    int i;
+
+    for (i = 0; i < data->n_keys; i++) {
+        TopKValue *value1 = &(values1[i]);
+        TopKValue *value2 = &(values2[i]);
+        int compared = 0;
+
+        switch (data->types[i]) {
+        case TOP_K_VALUE_INT:
+            if (value1->number.int_value < value2->number.int_value) {
+                compared = -1;
+            } else if (value1->number.int_value > value2->number.int_value) {
+                compared = 1;
+            }
+            break;
+        case TOP_K_VALUE_UINT:
+            if (value1->number.uint_value < value2->number.uint_value) {
+                compared = -1;
+            } else if (value1->number.uint_value > value2->number.uint_value) {
+                compared = 1;
+            }
+            break;
+        case TOP_K_VALUE_FLOAT:
+            if (value1->number.float_value < value2->number.float_value) {
+                compared = -1;
+            } else if (value1->number.float_value >
+                       value2->number.float_value) {
+                compared = 1;
+            }
+            break;
+        case TOP_K_VALUE_TEXT:
+        {
+            unsigned int size;
+
+            size = value1->text_size;
+            if (size > value2->text_size)
+                size = value2->text_size;
+            if (size > 0)
+                compared = memcmp(value1->text, value2->text, size);
+            if (compared == 0) {
+                if (value1->text_size < value2->text_size) {
+                    compared = -1;
+                } else if (value1->text_size > value2->text_size) {
+                    compared = 1;
+                }
+            }
+            break;
+        }
+        }
+        if (compared != 0) {
+            if (data->keys[i].flags & GRN_TABLE_SORT_DESC)
+                compared = -compared;
+            return compared;
+        }
+    }
+
+    /* Use ID to break ties for stable result. */
+    if (id1 < id2) {
+        return -1;
+    } else if (id1 > id2) {
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+/*
+ * It uses realloc() instead of REALLOC_N() because it runs without
+ * the GVL. It returns GRN_FALSE when no memory is available.
+ */
+static grn_bool
+rb_grn_table_sort_top_k_store (TopKSortData *data, TopKEntry *entry,
+                               grn_id id, TopKValue *values)
+{
+    int i;
+
+    entry->id = id;
+    for (i = 0; i < data->n_keys; i++) {
+        TopKValue *value = &(entry->values[i]);
+
+        if (data->types[i] == TOP_K_VALUE_TEXT) {
+            if (value->text_capacity < values[i].text_size) {
+                char *text;
+
+                text = realloc(value->text, values[i].text_size);
+                if (!text)
+                    return GRN_FALSE;
+                value->text = text;
+                value->text_capacity = values[i].text_size;
+            }
+            memcpy(value->text, values[i].text, values[i].text_size);
+            value->text_size = values[i].text_size;
+        } else {
+            value->number = values[i].number;
+        }
+    }
+
+    return GRN_TRUE;
+}
+
+static int
+rb_grn_table_sort_top_k_compare_entries (TopKSortData *data, int i, int j)
+{
+    return rb_grn_table_sort_top_k_compare(data,
+                                           data->entries[i].id,
+                                           data->entries[i].values,
+                                           data->entries[j].id,
+                                           data->entries[j].values);
+}
+
+static void
+rb_grn_table_sort_top_k_swap (TopKSortData *data, int i, int j)
+{
+    TopKEntry entry;
+
+    entry = data->entries[i];
+    data->entries[i] = data->entries[j];
+    data->entries[j] = entry;
+}
+
+static void
+rb_grn_table_sort_top_k_sift_up (TopKSortData *data, int i)
+{
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (rb_grn_table_sort_top_k_compare_entries(data, parent, i) >= 0)
+            break;
+        rb_grn_table_sort_top_k_swap(data, parent, i);
+        i = parent;
+    }
+}
+
+static void
+rb_grn_table_sort_top_k_sift_down (TopKSortData *data, int i, int n)
+{
+    while (GRN_TRUE) {
+        int largest = i;
+        int left = i * 2 + 1;
+        int right = left + 1;
+
+        if (left < n &&
+            rb_grn_table_sort_top_k_compare_entries(data, left, largest) > 0)
+            largest = left;
+        if (right < n &&
+            rb_grn_table_sort_top_k_compare_entries(data, right, largest) > 0)
+            largest = right;
+        if (largest == i)
+            break;
+        rb_grn_table_sort_top_k_swap(data, i, largest);
+        i = largest;
+    }
+}
+
+static void *
+rb_grn_table_sort_top_k_raw (void *user_data)
+{
+    TopKSortData *data = user_data;
+    grn_ctx *context = data->context;
+    grn_table_cursor *cursor;
+    grn_obj record;
+    grn_id id;
+    int i, n;
+
+    cursor = grn_table_cursor_open(context, data->table,
+                                   NULL, 0, NULL, 0,
+                                   0, -1, GRN_CURSOR_ASCENDING);
+    if (!cursor)
+        return NULL;
+    while ((id = grn_table_cursor_next(context, cursor)) != GRN_ID_NIL) {
+        if (context->rc != GRN_SUCCESS)
+            break;
+        if (!rb_grn_table_sort_top_k_read(data, id, data->candidate_values))
+            break;
+        if (data->n_entries < data->k) {
+            if (!rb_grn_table_sort_top_k_store(data,
+                                               &(data->entries[data->n_entries]),
+                                               id, data->candidate_values)) {
+                data->supported = GRN_FALSE;
+                break;
+            }
+            rb_grn_table_sort_top_k_sift_up(data, data->n_entries);
+            data->n_entries++;
+        } else if (rb_grn_table_sort_top_k_compare(data,
+                                                   id,
+                                                   data->candidate_values,
+                                                   data->entries[0].id,
+                                                   data->entries[0].values) < 0) {
+            if (!rb_grn_table_sort_top_k_store(data, &(data->entries[0]),
+                                               id, data->candidate_values)) {
+                data->supported = GRN_FALSE;
+                break;
+            }
+            rb_grn_table_sort_top_k_sift_down(data, 0, data->n_entries);
+        }
+    }
+    grn_table_cursor_close(context, cursor);
+    if (!data->supported || context->rc != GRN_SUCCESS)
+        return NULL;
+
+    /* Heap sort: the root is moved to the last. */
+    for (n = data->n_entries; n > 1; n--) {
+        rb_grn_table_sort_top_k_swap(data, 0, n - 1);
+        rb_grn_table_sort_top_k_sift_down(data, 0, n - 1);
+    }
+
+    GRN_RECORD_INIT(&record, 0, grn_obj_id(context, data->table));
+    for (i = data->offset; i < data->n_entries; i++) {
+        grn_id result_id;
+
+        result_id = grn_table_add(context, data->result, NULL, 0, NULL);
+        if (result_id == GRN_ID_NIL)
+            break;
+        GRN_RECORD_SET(context, &record, data->entries[i].id);
+        grn_obj_set_value(context, data->result, result_id, &record,
+                          GRN_OBJ_SET);
+    }
+    GRN_OBJ_FIN(context, &record);
+
+    return NULL;
+}
+
+/*
+ * Returns GRN_FALSE when top-k sort can't be used for the keys or
+ * memory for key values can't be allocated. In the case,
+ * grn_table_sort() should be used.
+ */
+static grn_bool
+rb_grn_table_sort_top_k (grn_ctx *context, grn_obj *table,
+                         grn_table_sort_key *keys, int n_keys,
+                         int offset, int limit,
+                         grn_obj *result, VALUE rb_release_gvl)
+{
+    TopKSortData data;
+    TopKValue *values;
+    int i, k, n_records;
+
+    if (offset < 0 || limit < 0)
+        return GRN_FALSE;
+    n_records = grn_table_size(context, table);
+    if (offset >= n_records)
+        return GRN_TRUE;
+    k = offset + limit;
+    if (k > n_records)
+        k = n_records;
+    if (k == 0)
+        return GRN_TRUE;
+
+    data.types = ALLOCA_N(TopKValueType, n_keys);
+    for (i = 0; i < n_keys; i++) {
+        if (!rb_grn_table_sort_top_k_resolve_type(context, keys[i].key,
+                                                  &(data.types[i])))
+            return GRN_FALSE;
+    }
+
+    data.context = context;
+    data.table = table;
+    data.keys = keys;
+    data.n_keys = n_keys;
+    data.offset = offset;
+    data.k = k;
+    data.result = result;
+    data.n_entries = 0;
+    data.supported = GRN_TRUE;
+    data.buffers = ALLOCA_N(grn_obj, n_keys);
+    for (i = 0; i < n_keys; i++) {
+        GRN_OBJ_INIT(&(data.buffers[i]), GRN_BULK, 0,
+                     grn_obj_get_range(context, keys[i].key));
+    }
+    data.entries = ALLOC_N(TopKEntry, k);
+    values = ALLOC_N(TopKValue, (k + 1) * n_keys);
+    memset(values, 0, sizeof(TopKValue) * (k + 1) * n_keys);
+    for (i = 0; i < k; i++) {
+        data.entries[i].values = values + (i * n_keys);
+    }
+    data.candidate_values = values + (k * n_keys);
+
+    if (rb_grn_context_need_release_gvl(context, rb_release_gvl)) {
+        rb_grn_context_call_without_gvl(context, rb_grn_table_sort_top_k_raw,
+                                        &data);
+    } else {
+        rb_grn_table_sort_top_k_raw(&data);
+    }
+
+    for (i = 0; i < k * n_keys; i++) {
+        free(values[i].text);
+    }
+    xfree(values);
+    xfree(data.entries);
+    for (i = 0; i < n_keys; i++) {
+        GRN_OBJ_FIN(context, &(data.buffers[i]));
+    }
+
+    return data.supported;
+}
+
 /*
  * テーブルに登録されているレコードを _keys_ で指定されたルー
  * ルに従ってソートしたレコードの配列を返す。
@@ -1126,6 +2607,16 @@ rb_grn_table_delete (int argc, VALUE *argv, VALUE self)
  *     ソートされたレコードのうち、 _:limit_ 件のみを取り出す。
  *     省略された場合または-1が指定された場合は、全件が指定され
  *     たものとみなす。
+ *   @option options [Boolean] :release_gvl
+ *     +true+ を指定するとソート中にGVLを解放する。省略した場合は
+ *     {Groonga::Context#release_gvl?} の値を使う。
+ *   @option options [Boolean] :top_k (false)
+ *     +true+ を指定すると全レコードをソートせずに、先頭から
+ *     _:offset_ + _:limit_ 件のレコードだけをヒープで選んでソー
+ *     トする。 _:limit_ が全レコード数より十分小さいときに速い。
+ *     _:limit_ が指定されていない場合やソートキーが数値・時刻・
+ *     文字列のスカラー値でない場合は無視される。同じ値のレコー
+ *     ドはIDの昇順に並ぶ。It is available since 4.0.5.
  *
  * @return [Groonga::Array] The sorted result. You can get the
  *   original record by {#value} method of a record in the sorted
@@ -1166,9 +2657,12 @@ rb_grn_table_sort (int argc, VALUE *argv, VALUE self)
     int i, n_keys;
     int offset = 0, limit = -1;
     VALUE rb_keys, options;
-    VALUE rb_offset, rb_limit;
+    VALUE rb_offset, rb_limit, rb_release_gvl, rb_top_k;
     VALUE *rb_sort_keys;
+    VALUE rb_resolved_keys;
     VALUE exception;
+    SortData data;
+    grn_bool sorted = GRN_FALSE;
 
     rb_grn_table_deconstruct(SELF(self), &table, &context,
                              NULL, NULL,
@@ -1184,6 +2678,7 @@ rb_grn_table_sort (int argc, VALUE *argv, VALUE self)
     n_keys = RARRAY_LEN(rb_keys);
     rb_sort_keys = RARRAY_PTR(rb_keys);
     keys = ALLOCA_N(grn_table_sort_key, n_keys);
+    rb_resolved_keys = rb_ary_new2(n_keys);
     for (i = 0; i < n_keys; i++) {
         VALUE rb_sort_options, rb_key, rb_resolved_key, rb_order;
 
@@ -1212,6 +2707,7 @@ rb_grn_table_sort (int argc, VALUE *argv, VALUE self)
         } else {
             rb_resolved_key = rb_key;
         }
+        rb_ary_push(rb_resolved_keys, rb_resolved_key);
         keys[i].key = RVAL2GRNOBJECT(rb_resolved_key, &context);
         if (!keys[i].key) {
             rb_raise(rb_eGrnNoSuchColumn,
@@ -1236,6 +2732,8 @@ rb_grn_table_sort (int argc, VALUE *argv, VALUE self)
     rb_grn_scan_options(options,
                         "offset", &rb_offset,
                         "limit", &rb_limit,
+                        "release_gvl", &rb_release_gvl,
+                        "top_k", &rb_top_k,
                         NULL);
 
     if (!NIL_P(rb_offset))
@@ -1245,10 +2743,31 @@ rb_grn_table_sort (int argc, VALUE *argv, VALUE self)
 
     result = grn_table_create(context, NULL, 0, NULL, GRN_TABLE_NO_KEY,
                               NULL, table);
-    /* use n_records that is return value from
-       grn_table_sort() when rroonga user become specifying
-       output table. */
-    grn_table_sort(context, table, offset, limit, result, keys, n_keys);
+    if (RVAL2CBOOL(rb_top_k)) {
+        sorted = rb_grn_table_sort_top_k(context, table, keys, n_keys,
+                                         offset, limit,
+                                         result, rb_release_gvl);
+    }
+    if (!sorted) {
+        /* use n_records that is return value from
+           grn_table_sort() when rroonga user become specifying
+           output table. */
+        data.context = context;
+        data.table = table;
+        data.offset = offset;
+        data.limit = limit;
+        data.result = result;
+        data.keys = keys;
+        data.n_keys = n_keys;
+        if (rb_grn_context_need_release_gvl(context, rb_release_gvl)) {
+            rb_grn_context_call_without_gvl(context, rb_grn_table_sort_raw,
+                                            &data);
+        } else {
+            rb_grn_table_sort_raw(&data);
+        }
+    }
+    /* Resolved keys must not be closed by GC while sorting. */
+    RB_GC_GUARD(rb_resolved_keys);
     exception = rb_grn_context_to_exception(context, self);
     if (!NIL_P(exception)) {
         grn_obj_unlink(context, result);
@@ -1258,6 +2777,29 @@ rb_grn_table_sort (int argc, VALUE *argv, VALUE self)
     return GRNOBJECT2RVAL(Qnil, context, result, GRN_TRUE);
 }
 
+typedef struct _GroupData GroupData;
+struct _GroupData
+{
+    grn_ctx *context;
+    grn_obj *table;
+    grn_table_sort_key *keys;
+    int n_keys;
+    grn_table_group_result *results;
+    int n_results;
+    grn_rc rc;
+};
+
+static void *
+rb_grn_table_group_raw (void *user_data)
+{
+    GroupData *data = user_data;
+
+    data->rc = grn_table_group(data->context, data->table,
+                               data->keys, data->n_keys,
+                               data->results, data->n_results);
+    return NULL;
+}
+
 /*
  * _table_ のレコードを _key1_ , _key2_ , _..._ で指定したキーの
  * 値でグループ化する。多くの場合、キーにはカラムを指定する。
@@ -1270,6 +2812,9 @@ rb_grn_table_sort (int argc, VALUE *argv, VALUE self)
  * @option options :max_n_sub_records
  *   グループ化した後のレコードのそれぞれについて最大 _:max_n_sub_records_ 件まで
  *   そのグループに含まれる _table_ のレコードをサブレコードとして格納する。
+ * @option options [Boolean] :release_gvl
+ *   +true+ を指定するとグループ化中にGVLを解放する。省略した場合は
+ *   {Groonga::Context#release_gvl?} の値を使う。
  */
 static VALUE
 rb_grn_table_group (int argc, VALUE *argv, VALUE self)
@@ -1280,10 +2825,11 @@ rb_grn_table_group (int argc, VALUE *argv, VALUE self)
     grn_table_group_result *results;
     int i, n_keys, n_results;
     unsigned int max_n_sub_records = 0;
-    grn_rc rc;
-    VALUE rb_keys, rb_options, rb_max_n_sub_records;
+    VALUE rb_keys, rb_options, rb_max_n_sub_records, rb_release_gvl;
     VALUE *rb_group_keys;
+    VALUE rb_resolved_keys;
     VALUE rb_results;
+    GroupData data;
 
     rb_grn_table_deconstruct(SELF(self), &table, &context,
                              NULL, NULL,
@@ -1302,12 +2848,14 @@ rb_grn_table_group (int argc, VALUE *argv, VALUE self)
 
     rb_grn_scan_options(rb_options,
                         "max_n_sub_records", &rb_max_n_sub_records,
+                        "release_gvl", &rb_release_gvl,
                         NULL);
 
     if (!NIL_P(rb_max_n_sub_records))
         max_n_sub_records = NUM2UINT(rb_max_n_sub_records);
 
     keys = ALLOCA_N(grn_table_sort_key, n_keys);
+    rb_resolved_keys = rb_ary_new2(n_keys);
     for (i = 0; i < n_keys; i++) {
         VALUE rb_sort_options, rb_key;
 
@@ -1333,6 +2881,7 @@ rb_grn_table_group (int argc, VALUE *argv, VALUE self)
             }
             rb_key = resolved_rb_key;
         }
+        rb_ary_push(rb_resolved_keys, rb_key);
         keys[i].key = RVAL2GRNOBJECT(rb_key, &context);
         keys[i].flags = 0;
     }
@@ -1357,9 +2906,22 @@ rb_grn_table_group (int argc, VALUE *argv, VALUE self)
         rb_ary_push(rb_results, rb_result);
     }
 
-    rc = grn_table_group(context, table, keys, n_keys, results, n_results);
+    data.context = context;
+    data.table = table;
+    data.keys = keys;
+    data.n_keys = n_keys;
+    data.results = results;
+    data.n_results = n_results;
+    data.rc = GRN_SUCCESS;
+    if (rb_grn_context_need_release_gvl(context, rb_release_gvl)) {
+        rb_grn_context_call_without_gvl(context, rb_grn_table_group_raw, &data);
+    } else {
+        rb_grn_table_group_raw(&data);
+    }
+    /* Resolved keys must not be closed by GC while grouping. */
+    RB_GC_GUARD(rb_resolved_keys);
     rb_grn_context_check(context, self);
-    rb_grn_rc_check(rc, self);
+    rb_grn_rc_check(data.rc, self);
 
     if (n_results == 1)
         return rb_ary_pop(rb_results);
@@ -1980,6 +3542,120 @@ rb_grn_table_is_locked (int argc, VALUE *argv, VALUE self)
     return CBOOL2RVAL(grn_obj_is_locked(context, table));
 }
 
+typedef struct _SelectData SelectData;
+struct _SelectData
+{
+    grn_ctx *context;
+    grn_obj *table;
+    grn_obj *expression;
+    grn_obj *result;
+    grn_operator operator;
+};
+
+static void *
+rb_grn_table_select_raw (void *user_data)
+{
+    SelectData *data = user_data;
+
+    grn_table_select(data->context, data->table, data->expression,
+                     data->result, data->operator);
+    return NULL;
+}
+
+static void
+rb_grn_table_select_cache_key_append (VALUE rb_key, VALUE rb_value)
+{
+    char length[32];
+
+    if (NIL_P(rb_value)) {
+        rb_str_cat2(rb_key, "-");
+        return;
+    }
+
+    if (RVAL2CBOOL(rb_obj_is_kind_of(rb_value, rb_cGrnObject))) {
+        rb_value = rb_funcall(rb_value, rb_intern("name"), 0);
+    }
+    rb_value = rb_obj_as_string(rb_value);
+    snprintf(length, sizeof(length), "%ld:", RSTRING_LEN(rb_value));
+    rb_str_cat2(rb_key, length);
+    rb_str_cat(rb_key, RSTRING_PTR(rb_value), RSTRING_LEN(rb_value));
+}
+
+/*
+ * Returns the select cache key for the table and the query or
+ * +nil+ if the select isn't cacheable.
+ *
+ * The key has the database, the table ID and the column cache
+ * generation. So a result isn't shared between databases and
+ * isn't used after the schema is changed. Results of temporary
+ * tables aren't cached because their IDs are reused.
+ */
+static VALUE
+rb_grn_table_select_cache_key (grn_ctx *context, grn_obj *table,
+                               VALUE rb_query, VALUE rb_syntax,
+                               VALUE rb_allow_pragma, VALUE rb_allow_column,
+                               VALUE rb_allow_update,
+                               VALUE rb_allow_leading_not,
+                               VALUE rb_default_column)
+{
+    VALUE rb_key;
+    grn_obj *database;
+    const char *database_path;
+    char prefix[128];
+
+    if (NIL_P(rb_query) || rb_block_given_p())
+        return Qnil;
+    if (!NIL_P(rb_syntax) && !rb_grn_equal_option(rb_syntax, "query"))
+        return Qnil;
+    if (!(table->header.flags & GRN_OBJ_PERSISTENT))
+        return Qnil;
+    database = grn_ctx_db(context);
+    if (!database)
+        return Qnil;
+
+    snprintf(prefix, sizeof(prefix), "%p:%u:%u:",
+             (void *)database,
+             grn_obj_id(context, table),
+             rb_grn_column_cache_generation);
+    rb_key = rb_str_new2(prefix);
+    database_path = grn_obj_path(context, database);
+    rb_grn_table_select_cache_key_append(rb_key,
+                                         database_path ?
+                                         rb_str_new2(database_path) :
+                                         Qnil);
+    rb_grn_table_select_cache_key_append(rb_key,
+                                         rb_funcall(rb_query,
+                                                    rb_intern("strip"), 0));
+    rb_grn_table_select_cache_key_append(rb_key, rb_allow_pragma);
+    rb_grn_table_select_cache_key_append(rb_key, rb_allow_column);
+    rb_grn_table_select_cache_key_append(rb_key, rb_allow_update);
+    rb_grn_table_select_cache_key_append(rb_key, rb_allow_leading_not);
+    rb_grn_table_select_cache_key_append(rb_key, rb_default_column);
+    return rb_key;
+}
+
+static VALUE
+rb_grn_table_select_expression_builder (VALUE self, VALUE rb_name,
+                                        VALUE rb_query, VALUE rb_syntax,
+                                        VALUE rb_allow_pragma,
+                                        VALUE rb_allow_column,
+                                        VALUE rb_allow_update,
+                                        VALUE rb_allow_leading_not,
+                                        VALUE rb_default_column)
+{
+    VALUE builder;
+
+    builder = rb_grn_record_expression_builder_new(self, rb_name);
+    rb_funcall(builder, rb_intern("query="), 1, rb_query);
+    rb_funcall(builder, rb_intern("syntax="), 1, rb_syntax);
+    rb_funcall(builder, rb_intern("allow_pragma="), 1, rb_allow_pragma);
+    rb_funcall(builder, rb_intern("allow_column="), 1, rb_allow_column);
+    rb_funcall(builder, rb_intern("allow_update="), 1, rb_allow_update);
+    rb_funcall(builder, rb_intern("allow_leading_not="), 1, rb_allow_leading_not);
+    rb_funcall(builder, rb_intern("default_column="), 1, rb_default_column);
+    return builder;
+}
+
 /*
  * _table_ からブロックまたは文字列で指定した条件にマッチする
  * レコードを返す。返されたテーブルには +expression+ という特
@@ -2085,6 +3761,13 @@ rb_grn_table_is_locked (int argc, VALUE *argv, VALUE self)
  *
  *     参考: {Groonga::Expression#parse} .
  *
+ *     @option options [Boolean] :release_gvl
+ *       +true+ を指定すると検索中にGVLを解放する。省略した場合は
+ *       {Groonga::Context#release_gvl?} の値を使う。
+ *     @option options [Boolean] :cache (true)
+ *       +false+ を指定すると {Groonga::Context#select_cache_size=}
+ *       で有効にした検索結果のキャッシュを使わない。
+ *
  * @overload select(query, options)
  *   _query_ には「[カラム名]:[演算子][値]」という書式で条件を
  *   指定する。演算子は以下の通り。
@@ -2122,8 +3805,11 @@ rb_grn_table_select (int argc, VALUE *argv, VALUE self)
     VALUE rb_query = Qnil, condition_or_options, options;
     VALUE rb_name, rb_operator, rb_result, rb_syntax;
     VALUE rb_allow_pragma, rb_allow_column, rb_allow_update, rb_allow_leading_not;
-    VALUE rb_default_column;
+    VALUE rb_default_column, rb_release_gvl, rb_cache;
     VALUE rb_expression = Qnil, builder;
+    VALUE rb_cache_key = Qnil;
+    RbGrnSelectCache *cache = NULL;
+    SelectData data;
 
     rb_scan_args(argc, argv, "02", &condition_or_options, &options);
 
@@ -2157,11 +3843,28 @@ rb_grn_table_select (int argc, VALUE *argv, VALUE self)
                         "allow_update", &rb_allow_update,
                         "allow_leading_not", &rb_allow_leading_not,
                         "default_column", &rb_default_column,
+                        "release_gvl", &rb_release_gvl,
+                        "cache", &rb_cache,
                         NULL);
 
     if (!NIL_P(rb_operator))
         operator = NUM2INT(rb_operator);
 
+    if ((NIL_P(rb_cache) || RVAL2CBOOL(rb_cache)) &&
+        NIL_P(rb_result) &&
+        operator == GRN_OP_OR) {
+        cache = rb_grn_context_get_select_cache(context);
+    }
+    if (cache) {
+        rb_cache_key = rb_grn_table_select_cache_key(context, table,
+                                                     rb_query, rb_syntax,
+                                                     rb_allow_pragma,
+                                                     rb_allow_column,
+                                                     rb_allow_update,
+                                                     rb_allow_leading_not,
+                                                     rb_default_column);
+    }
+
     if (NIL_P(rb_result)) {
         result = grn_table_create(context, NULL, 0, NULL,
                                   GRN_TABLE_HASH_KEY | GRN_OBJ_WITH_SUBREC,
@@ -2178,23 +3881,60 @@ rb_grn_table_select (int argc, VALUE *argv, VALUE self)
         result = RVAL2GRNTABLE(rb_result, &context);
     }
 
+    if (!NIL_P(rb_cache_key) &&
+        rb_grn_select_cache_fetch(context, cache,
+                                  RSTRING_PTR(rb_cache_key),
+                                  RSTRING_LEN(rb_cache_key),
+                                  result)) {
+        rb_grn_context_check(context, self);
+        /* The query isn't parsed until the expression is used. */
+        builder = rb_grn_table_select_expression_builder(self, rb_name,
+                                                         rb_query, rb_syntax,
+                                                         rb_allow_pragma,
+                                                         rb_allow_column,
+                                                         rb_allow_update,
+                                                         rb_allow_leading_not,
+                                                         rb_default_column);
+        rb_iv_set(rb_result, "@expression_builder", builder);
+        rb_extend_object(rb_result,
+                         rb_const_get(rb_cGrnTable,
+                                      rb_intern("CachedSelectResult")));
+        return rb_result;
+    }
+
     if (NIL_P(rb_expression)) {
-      builder = rb_grn_record_expression_builder_new(self, rb_name);
-      rb_funcall(builder, rb_intern("query="), 1, rb_query);
-      rb_funcall(builder, rb_intern("syntax="), 1, rb_syntax);
-      rb_funcall(builder, rb_intern("allow_pragma="), 1, rb_allow_pragma);
-      rb_funcall(builder, rb_intern("allow_column="), 1, rb_allow_column);
-      rb_funcall(builder, rb_intern("allow_update="), 1, rb_allow_update);
-      rb_funcall(builder, rb_intern("allow_leading_not="), 1, rb_allow_leading_not);
-      rb_funcall(builder, rb_intern("default_column="), 1, rb_default_column);
-      rb_expression = rb_grn_record_expression_builder_build(builder);
+        builder = rb_grn_table_select_expression_builder(self, rb_name,
+                                                         rb_query, rb_syntax,
+                                                         rb_allow_pragma,
+                                                         rb_allow_column,
+                                                         rb_allow_update,
+                                                         rb_allow_leading_not,
+                                                         rb_default_column);
+        rb_expression = rb_grn_record_expression_builder_build(builder);
     }
     rb_grn_object_deconstruct(RB_GRN_OBJECT(DATA_PTR(rb_expression)),
                               &expression, NULL,
                               NULL, NULL, NULL, NULL);
 
-    grn_table_select(context, table, expression, result, operator);
+    data.context = context;
+    data.table = table;
+    data.expression = expression;
+    data.result = result;
+    data.operator = operator;
+    if (rb_grn_context_need_release_gvl(context, rb_release_gvl)) {
+        rb_grn_context_call_without_gvl(context, rb_grn_table_select_raw,
+                                        &data);
+    } else {
+        rb_grn_table_select_raw(&data);
+    }
+    RB_GC_GUARD(rb_expression);
     rb_grn_context_check(context, self);
+    if (!NIL_P(rb_cache_key)) {
+        rb_grn_select_cache_store(context, cache,
+                                  RSTRING_PTR(rb_cache_key),
+                                  RSTRING_LEN(rb_cache_key),
+                                  result);
+    }
 
     rb_attr(rb_singleton_class(rb_result),
             rb_intern("expression"),
@@ -2456,6 +4196,7 @@ rb_grn_table_rename (VALUE self, VALUE rb_name)
     rc = grn_table_rename(context, table, name, name_size);
     rb_grn_context_check(context, self);
     rb_grn_rc_check(rc, self);
+    rb_grn_table_expire_column_caches(context, table);
 
     return self;
 }
@@ -2464,6 +4205,7 @@ void
 rb_grn_init_table (VALUE mGrn)
 {
     id_array_reference = rb_intern("[]");
+    id_class_for = rb_intern("class_for");
     id_array_set = rb_intern("[]=");
 
     rb_cGrnTable = rb_define_class_under(mGrn, "Table", rb_cGrnObject);
@@ -2485,6 +4227,10 @@ rb_grn_init_table (VALUE mGrn)
                      rb_grn_table_get_columns, -1);
     rb_define_method(rb_cGrnTable, "have_column?",
                      rb_grn_table_have_column, 1);
+    rb_define_method(rb_cGrnTable, "record_class",
+                     rb_grn_table_get_record_class, 0);
+    rb_define_singleton_method(rb_cGrnTable, "column_cache_generation",
+                               rb_grn_table_s_get_column_cache_generation, 0);
 
     rb_define_method(rb_cGrnTable, "open_cursor", rb_grn_table_open_cursor, -1);
     rb_define_method(rb_cGrnTable, "records", rb_grn_table_get_records, -1);
@@ -2494,6 +4240,13 @@ rb_grn_init_table (VALUE mGrn)
     rb_define_method(rb_cGrnTable, "truncate", rb_grn_table_truncate, 0);
 
     rb_define_method(rb_cGrnTable, "each", rb_grn_table_each, -1);
+    rb_define_method(rb_cGrnTable, "each_id", rb_grn_table_each_id, -1);
+    rb_define_method(rb_cGrnTable, "each_id_slice",
+                     rb_grn_table_each_id_slice, -1);
+    rb_define_method(rb_cGrnTable, "fetch_columns",
+                     rb_grn_table_fetch_columns, -1);
+    rb_define_method(rb_cGrnTable, "load_columns",
+                     rb_grn_table_load_columns, 2);
 
     rb_define_method(rb_cGrnTable, "each_sub_record",
                      rb_grn_table_each_sub_record, 1);
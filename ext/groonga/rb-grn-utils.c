@@ -91,54 +91,153 @@ rb_grn_inspect_type (unsigned char type)
     }
 }
 
+#define RB_GRN_OPTION_KEY_CACHE_SIZE 512
+
+typedef struct _RbGrnOptionKeyCacheEntry
+{
+    const char *key;
+    ID id;
+} RbGrnOptionKeyCacheEntry;
+
+/*
+ * Option keys are passed as string literals. So the address of a
+ * key is used as the cache key of its interned ID.
+ */
+static RbGrnOptionKeyCacheEntry
+rb_grn_option_key_cache[RB_GRN_OPTION_KEY_CACHE_SIZE];
+
+static ID
+rb_grn_option_key_to_id (const char *key)
+{
+    RbGrnOptionKeyCacheEntry *entry;
+
+    entry = &(rb_grn_option_key_cache[(((VALUE)key) >> 3) %
+                                      RB_GRN_OPTION_KEY_CACHE_SIZE]);
+    if (entry->key != key) {
+        entry->id = rb_intern(key);
+        entry->key = key;
+    }
+    return entry->id;
+}
+
+static grn_bool
+rb_grn_hash_lookup (VALUE hash, VALUE key, VALUE *value)
+{
+#ifdef HAVE_RB_HASH_LOOKUP2
+    *value = rb_hash_lookup2(hash, key, Qundef);
+    return *value != Qundef;
+#else
+    st_data_t data;
+
+    if (!RHASH_TBL(hash))
+        return GRN_FALSE;
+    if (!st_lookup(RHASH_TBL(hash), (st_data_t)key, &data))
+        return GRN_FALSE;
+    *value = (VALUE)data;
+    return GRN_TRUE;
+#endif
+}
+
+static void
+rb_grn_scan_options_raise_unexpected_keys (VALUE options, va_list args)
+{
+    VALUE unexpected_options;
+    VALUE available_keys;
+    const char *key;
+
+    unexpected_options = rb_funcall(options, rb_intern("dup"), 0);
+    available_keys = rb_ary_new();
+    key = va_arg(args, const char *);
+    while (key) {
+        VALUE rb_key;
+
+        (void)va_arg(args, VALUE *);
+        rb_key = ID2SYM(rb_grn_option_key_to_id(key));
+        rb_ary_push(available_keys, rb_key);
+        if (NIL_P(rb_hash_delete(unexpected_options, rb_key)))
+            rb_hash_delete(unexpected_options, rb_str_new_cstr(key));
+        key = va_arg(args, const char *);
+    }
+
+    rb_raise(rb_eArgError,
+             "unexpected key(s) exist: %s: available keys: %s",
+             rb_grn_inspect(rb_funcall(unexpected_options, rb_intern("keys"), 0)),
+             rb_grn_inspect(available_keys));
+}
+
+/*
+ * Scans _options_ by keys and value pointers terminated by NULL.
+ * Symbol and String keys are accepted. Symbol keys are looked up
+ * first. _options_ isn't changed.
+ *
+ * It doesn't allocate any object when _options_ is +nil+ or a
+ * Hash that has only known Symbol keys. It is the common case.
+ */
 void
 rb_grn_scan_options (VALUE options, ...)
 {
     VALUE original_options = options;
-    VALUE available_keys;
     const char *key;
     VALUE *value;
     va_list args;
+    long n_options;
+    long n_found_options = 0;
+    grn_bool need_string_lookup = GRN_FALSE;
 
-    options = rb_grn_check_convert_to_hash(options);
     if (NIL_P(options)) {
-        if (NIL_P(original_options)) {
-            options = rb_hash_new();
-        } else {
+        n_options = 0;
+    } else {
+        options = rb_grn_check_convert_to_hash(options);
+        if (NIL_P(options)) {
             rb_raise(rb_eArgError,
                      "options must be Hash: %s",
                      rb_grn_inspect(original_options));
         }
-    } else if (options == original_options) {
-        options = rb_funcall(options, rb_intern("dup"), 0);
+        n_options = RHASH_SIZE(options);
     }
 
-    available_keys = rb_ary_new();
     va_start(args, options);
     key = va_arg(args, const char *);
     while (key) {
-        VALUE rb_key;
         value = va_arg(args, VALUE *);
-
-        rb_key = RB_GRN_INTERN(key);
-        rb_ary_push(available_keys, rb_key);
-        *value = rb_funcall(options, rb_intern("delete"), 1, rb_key);
-        if (NIL_P(*value)) {
-            rb_key = rb_str_new_cstr(key);
-            *value = rb_funcall(options, rb_intern("delete"), 1, rb_key);
+        *value = Qnil;
+        if (n_options > 0) {
+            if (rb_grn_hash_lookup(options,
+                                   ID2SYM(rb_grn_option_key_to_id(key)),
+                                   value)) {
+                n_found_options++;
+            } else {
+                *value = Qnil;
+                need_string_lookup = GRN_TRUE;
+            }
         }
-
         key = va_arg(args, const char *);
     }
     va_end(args);
 
-    if (RVAL2CBOOL(rb_funcall(options, rb_intern("empty?"), 0)))
+    if (n_found_options == n_options)
         return;
 
-    rb_raise(rb_eArgError,
-             "unexpected key(s) exist: %s: available keys: %s",
-             rb_grn_inspect(rb_funcall(options, rb_intern("keys"), 0)),
-             rb_grn_inspect(available_keys));
+    if (need_string_lookup) {
+        va_start(args, options);
+        key = va_arg(args, const char *);
+        while (key) {
+            value = va_arg(args, VALUE *);
+            if (NIL_P(*value) &&
+                rb_grn_hash_lookup(options, rb_str_new_cstr(key), value)) {
+                n_found_options++;
+            }
+            key = va_arg(args, const char *);
+        }
+        va_end(args);
+
+        if (n_found_options == n_options)
+            return;
+    }
+
+    va_start(args, options);
+    rb_grn_scan_options_raise_unexpected_keys(options, args);
+    va_end(args);
 }
 
 grn_bool
@@ -171,6 +270,49 @@ rb_grn_equal_string (const char *string1, const char *string2)
     return strcmp(string1, string2) == 0;
 }
 
+/*
+ * Returns the byte length of the UTF-8 character at _string_. 0 is
+ * returned for an invalid byte sequence.
+ */
+int
+rb_grn_utf8_char_length (const unsigned char *string,
+                         unsigned int rest_length)
+{
+    unsigned char first = string[0];
+    int i, length;
+
+    if (first < 0x80) {
+        return 1;
+    } else if (first < 0xc2) {
+        return 0;
+    } else if (first < 0xe0) {
+        length = 2;
+    } else if (first < 0xf0) {
+        length = 3;
+    } else if (first < 0xf5) {
+        length = 4;
+    } else {
+        return 0;
+    }
+
+    if (rest_length < (unsigned int)length)
+        return 0;
+    for (i = 1; i < length; i++) {
+        if ((string[i] & 0xc0) != 0x80)
+            return 0;
+    }
+    if (first == 0xe0 && string[1] < 0xa0)
+        return 0;
+    if (first == 0xed && string[1] > 0x9f)
+        return 0;
+    if (first == 0xf0 && string[1] < 0x90)
+        return 0;
+    if (first == 0xf4 && string[1] > 0x8f)
+        return 0;
+
+    return length;
+}
+
 VALUE
 rb_grn_convert_to_array (VALUE object)
 {
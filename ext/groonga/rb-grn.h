@@ -27,6 +27,9 @@
 #ifdef HAVE_RUBY_INTERN_H
 #  include <ruby/intern.h>
 #endif
+#ifdef HAVE_RUBY_THREAD_H
+#  include <ruby/thread.h>
+#endif
 
 #ifndef RETURN_ENUMERATOR
 #  define RETURN_ENUMERATOR(obj, argc, argv)
@@ -40,6 +43,10 @@
 #  define NUM2USHORT(object) NUM2UINT(object)
 #endif
 
+#ifndef RB_GC_GUARD
+#  define RB_GC_GUARD(object) (*(volatile VALUE *)&(object))
+#endif
+
 #ifndef HAVE_RB_SYM2STR
 #  define rb_sym2str(symbol) (rb_id2str(SYM2ID(symbol)))
 #endif
@@ -113,6 +120,22 @@ RB_GRN_BEGIN_DECLS
 #define RB_GRN_UNBIND_FUNCTION(function) ((RbGrnUnbindFunction)(function))
 
 typedef void (*RbGrnUnbindFunction) (void *object);
+typedef void *(*RbGrnCallFunction) (void *data);
+typedef void (*RbGrnUnblockFunction) (void *data);
+
+typedef struct _RbGrnSelectCacheEntry RbGrnSelectCacheEntry;
+typedef struct _RbGrnSelectCache RbGrnSelectCache;
+struct _RbGrnSelectCache
+{
+    grn_hash *entries;
+    RbGrnSelectCacheEntry *newest;
+    RbGrnSelectCacheEntry *oldest;
+    unsigned int size;
+    unsigned int max_size;
+    uint64_t n_hits;
+    uint64_t n_misses;
+    uint64_t n_evictions;
+};
 
 typedef struct _RbGrnContext RbGrnContext;
 struct _RbGrnContext
@@ -121,6 +144,9 @@ struct _RbGrnContext
     grn_ctx context_entity;
     grn_hash *floating_objects;
     VALUE self;
+    grn_bool release_gvl;
+    grn_bool connected;
+    RbGrnSelectCache *select_cache;
 };
 
 typedef struct _RbGrnObject RbGrnObject;
@@ -153,6 +179,10 @@ struct _RbGrnTable
     RbGrnObject parent;
     grn_obj *value;
     VALUE columns;
+    grn_hash *column_cache;
+    unsigned int column_cache_generation;
+    VALUE record_class;
+    unsigned int record_class_generation;
 };
 
 typedef struct _RbGrnTableKeySupport RbGrnTableKeySupport;
@@ -274,6 +304,7 @@ RB_GRN_VAR VALUE rb_cGrnTokyoGeoPoint;
 RB_GRN_VAR VALUE rb_cGrnWGS84GeoPoint;
 RB_GRN_VAR VALUE rb_cGrnRecord;
 RB_GRN_VAR VALUE rb_cGrnLogger;
+RB_GRN_VAR VALUE rb_cGrnNativeQueryLogger;
 RB_GRN_VAR VALUE rb_cGrnSnippet;
 RB_GRN_VAR VALUE rb_cGrnVariable;
 RB_GRN_VAR VALUE rb_cGrnOperator;
@@ -282,6 +313,7 @@ RB_GRN_VAR VALUE rb_cGrnRecordExpressionBuilder;
 RB_GRN_VAR VALUE rb_cGrnColumnExpressionBuilder;
 RB_GRN_VAR VALUE rb_cGrnPlugin;
 RB_GRN_VAR VALUE rb_cGrnNormalizer;
+RB_GRN_VAR VALUE rb_cGrnTableDumper;
 
 void           rb_grn_init_utils                    (VALUE mGrn);
 void           rb_grn_init_exception                (VALUE mGrn);
@@ -320,9 +352,12 @@ void           rb_grn_init_expression               (VALUE mGrn);
 void           rb_grn_init_expression_builder       (VALUE mGrn);
 void           rb_grn_init_logger                   (VALUE mGrn);
 void           rb_grn_init_query_logger             (VALUE mGrn);
+void           rb_grn_init_native_query_logger      (VALUE mGrn);
 void           rb_grn_init_snippet                  (VALUE mGrn);
 void           rb_grn_init_plugin                   (VALUE mGrn);
 void           rb_grn_init_normalizer               (VALUE mGrn);
+void           rb_grn_init_table_dumper             (VALUE mGrn);
+void           rb_grn_init_record_serializer        (VALUE mGrn);
 
 VALUE          rb_grn_rc_to_exception               (grn_rc rc);
 const char    *rb_grn_rc_to_message                 (grn_rc rc);
@@ -349,6 +384,50 @@ grn_obj       *rb_grn_context_get_backward_compatibility
                                                      unsigned int name_size);
 void           rb_grn_context_object_created        (VALUE rb_context,
                                                      VALUE rb_object);
+grn_bool       rb_grn_context_need_release_gvl      (grn_ctx *context,
+                                                     VALUE rb_release_gvl);
+void          *rb_grn_context_call_without_gvl      (grn_ctx *context,
+                                                     RbGrnCallFunction function,
+                                                     void *data);
+void          *rb_grn_context_call_without_gvl_full (grn_ctx *context,
+                                                     RbGrnCallFunction function,
+                                                     void *data,
+                                                     RbGrnUnblockFunction unblock_function,
+                                                     void *unblock_data);
+void          *rb_grn_context_call_without_gvl_defer_interrupts
+                                                    (grn_ctx *context,
+                                                     RbGrnCallFunction function,
+                                                     void *data,
+                                                     RbGrnUnblockFunction unblock_function,
+                                                     void *unblock_data);
+void          *rb_grn_context_call_with_gvl         (grn_ctx *context,
+                                                     RbGrnCallFunction function,
+                                                     void *data);
+RbGrnSelectCache *rb_grn_context_get_select_cache (grn_ctx *context);
+
+RbGrnSelectCache *rb_grn_select_cache_new           (grn_ctx *context,
+                                                     unsigned int max_size);
+void           rb_grn_select_cache_free             (grn_ctx *context,
+                                                     RbGrnSelectCache *cache);
+void           rb_grn_select_cache_set_max_size     (grn_ctx *context,
+                                                     RbGrnSelectCache *cache,
+                                                     unsigned int max_size);
+void           rb_grn_select_cache_clear            (grn_ctx *context,
+                                                     RbGrnSelectCache *cache);
+grn_bool       rb_grn_select_cache_fetch            (grn_ctx *context,
+                                                     RbGrnSelectCache *cache,
+                                                     const char *key,
+                                                     unsigned int key_size,
+                                                     grn_obj *result);
+void           rb_grn_select_cache_store            (grn_ctx *context,
+                                                     RbGrnSelectCache *cache,
+                                                     const char *key,
+                                                     unsigned int key_size,
+                                                     grn_obj *result);
+
+grn_query_logger *rb_grn_native_query_logger_get_query_logger
+                                                    (VALUE object,
+                                                     unsigned int flags);
 
 const char    *rb_grn_inspect                       (VALUE object);
 const char    *rb_grn_inspect_type                  (unsigned char type);
@@ -358,6 +437,8 @@ grn_bool       rb_grn_equal_option                  (VALUE option,
                                                      const char *key);
 grn_bool       rb_grn_equal_string                  (const char *string1,
                                                      const char *string2);
+int            rb_grn_utf8_char_length              (const unsigned char *string,
+                                                     unsigned int rest_length);
 VALUE          rb_grn_convert_to_array              (VALUE object);
 VALUE          rb_grn_check_convert_to_string       (VALUE object);
 VALUE          rb_grn_check_convert_to_array        (VALUE object);
@@ -432,6 +513,8 @@ void           rb_grn_table_bind                    (RbGrnTable *rb_grn_table,
 void           rb_grn_table_finalizer               (grn_ctx *context,
                                                      grn_obj *grn_object,
                                                      RbGrnTable *rb_grn_table);
+void           rb_grn_table_expire_column_caches    (grn_ctx *context,
+                                                     grn_obj *object);
 void           rb_grn_table_deconstruct             (RbGrnTable *rb_grn_table,
                                                      grn_obj **table,
                                                      grn_ctx **context,
@@ -455,6 +538,7 @@ VALUE          rb_grn_table_get_value               (VALUE self,
 VALUE          rb_grn_table_set_value               (VALUE self,
                                                      VALUE rb_id,
                                                      VALUE rb_value);
+VALUE          rb_grn_table_get_record_class        (VALUE self);
 VALUE          rb_grn_table_get_column              (VALUE self,
                                                      VALUE rb_name);
 VALUE          rb_grn_table_get_column_surely       (VALUE self,
@@ -587,6 +671,8 @@ VALUE          rb_grn_record_new_added              (VALUE table,
 VALUE          rb_grn_record_new_raw                (VALUE table,
                                                      VALUE id,
                                                      VALUE values);
+VALUE          rb_grn_record_reuse                  (VALUE record,
+                                                     grn_id id);
 
 VALUE          rb_grn_record_expression_builder_new (VALUE table,
                                                      VALUE name);
@@ -186,7 +186,10 @@ Init_groonga (void)
     rb_grn_init_expression_builder(mGrn);
     rb_grn_init_logger(mGrn);
     rb_grn_init_query_logger(mGrn);
+    rb_grn_init_native_query_logger(mGrn);
     rb_grn_init_snippet(mGrn);
     rb_grn_init_plugin(mGrn);
     rb_grn_init_normalizer(mGrn);
+    rb_grn_init_table_dumper(mGrn);
+    rb_grn_init_record_serializer(mGrn);
 }
@@ -90,10 +90,13 @@ module Groonga
 end
 
 require "groonga/context"
+require "groonga/connection-pool"
 require "groonga/statistic-measurer"
 require "groonga/database"
 require "groonga/table"
 require "groonga/column"
+require "groonga/profiler"
+require "groonga/prepared-expression"
 require "groonga/patricia-trie"
 require "groonga/index-column"
 require "groonga/dumper"
@@ -0,0 +1,276 @@
+# -*- coding: utf-8 -*-
+#
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+require "thread"
+require "timeout"
+
+module Groonga
+  # It manages contexts connected to a groonga server. Threads
+  # share connected contexts by checking out a context and checking
+  # it in after they use it.
+  #
+  # @example Share connections between threads
+  #   pool = Groonga::ConnectionPool.new(:host => "192.168.0.1",
+  #                                      :size => 4)
+  #   threads = 8.times.collect do
+  #     Thread.new do
+  #       pool.with_connection do |context|
+  #         context.select("Entries", :query => "groonga")
+  #       end
+  #     end
+  #   end
+  #   threads.each(&:join)
+  #   pool.close
+  #
+  # @since 4.0.5
+  class ConnectionPool
+    # It is raised when no context can be checked out in
+    # +:timeout+ seconds.
+    class TimeoutError < Error
+    end
+
+    # It is raised when a closed pool is used.
+    class ClosedError < Error
+    end
+
+    # @return [Integer] The max number of connected contexts.
+    attr_reader :size
+
+    # @param [::Hash] options The name and value
+    #   pairs. Omitted names are initialized as the default value.
+    # @option options [String] :host ("localhost") The host name or
+    #   IP address of the groonga server.
+    # @option options [Integer] :port (10041) The port number of the
+    #   groonga server.
+    # @option options [Integer] :size (5) The max number of connected
+    #   contexts.
+    # @option options [Numeric] :timeout (5) The max seconds to wait
+    #   for a checked in context when all contexts are checked out.
+    # @option options [Numeric] :idle_timeout (nil) Contexts that are
+    #   not checked out in the seconds are closed by {#reap}. If it
+    #   is +nil+, idle contexts aren't closed.
+    # @option options [Numeric] :health_check_interval (30) A context
+    #   that is not checked out in the seconds is checked by the
+    #   +status+ command before it is checked out. A broken context
+    #   is replaced with a new context.
+    # @option options [Numeric] :health_check_timeout (1) The max
+    #   seconds to wait for the response of the +status+ command. A
+    #   context that doesn't respond in the seconds is replaced with
+    #   a new context.
+    # @option options [::Hash] :context_options ({}) The options
+    #   passed to {Groonga::Context.new}.
+    def initialize(options={})
+      @host = options[:host] || "localhost"
+      @port = options[:port] || 10041
+      @size = options[:size] || 5
+      @timeout = options[:timeout] || 5
+      @idle_timeout = options[:idle_timeout]
+      @health_check_interval = options[:health_check_interval] || 30
+      @health_check_timeout = options[:health_check_timeout] || 1
+      @context_options = options[:context_options] || {}
+      @mutex = Mutex.new
+      @condition = ConditionVariable.new
+      @idle_connections = []
+      @n_connections = 0
+      @closed = false
+    end
+
+    # Checks out a connected context. It connects to the groonga
+    # server when there is no idle context and the number of
+    # contexts is less than {#size}. Otherwise it waits until a
+    # context is checked in.
+    #
+    # You must check in the context by {#checkin} after you use it.
+    #
+    # @return [Groonga::Context] The connected context.
+    # @raise [Groonga::ConnectionPool::TimeoutError] If no context
+    #   is checked in in +:timeout+ seconds.
+    def checkout
+      deadline = Time.now + @timeout
+      loop do
+        context, checked_in_time = reserve(deadline)
+        return connect if context.nil?
+        healthy = false
+        begin
+          healthy = healthy?(context, checked_in_time)
+        ensure
+          discard(context) unless healthy
+        end
+        return context if healthy
+      end
+    end
+
+    # Checks in a context checked out by {#checkout}.
+    #
+    # @param [Groonga::Context] context The checked out context.
+    # @return [void]
+    def checkin(context)
+      closed = @mutex.synchronize do
+        unless @closed
+          @idle_connections.push([context, Time.now])
+          @condition.signal
+        end
+        @closed
+      end
+      discard(context) if closed
+      reap
+    end
+
+    # Checks out a context, yields it and checks in it.
+    #
+    # If an exception except {Groonga::Error} is raised in the
+    # block, the context is closed instead of being checked in
+    # because it may have a response that isn't received yet.
+    #
+    # @yield [context]
+    # @yieldparam context [Groonga::Context] The connected context.
+    # @return [Object] The value returned by the block.
+    def with_connection
+      context = checkout
+      begin
+        result = yield(context)
+      rescue Error
+        checkin(context)
+        raise
+      rescue Exception
+        discard(context)
+        raise
+      end
+      checkin(context)
+      result
+    end
+
+    # Closes contexts that aren't checked out in +:idle_timeout+
+    # seconds.
+    #
+    # @return [Integer] The number of closed contexts.
+    def reap
+      return 0 if @idle_timeout.nil?
+      threshold = Time.now - @idle_timeout
+      reaped_contexts = @mutex.synchronize do
+        idle_contexts = @idle_connections.select do |_, checked_in_time|
+          checked_in_time <= threshold
+        end
+        @idle_connections -= idle_contexts
+        idle_contexts.collect(&:first)
+      end
+      reaped_contexts.each do |context|
+        discard(context)
+      end
+      reaped_contexts.size
+    end
+
+    # Closes all idle contexts. Contexts that are checked out are
+    # closed when they are checked in.
+    #
+    # @return [void]
+    def close
+      idle_contexts = @mutex.synchronize do
+        @closed = true
+        @condition.broadcast
+        contexts = @idle_connections.collect(&:first)
+        @idle_connections.clear
+        contexts
+      end
+      idle_contexts.each do |context|
+        discard(context)
+      end
+    end
+
+    # @return [Boolean] +true+ if {#close} is called, +false+
+    #   otherwise.
+    def closed?
+      @closed
+    end
+
+    # @return [Integer] The number of connected contexts including
+    #   checked out contexts.
+    def n_connections
+      @mutex.synchronize do
+        @n_connections
+      end
+    end
+
+    # @return [Integer] The number of contexts that aren't checked out.
+    def n_idle_connections
+      @mutex.synchronize do
+        @idle_connections.size
+      end
+    end
+
+    private
+    def reserve(deadline)
+      @mutex.synchronize do
+        loop do
+          raise ClosedError, "connection pool is closed" if @closed
+          return @idle_connections.pop unless @idle_connections.empty?
+          if @n_connections < @size
+            @n_connections += 1
+            return nil
+          end
+          rest = deadline - Time.now
+          if rest <= 0
+            message = "no connection is checked in in #{@timeout} seconds: "
+            message << "<#{@host}:#{@port}>"
+            raise TimeoutError, message
+          end
+          @condition.wait(@mutex, rest)
+        end
+      end
+    end
+
+    def connect
+      context = Context.new(@context_options)
+      begin
+        context.connect(:host => @host, :port => @port)
+      rescue Exception
+        context.close
+        release
+        raise
+      end
+      context
+    end
+
+    def healthy?(context, checked_in_time)
+      return true if Time.now - checked_in_time < @health_check_interval
+      begin
+        Timeout.timeout(@health_check_timeout) do
+          context.send("status")
+          _, response = context.receive
+          not response.nil?
+        end
+      rescue Error, Timeout::Error
+        false
+      end
+    end
+
+    def discard(context)
+      begin
+        context.close
+      rescue Error
+      end
+      release
+    end
+
+    def release
+      @mutex.synchronize do
+        @n_connections -= 1
+        @condition.signal
+      end
+    end
+  end
+end
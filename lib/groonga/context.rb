@@ -17,6 +17,7 @@
 
 require "groonga/memory-pool"
 require "groonga/context/command-executor"
+require "groonga/context/restore-progress"
 
 module Groonga
   class Context
@@ -136,8 +137,152 @@ module Groonga
     end
 
     def execute_command(name, parameters={})
-      executor = CommandExecutor.new(self)
-      executor.execute(name, parameters)
+      command_executor.execute(name, parameters)
+    end
+
+    # Sends a command without waiting for its response. You can send
+    # other commands before the response is received. Responses are
+    # dispatched to the returned futures in the order of sent commands.
+    #
+    # It is useful for a context connected to a groonga server by
+    # {#connect}. The connected context waits for responses without
+    # the GVL.
+    #
+    # @example Search and drilldown concurrently
+    #   context.connect(:host => "192.168.0.1")
+    #   select = context.execute_command_async("select",
+    #                                          :table => "Entries",
+    #                                          :query => "groonga")
+    #   tags = context.execute_command_async("select",
+    #                                        :table => "Tags",
+    #                                        :limit => 5)
+    #   p select.value.n_hits
+    #   p tags.value.n_hits
+    #
+    # @param [String] name The command name.
+    # @param [::Hash] parameters The parameters of the command.
+    # @yield [response]
+    #   Yields the response when it is received if block is
+    #   given. It is called while any future of the context is waited.
+    # @yieldparam response [Groonga::Client::Response::Base]
+    #   The response of the command.
+    # @return [Groonga::Context::CommandFuture] The future of the response.
+    #
+    # @since 4.0.5
+    def execute_command_async(name, parameters={}, &callback)
+      command_executor.execute_async(name, parameters, &callback)
+    end
+
+    # Waits for all responses of commands sent by
+    # {#execute_command_async}.
+    #
+    # @return [void]
+    #
+    # @since 4.0.5
+    def wait_commands
+      command_executor.wait_all
+    end
+
+    # Returns the max number of prepared expressions cached by
+    # {Groonga::Table#prepare} with a query string.
+    #
+    # @return [Integer] The max number of cached prepared
+    #   expressions. The default is 100.
+    #
+    # @since 4.0.5
+    def prepared_expression_cache_size
+      prepared_expressions.max_size
+    end
+
+    # Sets the max number of prepared expressions cached by
+    # {Groonga::Table#prepare} with a query string. The least
+    # recently used prepared expression is evicted when the number
+    # of cached prepared expressions exceeds it.
+    #
+    # @param size [Integer] The max number of cached prepared
+    #   expressions. +0+ disables the cache.
+    #
+    # @since 4.0.5
+    def prepared_expression_cache_size=(size)
+      prepared_expressions.max_size = size
+    end
+
+    # @private
+    def prepared_expressions
+      @prepared_expressions ||= PreparedExpression::Cache.new
+    end
+
+    # @return [Groonga::Profiler, nil] The running profiler. It is
+    #   +nil+ when the context isn't profiled.
+    #
+    # @since 4.0.5
+    attr_reader :profiler
+
+    # Starts profiling operations in the context. Profiling is
+    # stopped by {#stop_profile}.
+    #
+    # @example Report slow operations
+    #   context.start_profile do |operation|
+    #     if operation.elapsed_time > 0.1
+    #       $stderr.puts(operation.to_hash.to_json)
+    #     end
+    #   end
+    #
+    # @yield [operation] It is called with each finished top level
+    #   operation if block is given.
+    # @yieldparam operation [Groonga::Profiler::Operation] The
+    #   finished operation.
+    # @return [Groonga::Profiler] The started profiler.
+    #
+    # @see Groonga::Profiler
+    #
+    # @since 4.0.5
+    def start_profile(&callback)
+      Profiler.install if @profiler.nil?
+      @profiler = Profiler.new(callback)
+    end
+
+    # Stops profiling started by {#start_profile}.
+    #
+    # @return [Groonga::Profiler, nil] The stopped profiler.
+    #
+    # @since 4.0.5
+    def stop_profile
+      profiler = @profiler
+      @profiler = nil
+      Profiler.uninstall if profiler
+      profiler
+    end
+
+    # Profiles operations in the given block.
+    #
+    # @example Dump a trace as JSON
+    #   profiler = context.profile do
+    #     entries.select {|record| record.content =~ "groonga"}
+    #   end
+    #   puts(profiler.to_json)
+    #
+    # @param [::Hash] options The name and value
+    #   pairs. Omitted names are initialized as the default value.
+    # @option options [Proc] :callback (nil) It is called with each
+    #   finished top level operation.
+    # @yield [] Runs profiled operations.
+    # @return [Groonga::Profiler] The profiler that has the trace.
+    #
+    # @since 4.0.5
+    def profile(options={})
+      previous_profiler = @profiler
+      profiler = start_profile(&options[:callback])
+      begin
+        yield
+      ensure
+        if previous_profiler
+          @profiler = previous_profiler
+        else
+          stop_profile
+        end
+      end
+      profiler
     end
 
     # Restore commands dumped by "grndump" command.
@@ -159,40 +304,67 @@ module Groonga
     #     puts("#{command} -> #{response}")
     #   end
     #
+    # If the context is connected to a groonga server by {#connect},
+    # you can send multiple commands without waiting their responses
+    # by +:window+ option. It reduces waiting time for network round
+    # trip.
+    #
+    # @example Restore dumped commands to a groonga server in pipeline
+    #   context.connect(:host => "192.168.0.1")
+    #   progress = lambda do |progress|
+    #     puts("#{progress.n_received_responses}: #{progress.throughput}")
+    #   end
+    #   File.open("dump.grn") do |file|
+    #     context.restore(file, :window => 16, :progress => progress)
+    #   end
+    #
     # @param [#each_line] dumped_commands commands dumped by grndump.
     #   It can be a String object or any objects like an IO object such
     #   as a File object. It should have #each_line that iterates a
     #   line.
+    # @param [::Hash] options The name and value
+    #   pairs. Omitted names are initialized as the default value.
+    # @option options [Integer] :window (1) The max number of commands
+    #   that are sent but their responses aren't received yet. It is
+    #   used only when the context is connected to a groonga
+    #   server. Responses are received in the order of sent commands.
+    #   It is available since 4.0.5.
+    # @option options [#call] :progress (nil) It is called with a
+    #   {Groonga::Context::RestoreProgress} after each response is
+    #   received. It is available since 4.0.5.
     # @yield [command, response]
     #   Yields a sent command and its response if block is given.
     # @yieldparam command [String] A sent command.
     # @yieldparam response [String] A response for a command.
     # @return [void]
-    def restore(dumped_commands)
+    def restore(dumped_commands, options={}, &block)
+      window = options[:window] || 1
+      window = 1 unless connected?
+      progress = RestoreProgress.new
+      progress_callback = options[:progress]
+      pending_commands = []
       buffer = ""
-      continued = false
       dumped_commands.each_line do |line|
         line = line.chomp
         case line
         when /\\\z/
-          continued = true
           buffer << $PREMATCH
         else
-          continued = false
           buffer << line
-          send(buffer)
-          _, response = receive
-          if block_given?
-            not_shared_command = continued ? buffer.dup : line
-            yield(not_shared_command, response)
+          while pending_commands.size >= window
+            receive_restore_response(pending_commands,
+                                     progress, progress_callback, &block)
           end
+          send_restore_command(buffer.dup, pending_commands, progress)
           buffer.clear
         end
       end
       unless buffer.empty?
-        send(buffer)
-        _, response = receive
-        yield(buffer.dup, response) if block_given?
+        send_restore_command(buffer.dup, pending_commands, progress)
+      end
+      until pending_commands.empty?
+        receive_restore_response(pending_commands,
+                                 progress, progress_callback, &block)
       end
     end
 
@@ -315,5 +487,26 @@ module Groonga
       memory_pool = @memory_pools.last
       memory_pool.register(object)
     end
+
+    private
+    def command_executor
+      @command_executor ||= CommandExecutor.new(self)
+    end
+
+    def send_restore_command(command, pending_commands, progress)
+      send(command)
+      progress.sent(command)
+      pending_commands << command
+    end
+
+    def receive_restore_response(pending_commands, progress, progress_callback)
+      # GQTP doesn't return query ID. Responses are returned in the
+      # order of sent commands.
+      _, response = receive
+      command = pending_commands.shift
+      progress.received
+      progress_callback.call(progress) if progress_callback
+      yield(command, response) if block_given?
+    end
   end
 end
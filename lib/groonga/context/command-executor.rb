@@ -15,41 +15,107 @@
 # License along with this library; if not, write to the Free Software
 # Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
+require "thread"
+
 require "groonga/command"
 require "groonga/client/response"
+require "groonga/context/command-future"
 
 module Groonga
   class Context
     class CommandExecutor
       def initialize(context)
         @context = context
+        @mutex = Mutex.new
+        @receive_mutex = Mutex.new
+        @futures = []
       end
 
       def execute(name, parameters={})
+        execute_async(name, parameters).value
+      end
+
+      def execute_async(name, parameters={}, &callback)
         parameters = normalize_parameters(name, parameters)
         command_class = Command.find(name)
         command = command_class.new(name, parameters)
-        request_id = @context.send(command.to_command_format)
-        loop do
-          response_id, raw_response = @context.receive
-          if request_id == response_id
-            response_class = Client::Response.find(command.name)
-            header = [0, 0, 0]
-            case command.output_type
-            when :json
-              body = JSON.parse(raw_response)
-            else
-              body = raw_response
+        future = @mutex.synchronize do
+          request_id = @context.send(command.to_command_format)
+          future = CommandFuture.new(self, request_id, command, callback)
+          @futures << future
+          # A local context concatenates outputs of commands that
+          # aren't received yet. So we receive it immediately.
+          receive_response unless @context.connected?
+          future
+        end
+        future.call_callback if future.resolved?
+        future
+      end
+
+      def wait_all
+        futures = @mutex.synchronize do
+          @futures.dup
+        end
+        futures.each(&:wait)
+      end
+
+      # @private
+      def wait(future)
+        until future.resolved?
+          resolved_future = @receive_mutex.synchronize do
+            next if future.resolved?
+            # @mutex isn't locked while a response is waited. So
+            # other threads can send commands meanwhile.
+            @context.wait_response
+            @mutex.synchronize do
+              receive_response unless future.resolved?
             end
-            response = response_class.new(command, header, body)
-            response.raw = raw_response
-            return response
           end
-          # raise if request_id < response_id
+          resolved_future.call_callback if resolved_future
         end
       end
 
       private
+      def receive_response
+        # Responses are received in the order of sent commands. We
+        # can't use IDs returned by Context#send and Context#receive
+        # because they are always 0 for a groonga server.
+        future = @futures.first
+        begin
+          _, raw_response = @context.receive
+        rescue Error
+          raise if future.nil?
+          @futures.shift
+          future.reject($!)
+          return future
+        end
+        # It's a response for a command sent by Context#send directly.
+        return nil if future.nil?
+        @futures.shift
+        begin
+          response = build_response(future.command, raw_response)
+        rescue
+          future.reject($!)
+        else
+          future.resolve(response)
+        end
+        future
+      end
+
+      def build_response(command, raw_response)
+        response_class = Client::Response.find(command.name)
+        header = [0, 0, 0]
+        case command.output_type
+        when :json
+          body = JSON.parse(raw_response)
+        else
+          body = raw_response
+        end
+        response = response_class.new(command, header, body)
+        response.raw = raw_response
+        response
+      end
+
       def normalize_parameters(name, parameters)
         case name
         when "select"
@@ -0,0 +1,86 @@
+# -*- coding: utf-8 -*-
+#
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+module Groonga
+  class Context
+    # It is a response of a command that is sent by
+    # {Context#execute_command_async} but may not be received yet.
+    #
+    # @since 4.0.5
+    class CommandFuture
+      # @return [Integer] The ID returned by {Context#send}.
+      attr_reader :request_id
+      # @return [Groonga::Command::Base] The sent command.
+      attr_reader :command
+
+      # @private
+      def initialize(executor, request_id, command, callback)
+        @executor = executor
+        @request_id = request_id
+        @command = command
+        @callback = callback
+        @resolved = false
+        @response = nil
+        @error = nil
+      end
+
+      # @return [Boolean] +true+ if the response is received, +false+
+      #   otherwise.
+      def resolved?
+        @resolved
+      end
+
+      # Waits for the response. Responses for other futures on the
+      # same context are dispatched to them while waiting.
+      #
+      # @return [Groonga::Context::CommandFuture] +self+.
+      def wait
+        @executor.wait(self) unless @resolved
+        self
+      end
+
+      # Waits for the response and returns it.
+      #
+      # @return [Groonga::Client::Response::Base] The response.
+      # @raise [Exception] The error while the response is parsed.
+      def value
+        wait
+        raise @error if @error
+        @response
+      end
+
+      # @private
+      def resolve(response)
+        @response = response
+        @resolved = true
+      end
+
+      # @private
+      def reject(error)
+        @error = error
+        @resolved = true
+      end
+
+      # @private
+      def call_callback
+        return if @callback.nil? or @error
+        callback, @callback = @callback, nil
+        callback.call(@response)
+      end
+    end
+  end
+end
@@ -0,0 +1,77 @@
+# -*- coding: utf-8 -*-
+#
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+module Groonga
+  class Context
+    # It reports the progress of {Context#restore}. It is passed to
+    # the +:progress+ callback of {Context#restore}.
+    #
+    # @since 4.0.5
+    class RestoreProgress
+      # @return [Integer] The number of sent commands.
+      attr_reader :n_sent_commands
+      # @return [Integer] The number of received responses.
+      attr_reader :n_received_responses
+      # @return [Integer] The total size of sent commands in bytes.
+      attr_reader :n_sent_bytes
+
+      def initialize
+        @start_time = Time.now
+        @n_sent_commands = 0
+        @n_received_responses = 0
+        @n_sent_bytes = 0
+      end
+
+      # @return [Integer] The number of sent commands that their
+      #   responses aren't received yet.
+      def n_pending_commands
+        @n_sent_commands - @n_received_responses
+      end
+
+      # @return [Float] The elapsed time since restore is started in
+      #   seconds.
+      def elapsed_time
+        Time.now - @start_time
+      end
+
+      # @return [Float] The number of received responses per second.
+      def throughput
+        elapsed = elapsed_time
+        return 0.0 if elapsed.zero?
+        @n_received_responses / elapsed
+      end
+
+      # @return [Float] The size of sent commands per second in bytes.
+      def bytes_throughput
+        elapsed = elapsed_time
+        return 0.0 if elapsed.zero?
+        @n_sent_bytes / elapsed
+      end
+
+      # @private
+      def sent(command)
+        @n_sent_commands += 1
+        @n_sent_bytes += command.bytesize
+      end
+
+      # @private
+      def received
+        @n_received_responses += 1
+      end
+    end
+  end
+end
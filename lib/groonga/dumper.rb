@@ -16,6 +16,7 @@
 # Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 require 'stringio'
+require 'tempfile'
 
 module Groonga
   module Dumper
@@ -27,6 +28,11 @@ module Groonga
     def utf8_string
       ""
     end
+
+    def utf8_force_encoding(string)
+      string.force_encoding("UTF-8") if string.respond_to?(:force_encoding)
+      string
+    end
   end
 
   # データベースの内容をgrn式形式の文字列として出力するクラス。
@@ -93,16 +99,23 @@ module Groonga
     end
 
     def dump_tables(options)
-      first_table = true
+      tables = []
       options[:database].each(each_options(:order_by => :key)) do |object|
         next unless object.is_a?(Groonga::Table)
         next if object.size.zero?
         next if index_only_table?(object)
         next if target_table?(options[:exclude_tables], object, false)
         next unless target_table?(options[:tables], object, true)
-        options[:output].write("\n") if !first_table or options[:dump_schema]
-        first_table = false
-        dump_records(object, options)
+        tables << object
+      end
+
+      if parallel_dumpable?(options)
+        dump_tables_in_parallel(tables, options)
+      else
+        tables.each_with_index do |table, i|
+          options[:output].write("\n") if i > 0 or options[:dump_schema]
+          dump_records(table, options)
+        end
       end
     end
 
@@ -110,6 +123,116 @@ module Groonga
       TableDumper.new(table, options).dump
     end
 
+    def parallel_dumpable?(options)
+      return false if (options[:n_jobs] || 1) <= 1
+      return false unless Process.respond_to?(:fork)
+      not options[:database].path.nil?
+    end
+
+    def dump_tables_in_parallel(tables, options)
+      jobs = []
+      tables.each_with_index do |table, i|
+        finish_dump_records_job(jobs.shift, options) if jobs.size >= options[:n_jobs]
+        jobs << start_dump_records_job(table, i, options)
+      end
+      until jobs.empty?
+        finish_dump_records_job(jobs.shift, options)
+      end
+    ensure
+      # Running jobs are left when a job is failed or the output
+      # can't be written.
+      jobs.each do |job|
+        abort_dump_records_job(job)
+      end
+    end
+
+    def start_dump_records_job(table, i, options)
+      output = Tempfile.new("rroonga-dump")
+      error_output = Tempfile.new("rroonga-dump-error")
+      database_path = options[:database].path
+      table_name = table.name
+      encoding = table.context.encoding
+      begin
+        pid = fork_dump_records_job(database_path, table_name, encoding,
+                                    output, error_output, options)
+      rescue Exception
+        output.close!
+        error_output.close!
+        raise
+      end
+      [pid, i, table_name, output, error_output]
+    end
+
+    def fork_dump_records_job(database_path, table_name, encoding,
+                              output, error_output, options)
+      Process.fork do
+        success = false
+        begin
+          context = Groonga::Context.new(:encoding => encoding)
+          context.open_database(database_path) do
+            job_options = options.merge(:context => context,
+                                        :database => context.database,
+                                        :output => output,
+                                        :error_output => error_output)
+            dump_records(context[table_name], job_options)
+          end
+          success = true
+        rescue Exception
+          error_output.write("#{$!.class}: #{$!.message}\n")
+        ensure
+          output.flush
+          error_output.flush
+          exit!(success)
+        end
+      end
+    end
+
+    def finish_dump_records_job(job, options)
+      pid, i, table_name, output, error_output = job
+      begin
+        _, status = Process.waitpid2(pid)
+      rescue Exception
+        abort_dump_records_job(job)
+        raise
+      end
+      begin
+        copy_dumped_content(error_output, options[:error_output])
+        unless status.success?
+          raise Groonga::Error, "failed to dump table: <#{table_name}>"
+        end
+        # The separator isn't written to the temporary output before
+        # fork. The forked process would flush the buffered
+        # separator too.
+        options[:output].write("\n") if i > 0 or options[:dump_schema]
+        copy_dumped_content(output, options[:output])
+      ensure
+        output.close!
+        error_output.close!
+      end
+    end
+
+    def abort_dump_records_job(job)
+      pid, _, _, output, error_output = job
+      begin
+        Process.kill(:TERM, pid)
+      rescue Errno::ESRCH
+      end
+      begin
+        Process.waitpid(pid)
+      rescue Errno::ECHILD
+      end
+    ensure
+      output.close!
+      error_output.close!
+    end
+
+    def copy_dumped_content(input, output)
+      input.rewind
+      while (chunk = input.read(64 * 1024))
+        output.write(Dumper.utf8_force_encoding(chunk))
+      end
+    end
+
     def dump_plugin(path, options)
       output = options[:output]
       plugins_dir_re = Regexp.escape(Groonga::Plugin.system_plugins_dir)
@@ -682,6 +805,8 @@ module Groonga
     end
 
     def dump_records(columns)
+      return if dump_records_native(@table, columns, @options[:order_by])
+
       @table.each(:order_by => @options[:order_by]) do |record|
         write(",\n")
         values = columns.collect do |column|
@@ -26,6 +26,13 @@ module Groonga
     attr_accessor :allow_update
     attr_accessor :allow_leading_not
     attr_accessor :default_column
+    # @return [::Array<Symbol>, nil] The names of variables that are
+    #   defined in the built expression. They are passed to the
+    #   block as the second argument.
+    attr_accessor :variable_names
+    # @return [::Hash{Symbol => Groonga::Variable}] The variables
+    #   defined by {#variable_names}.
+    attr_reader :variables
 
     VALID_COLUMN_NAME_RE = /\A[a-zA-Z\d_]+\z/
 
@@ -39,11 +46,14 @@ module Groonga
       @allow_update = nil
       @allow_leading_not = nil
       @default_column = nil
+      @variable_names = nil
+      @variables = {}
     end
 
     def build(&block)
       expression = Expression.new(:name => @name, :context => @table.context)
       variable = expression.define_variable(:domain => @table)
+      define_variables(expression)
       build_expression(expression, variable, &block)
     end
 
@@ -67,11 +77,22 @@ module Groonga
       }
     end
 
+    def define_variables(expression)
+      @variables = {}
+      (@variable_names || []).each do |name|
+        @variables[name.to_sym] = expression.define_variable(:name => name.to_s)
+      end
+    end
+
     def build_expression(expression, variable)
       builders = []
       builders << match(@query, default_parse_options) if @query
       if block_given?
-        custom_builder = yield(self)
+        if @variable_names
+          custom_builder = yield(self, @variables)
+        else
+          custom_builder = yield(self)
+        end
         if custom_builder.is_a?(::Array)
           builders.concat(custom_builder)
         else
@@ -313,7 +334,11 @@ module Groonga
 
       def build(expression, variable)
         @column_value_builder.build(expression, variable)
-        expression.append_constant(@value)
+        if @value.is_a?(Variable)
+          expression.append_object(@value)
+        else
+          expression.append_constant(@value)
+        end
         expression.append_operation(@operation, 2)
       end
     end
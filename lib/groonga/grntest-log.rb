@@ -135,6 +135,20 @@ module Groonga
       def elapsed_time
         relative_end_time - relative_start_time
       end
+
+      # @return [String] The command name such as +"select"+. It is
+      #   extracted from both of +/d/select?table=...+ and
+      #   +select --table ...+ forms.
+      def command_name
+        case command
+        when /\A\/d\/([^?.\/]+)/
+          $1
+        when /\A\s*(\S+)/
+          $1
+        else
+          ""
+        end
+      end
     end
 
     class JobSummaryEvent
@@ -202,5 +216,256 @@ module Groonga
         JSON.parse(string)
       end
     end
+
+    # A latency histogram that can be merged. Latencies are counted
+    # in buckets whose widths grow geometrically by {RESOLUTION}. So
+    # percentiles have at most about 2.5% relative error and the
+    # histogram size doesn't depend on the number of queries.
+    class LatencyHistogram
+      RESOLUTION = 1.05
+      LOG_RESOLUTION = Math.log(RESOLUTION)
+
+      attr_reader :n_samples, :total, :min, :max, :buckets
+      def initialize
+        @n_samples = 0
+        @total = 0
+        @min = nil
+        @max = nil
+        @buckets = Hash.new(0)
+      end
+
+      # @param latency [Integer] The latency in microseconds.
+      def add(latency)
+        @n_samples += 1
+        @total += latency
+        @min = latency if @min.nil? or latency < @min
+        @max = latency if @max.nil? or latency > @max
+        @buckets[bucket_index(latency)] += 1
+      end
+
+      def merge!(other)
+        @n_samples += other.n_samples
+        @total += other.total
+        @min = other.min if @min.nil? or (other.min and other.min < @min)
+        @max = other.max if @max.nil? or (other.max and other.max > @max)
+        other.buckets.each do |index, n|
+          @buckets[index] += n
+        end
+        self
+      end
+
+      def mean
+        return nil if @n_samples.zero?
+        @total / @n_samples.to_f
+      end
+
+      # @param percent [Numeric] The percentile such as +99+.
+      # @return [Float, nil] The latency in microseconds.
+      def percentile(percent)
+        return nil if @n_samples.zero?
+        rank = (@n_samples * percent / 100.0).ceil
+        rank = 1 if rank < 1
+        return @max if rank >= @n_samples
+        n_samples = 0
+        @buckets.keys.sort.each do |index|
+          n_samples += @buckets[index]
+          if n_samples >= rank
+            return [[bucket_value(index), @min].max, @max].min
+          end
+        end
+        @max
+      end
+
+      private
+      def bucket_index(latency)
+        return -1 if latency <= 0
+        (Math.log(latency) / LOG_RESOLUTION).floor
+      end
+
+      def bucket_value(index)
+        return 0 if index < 0
+        RESOLUTION ** (index + 0.5)
+      end
+    end
+
+    # Aggregates latencies of task events by command name.
+    class Statistics
+      attr_reader :histograms
+      def initialize
+        @histograms = {}
+      end
+
+      # @param event [TaskEvent]
+      def add(event)
+        histogram = (@histograms[event.command_name] ||= LatencyHistogram.new)
+        histogram.add(event.elapsed_time)
+      end
+
+      def merge!(other)
+        other.histograms.each do |name, histogram|
+          (@histograms[name] ||= LatencyHistogram.new).merge!(histogram)
+        end
+        self
+      end
+
+      def total
+        @histograms.values.inject(LatencyHistogram.new) do |total, histogram|
+          total.merge!(histogram)
+        end
+      end
+    end
+
+    # Analyzes task events in a log file by parallel workers. The
+    # file is split into chunks at line boundaries and each chunk is
+    # parsed by a forked process. Each worker returns a small
+    # {Statistics} instead of events. So memory usage and transfer
+    # size don't depend on the log size.
+    #
+    # Environment and summary lines aren't analyzed. They aren't
+    # task lines.
+    class ParallelAnalyzer
+      TASK_LINE_PREFIX = /\A\[\d+,/
+
+      # @param options [::Hash] The options.
+      # @option options [Integer] :n_workers (the number of processors)
+      #   The number of worker processes. Chunks are parsed in the
+      #   current process when it is 1 or +fork+ isn't available.
+      # @raise [ArgumentError] If +:n_workers+ is less than 1.
+      def initialize(options={})
+        @n_workers = options[:n_workers] || self.class.n_processors
+        if @n_workers < 1
+          raise ArgumentError,
+                "the number of workers must be 1 or larger: <#{@n_workers}>"
+        end
+      end
+
+      # @param path [String] The path of a log file.
+      # @return [Statistics]
+      def analyze(path)
+        size = File.size(path)
+        n_chunks = @n_workers
+        n_chunks = 1 if size < n_chunks
+        ranges = (0...n_chunks).collect do |i|
+          [size * i / n_chunks, size * (i + 1) / n_chunks]
+        end
+        if n_chunks == 1 or !Process.respond_to?(:fork)
+          statistics = ranges.collect do |start_offset, end_offset|
+            analyze_chunk(path, start_offset, end_offset)
+          end
+        else
+          statistics = analyze_chunks_in_parallel(path, ranges)
+        end
+        statistics.inject(Statistics.new) do |total, chunk_statistics|
+          total.merge!(chunk_statistics)
+        end
+      end
+
+      # @param input [IO] The input that can't be split such as
+      #   standard input.
+      # @return [Statistics]
+      def analyze_io(input)
+        statistics = Statistics.new
+        input.each_line do |line|
+          add_task_line(statistics, line)
+        end
+        statistics
+      end
+
+      private
+      def analyze_chunks_in_parallel(path, ranges)
+        workers = ranges.collect do |start_offset, end_offset|
+          input, output = IO.pipe
+          pid = Process.fork do
+            input.close
+            statistics = analyze_chunk(path, start_offset, end_offset)
+            output.binmode
+            output.write(Marshal.dump(statistics))
+            output.close
+            exit!(true)
+          end
+          output.close
+          [pid, input]
+        end
+        workers.collect do |pid, input|
+          input.binmode
+          data = input.read
+          input.close
+          _, status = Process.waitpid2(pid)
+          unless status.success?
+            raise "grntest log analyzer worker failed: <#{path}>: #{status}"
+          end
+          Marshal.load(data)
+        end
+      end
+
+      def analyze_chunk(path, start_offset, end_offset)
+        statistics = Statistics.new
+        File.open(path, "rb") do |file|
+          if start_offset > 0
+            # Skip the line that is started in the previous chunk.
+            file.seek(start_offset - 1)
+            file.gets
+          end
+          while file.pos < end_offset
+            line = file.gets
+            break if line.nil?
+            add_task_line(statistics, line)
+          end
+        end
+        statistics
+      end
+
+      def add_task_line(statistics, line)
+        return unless TASK_LINE_PREFIX =~ line
+        statistics.add(TaskEvent.new(*JSON.parse(line.sub(/\]+,?\s*\z/, "]"))))
+      end
+
+      class << self
+        def n_processors
+          if File.exist?("/proc/cpuinfo")
+            n_processors = File.read("/proc/cpuinfo").scan(/^processor\s*:/).size
+            return n_processors if n_processors > 0
+          end
+          1
+        end
+      end
+    end
+
+    # Writes {Statistics} as a compact TSV. Each line has latency
+    # statistics of a command in milliseconds. Lines are sorted by
+    # command name and the last line is the total. So summaries of
+    # different runs can be compared by +diff+.
+    class SummaryWriter
+      PERCENTILES = [50, 90, 95, 99]
+      HEADER = ["command", "n_queries", "min", "mean"] +
+        PERCENTILES.collect {|percent| "p#{percent}"} +
+        ["max"]
+
+      def initialize(output)
+        @output = output
+      end
+
+      # @param statistics [Statistics]
+      def write(statistics)
+        @output.puts(HEADER.join("\t"))
+        statistics.histograms.keys.sort.each do |name|
+          write_histogram(name, statistics.histograms[name])
+        end
+        write_histogram("(total)", statistics.total)
+      end
+
+      private
+      def write_histogram(name, histogram)
+        values = [histogram.min, histogram.mean]
+        values += PERCENTILES.collect do |percent|
+          histogram.percentile(percent)
+        end
+        values << histogram.max
+        values = values.collect do |value|
+          "%.3f" % ((value || 0) / 1_000.0)
+        end
+        @output.puts([name, histogram.n_samples, *values].join("\t"))
+      end
+    end
   end
 end
@@ -37,10 +37,15 @@ module Groonga
   end
 
   class IndexColumnDumper
+    N_POSTINGS_PER_SLICE = 10000
+    N_POSTING_FIELDS = 6
+
     def initialize(column, output_directory)
       @column = column
       @output_directory = output_directory
       @sources = @column.sources
+      @lexicon = @column.table
+      @table = @column.range
     end
 
     def dump
@@ -49,22 +54,21 @@ module Groonga
 
     private
     def dump_indexes
-      @column.table.open_cursor do |table_cursor|
+      @lexicon.open_cursor do |table_cursor|
         @column.open_cursor(table_cursor) do |cursor|
           postings = []
-          cursor.each do |posting|
-            if postings.empty?
-              postings << posting
-              next
-            end
+          cursor.each_packed_slice(N_POSTINGS_PER_SLICE) do |packed_postings|
+            packed_postings.unpack("L*").each_slice(N_POSTING_FIELDS) do |posting|
+              unless postings.empty?
+                current_term_posting = postings.first
+                unless same_term_posting?(current_term_posting, posting)
+                  dump_postings(postings)
+                  postings.clear
+                end
+              end
 
-            current_term_posting = postings.first
-            unless same_term_posting?(current_term_posting, posting)
-              dump_postings(postings)
-              postings.clear
+              postings << posting
             end
-
-            postings << posting
           end
           dump_postings(postings)
         end
@@ -72,13 +76,13 @@ module Groonga
     end
 
     def same_term_posting?(posting1, posting2)
-      posting1.term_id == posting2.term_id
+      term_id(posting1) == term_id(posting2)
     end
 
-    def dump_file_info(posting)
+    def dump_file_info(term)
       items = [
         "index: #{@column.name}",
-        "term: <#{posting.term.key}>",
+        "term: <#{term}>",
         "domain: #{@column.domain.name}",
         "range: #{@column.range.name}",
         "have_section: #{@column.with_section?}",
@@ -107,18 +111,24 @@ module Groonga
     def dump_postings(postings)
       return if postings.empty?
 
-      distinctive_posting = postings.first
-      term = distinctive_posting.term.key
+      term = Record.new(@lexicon, term_id(postings.first)).key
       encoded_term = encode_term(term)
       output_dir = File.join(@output_directory, @column.name)
       output_path = File.join(output_dir, "#{encoded_term}.dump")
       FileUtils.mkdir_p(output_dir)
+      record_keys = {}
       File.open(output_path, "w") do |output|
         @output = output
-        dump_file_info(distinctive_posting)
+        dump_file_info(term)
         dump_posting_header
         sorted_postings = postings.sort_by do |posting|
-          [source_column_name(posting), record_key(posting), posting.position]
+          record_id = record_id(posting)
+          record_keys[record_id] ||= record_key(record_id)
+          [
+            source_column_name(posting),
+            record_keys[record_id],
+            position(posting),
+          ]
         end
         sorted_postings.each do |posting|
           dump_posting(posting)
@@ -127,27 +137,50 @@ module Groonga
     end
 
     def dump_posting(posting)
-      found_record = "#{posting.table.name}[#{posting.record.record_id}]"
+      found_record = "#{@table.name}[#{record_id(posting)}]"
       posting_info_items = [
-        "#{posting.weight}",
-        "#{posting.position}",
-        "#{posting.term_frequency}",
+        "#{weight(posting)}",
+        "#{position(posting)}",
+        "#{term_frequency(posting)}",
         "#{found_record}.#{source_column_name(posting)}",
       ]
       posting_info = posting_info_items.join("\t")
       @output.write("  #{posting_info}\n")
     end
 
-    def term(posting)
-      posting.term.key
+    # A posting is an Array of record ID, section ID, term ID,
+    # position, term frequency and weight. See
+    # Groonga::IndexCursor#each_packed_slice.
+    def record_id(posting)
+      posting[0]
+    end
+
+    def section_id(posting)
+      posting[1]
+    end
+
+    def term_id(posting)
+      posting[2]
+    end
+
+    def position(posting)
+      posting[3]
+    end
+
+    def term_frequency(posting)
+      posting[4]
+    end
+
+    def weight(posting)
+      posting[5]
     end
 
-    def record_key(posting)
-      posting.record.key || default_key(posting)
+    def record_key(record_id)
+      Record.new(@table, record_id).key || default_key
     end
 
-    def default_key(posting)
-      type = posting.table.domain
+    def default_key
+      type = @table.domain
       return 0 if type.is_a?(Groonga::Table)
 
       case type.name
@@ -167,9 +200,9 @@ module Groonga
     end
 
     def source_column_name(posting)
-      source = @sources[posting.section_id - 1]
+      source = @sources[section_id(posting) - 1]
       if source.nil?
-        "<invalid section: #{posting.section_id}>"
+        "<invalid section: #{section_id(posting)}>"
       elsif source.is_a?(Groonga::Table)
         "_key"
       else
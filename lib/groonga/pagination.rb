@@ -15,6 +15,9 @@
 # License along with this library; if not, write to the Free Software
 # Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
+require "base64"
+require "json"
+
 module Groonga
   class TooSmallPage < Error
     # {Table#paginate} で小さすぎるページ番号を指定した場合に
@@ -64,6 +67,19 @@ module Groonga
     end
   end
 
+  # It is raised when {Table#paginate} receives a continuation token
+  # that is broken or that is created with different sort keys.
+  #
+  # @since 4.0.5
+  class InvalidContinuationToken < Error
+    # @return [String] The specified continuation token.
+    attr_reader :token
+    def initialize(token, reason)
+      @token = token
+      super("invalid continuation token: #{reason}: <#{@token}>")
+    end
+  end
+
   class Table
 
     # ページネーション用便利メソッド。ページネーションをした
@@ -111,7 +127,54 @@ module Groonga
     # @option options [Integer] :page (1)
     #
     #   ページ番号。ページ番号は0ベースではなく1ベースであることに注意。
+    # @option options [Boolean] :keyset (false)
+    #
+    #   +true+ を指定するとページ番号ではなく継続トークンでページ
+    #   を指定するキーセットページネーションを使う。深いページで
+    #   もソートするレコード数が1ページあたりの項目数程度に抑えら
+    #   れる。返されるテーブルには {KeysetPagination} モジュール
+    #   がextendされている。+:page+ は使えない。It is available
+    #   since 4.0.5.
+    # @option options [Boolean] :top_k (false)
+    #
+    #   +true+ を指定すると {#sort} の +:top_k+ オプションを使って
+    #   ページ内のレコードだけをヒープで選ぶ。深くないページで速
+    #   い。同じ値のレコードはIDの昇順に並ぶので、指定しない場合
+    #   と同じ値のレコードの順序が変わることがある。It is
+    #   available since 4.0.5.
+    # @option options [String] :after (nil)
+    #
+    #   {KeysetPagination#next_token} で取得した継続トークン。
+    #   指定するとキーセットページネーションを使い、トークンを作っ
+    #   たページの次のページを返す。トークンを作った時と同じ
+    #   _sort_keys_ を指定すること。It is available since 4.0.5.
+    #
+    #   レシーバーが {PatriciaTrie} で最初のソートキーが +_key+ の
+    #   場合は、キーの範囲を指定したカーソルで次のページのレコード
+    #   だけを読むので、深いページでも1ページあたりの項目数程度の
+    #   コストで済む。それ以外の場合（検索結果のテーブルやカラム
+    #   をソートキーにした場合など）は、継続トークンより後ろのレ
+    #   コードをレシーバー全体から {#select} で絞り込んでからソー
+    #   トするので、深いページのコストは残りのレコード数に比例す
+    #   る。インデックスがあるカラムでも同じ。値を設定していない
+    #   レコードはインデックスに含まれないため、インデックスの範
+    #   囲を使うとそれらのレコードが抜けてしまうからである。
+    #
+    # @example Paginate by keyset
+    #   entries = Groonga["entries"]
+    #   page = entries.paginate([["updated_at", :desc]],
+    #                           :keyset => true,
+    #                           :size => 10)
+    #   while page.have_next_page?
+    #     page = entries.paginate([["updated_at", :desc]],
+    #                             :after => page.next_token,
+    #                             :size => 10)
+    #   end
     def paginate(sort_keys, options={})
+      if options[:keyset] or options.has_key?(:after)
+        return paginate_by_keyset(sort_keys, options)
+      end
+
       _size = size
       page_size = options[:size] || 10
       minimum_size = [1, _size].min
@@ -129,11 +192,102 @@ module Groonga
 
       offset = (page - 1) * page_size
       limit = page_size
-      records = sort(sort_keys, :offset => offset, :limit => limit)
+      records = sort(sort_keys,
+                     :offset => offset,
+                     :limit => limit,
+                     :top_k => options[:top_k])
       records.extend(Pagination)
       records.send(:set_pagination_info, page, page_size, _size)
       records
     end
+
+    private
+    def paginate_by_keyset(sort_keys, options)
+      _size = size
+      page_size = options[:size] || 10
+      if page_size < 1
+        raise TooSmallPageSize.new(page_size, [1, _size].min.._size)
+      end
+
+      keys = KeysetPagination.normalize_sort_keys(sort_keys)
+      token = options[:after]
+      values = nil
+      values = KeysetPagination.decode_token(token, keys) if token
+      cursor_options = KeysetPagination.key_cursor_options(self, keys, values)
+      if cursor_options
+        return paginate_by_key_cursor(keys, page_size, _size, cursor_options)
+      end
+
+      if token
+        target = select do |record|
+          KeysetPagination.build_condition(record, keys, values)
+        end
+        # Records in target refer records in self by their keys.
+        target_keys = keys.collect do |name, order|
+          ["_key.#{name}", order]
+        end
+      else
+        target = self
+        target_keys = keys
+      end
+
+      begin
+        sorted_records = target.sort(target_keys,
+                                     :limit => page_size + 1,
+                                     :top_k => true)
+        records = Groonga::Array.create(:context => context,
+                                        :value_type => self)
+        last_record = nil
+        sorted_records.each do |sorted_record|
+          break if records.size == page_size
+          last_record = sorted_record.value
+          last_record = last_record.key if token
+          records.add.value = last_record
+        end
+        if sorted_records.size > page_size
+          next_token = KeysetPagination.encode_token(keys, last_record)
+        else
+          next_token = nil
+        end
+        sorted_records.close
+      ensure
+        target.close if token
+      end
+
+      records.extend(KeysetPagination)
+      records.send(:set_keyset_pagination_info, page_size, _size, next_token)
+      records
+    end
+
+    # Reads only the records in the page by a cursor in key
+    # order. Keys are unique. So records after the last record in
+    # the previous page are records whose key is greater (or less
+    # for descending order) than the key of the last record.
+    def paginate_by_key_cursor(keys, page_size, _size, cursor_options)
+      records = Groonga::Array.create(:context => context,
+                                      :value_type => self)
+      last_record = nil
+      have_next_page = false
+      open_cursor(cursor_options.merge(:limit => page_size + 1)) do |cursor|
+        cursor.each do |record|
+          if records.size == page_size
+            have_next_page = true
+            break
+          end
+          records.add.value = record
+          last_record = record
+        end
+      end
+      if have_next_page
+        next_token = KeysetPagination.encode_token(keys, last_record)
+      else
+        next_token = nil
+      end
+
+      records.extend(KeysetPagination)
+      records.send(:set_keyset_pagination_info, page_size, _size, next_token)
+      records
+    end
   end
 
   # ページネーション機能を追加するモジュール。
@@ -240,4 +394,258 @@ module Groonga
       @n_pages = [(@n_records / @page_size.to_f).ceil, 1].max
     end
   end
+
+  # It is extended to a table returned by {Table#paginate} with
+  # +:keyset+ or +:after+ option. Pages are specified by continuation
+  # tokens instead of page numbers.
+  #
+  # A continuation token has the sort key values and the ID of the
+  # last record in the page. The next page is records after the
+  # record in the sort order. +_id+ is added to sort keys to break
+  # ties.
+  #
+  # @since 4.0.5
+  module KeysetPagination
+    TOKEN_VERSION = 1
+
+    # @private
+    #
+    # The pack formats of raw key values for cursor ranges. A key
+    # of Time type is stored as microseconds since the epoch.
+    KEY_PACK_FORMATS = {
+      "Int8" => "c",
+      "UInt8" => "C",
+      "Int16" => "s",
+      "UInt16" => "S",
+      "Int32" => "l",
+      "UInt32" => "L",
+      "Int64" => "q",
+      "UInt64" => "Q",
+      "Float" => "d",
+      "Time" => "q",
+    }
+
+    # @private
+    TEXT_KEY_TYPES = ["ShortText", "Text", "LongText"]
+
+    # @return [Integer] The max number of records in a page.
+    attr_reader :page_size
+    # @return [Integer] The number of all records.
+    attr_reader :n_records
+    # @return [String, nil] The continuation token for the next page.
+    #   +nil+ if there is no next page.
+    attr_reader :next_token
+
+    # @return [Boolean] +true+ if there is the next page, +false+
+    #   otherwise.
+    def have_next_page?
+      not @next_token.nil?
+    end
+
+    # @return [Integer] The number of records in the page.
+    def n_records_in_page
+      size
+    end
+
+    class << self
+      # @private
+      def normalize_sort_keys(sort_keys)
+        keys = sort_keys.collect do |sort_key|
+          case sort_key
+          when ::Hash
+            name = sort_key[:key]
+            order = sort_key[:order]
+          when ::Array
+            name, order = sort_key
+          else
+            name = sort_key
+            order = nil
+          end
+          unless name.is_a?(String) or name.is_a?(Symbol)
+            message = "keyset pagination supports only column name " +
+              "as sort key: <#{name.inspect}>"
+            raise ArgumentError, message
+          end
+          [name.to_s, normalize_order(order)]
+        end
+        unless keys.any? {|name, _| name == "_id"}
+          keys << ["_id", :ascending]
+        end
+        keys
+      end
+
+      # @private
+      def encode_token(keys, record)
+        values = keys.collect do |name, _|
+          if name == "_id"
+            value = record.id
+          else
+            value = record[name]
+          end
+          encode_value(name, value)
+        end
+        data = {
+          "version" => TOKEN_VERSION,
+          "keys" => keys.collect {|name, order| [name, order.to_s]},
+          "values" => values,
+        }
+        Base64.urlsafe_encode64(JSON.generate(data))
+      end
+
+      # @private
+      def decode_token(token, keys)
+        begin
+          data = JSON.parse(Base64.urlsafe_decode64(token))
+        rescue ArgumentError, JSON::ParserError
+          raise InvalidContinuationToken.new(token, "broken")
+        end
+        unless data.is_a?(::Hash) and data["version"] == TOKEN_VERSION
+          raise InvalidContinuationToken.new(token, "unknown version")
+        end
+        token_keys = keys.collect {|name, order| [name, order.to_s]}
+        if data["keys"] != token_keys
+          raise InvalidContinuationToken.new(token, "sort keys are changed")
+        end
+        values = data["values"]
+        unless values.is_a?(::Array) and values.size == keys.size
+          raise InvalidContinuationToken.new(token, "broken values")
+        end
+        values.collect do |value|
+          decode_value(token, value)
+        end
+      end
+
+      # @private
+      #
+      # Returns options for {Groonga::Table#open_cursor} that reads
+      # records in the sort order from the record after _values_
+      # when _table_ can be paginated by a key range. Otherwise
+      # +nil+ is returned.
+      def key_cursor_options(table, keys, values)
+        return nil unless table.is_a?(PatriciaTrie)
+        name, order = keys.first
+        return nil unless name == "_key"
+        options = {:order_by => :key, :order => order}
+        return options if values.nil?
+
+        key = pack_key(table.domain, values.first)
+        return nil if key.nil?
+        if order == :descending
+          options[:max] = key
+          options[:less_than] = true
+        else
+          options[:min] = key
+          options[:greater_than] = true
+        end
+        options
+      end
+
+      # @private
+      #
+      # Builds (k1 > v1) OR (k1 == v1 AND k2 > v2) OR ... condition.
+      # ">" is "<" for descending order.
+      def build_condition(record, keys, values)
+        conditions = []
+        keys.each_with_index do |(name, order), i|
+          condition = nil
+          keys[0, i].each_with_index do |(previous_name, _), j|
+            equal_condition = (record[previous_name] == values[j])
+            if condition
+              condition &= equal_condition
+            else
+              condition = equal_condition
+            end
+          end
+          if order == :descending
+            after_condition = (record[name] < values[i])
+          else
+            after_condition = (record[name] > values[i])
+          end
+          if condition
+            condition &= after_condition
+          else
+            condition = after_condition
+          end
+          conditions << condition
+        end
+        conditions.inject do |previous_condition, condition|
+          previous_condition | condition
+        end
+      end
+
+      private
+      def pack_key(key_type, value)
+        return nil if key_type.nil?
+        type_name = key_type.name
+        if TEXT_KEY_TYPES.include?(type_name)
+          return nil unless value.is_a?(String)
+          return value
+        end
+        format = KEY_PACK_FORMATS[type_name]
+        return nil if format.nil?
+        case value
+        when Time
+          return nil unless type_name == "Time"
+          value = value.to_i * 1_000_000 + value.usec
+        when Integer, Float
+          return nil if type_name == "Time"
+        else
+          return nil
+        end
+        [value].pack(format)
+      end
+
+      def normalize_order(order)
+        case order.to_s
+        when "", "asc", "ascending"
+          :ascending
+        when "desc", "descending"
+          :descending
+        else
+          message = "order should be one of " +
+            "[nil, :desc, :descending, :asc, :ascending]: #{order.inspect}"
+          raise ArgumentError, message
+        end
+      end
+
+      def encode_value(name, value)
+        case value
+        when Integer
+          ["integer", value]
+        when Float
+          ["float", value]
+        when String
+          ["string", value]
+        when true, false
+          ["boolean", value]
+        when Time
+          ["time", [value.to_i, value.usec]]
+        else
+          message = "keyset pagination doesn't support " +
+            "<#{name}> sort key value: <#{value.inspect}>"
+          raise ArgumentError, message
+        end
+      end
+
+      def decode_value(token, value)
+        type, raw_value = value
+        case type
+        when "integer", "float", "string", "boolean"
+          raw_value
+        when "time"
+          seconds, micro_seconds = raw_value
+          Time.at(seconds, micro_seconds)
+        else
+          raise InvalidContinuationToken.new(token, "unknown value type")
+        end
+      end
+    end
+
+    private
+    def set_keyset_pagination_info(page_size, n_records, next_token)
+      @page_size = page_size
+      @n_records = n_records
+      @next_token = next_token
+    end
+  end
 end
@@ -0,0 +1,174 @@
+# -*- coding: utf-8 -*-
+#
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+module Groonga
+  # A condition that is built once and executed many times with
+  # different values. Values are bound to named variables in the
+  # condition. Use {Groonga::Table#prepare} to create it.
+  #
+  # A prepared expression isn't thread safe. Don't use it from
+  # multiple threads at the same time. It is the same as
+  # {Groonga::Context}.
+  #
+  # @example Bind a value to a variable in a block
+  #   adults = users.prepare(:variables => [:min_age]) do |record, variables|
+  #     record.age >= variables[:min_age]
+  #   end
+  #   adults.select(:min_age => 20)
+  #   adults.select(:min_age => 18)
+  #
+  # @example Bind a value to a variable in a script syntax query
+  #   adults = users.prepare("age >= min_age", :variables => [:min_age])
+  #   adults.select(:min_age => 20)
+  #
+  # @since 4.0.5
+  class PreparedExpression
+    # @return [Groonga::Table] The table to be searched.
+    attr_reader :table
+    # @return [Groonga::Expression] The built expression.
+    attr_reader :expression
+    # @return [::Hash{Symbol => Groonga::Variable}] The variables.
+    attr_reader :variables
+    # @return [Integer] The schema generation when the expression is
+    #   built. It is used to expire cached prepared expressions.
+    attr_reader :generation
+
+    # @see Groonga::Table#prepare
+    def initialize(table, query=nil, options={}, &block)
+      @table = table
+      @generation = Table.column_cache_generation
+      builder = RecordExpressionBuilder.new(table, options[:name])
+      if query
+        builder.query = query
+        builder.syntax = options[:syntax] || :script
+        builder.allow_pragma = options[:allow_pragma]
+        builder.allow_column = options[:allow_column]
+        builder.allow_leading_not = options[:allow_leading_not]
+        builder.default_column = options[:default_column]
+      end
+      builder.variable_names = options[:variables] || []
+      @expression = builder.build(&block)
+      @variables = builder.variables
+    end
+
+    # Binds values to variables.
+    #
+    # @param values [::Hash{Symbol, String => ::Object}] The variable
+    #   names and their values.
+    # @return [self]
+    def bind(values)
+      values.each do |name, value|
+        variable = @variables[name.to_sym]
+        if variable.nil?
+          message = "unknown variable: <#{name.inspect}>: " +
+            "available variables: <#{@variables.keys.inspect}>"
+          raise ArgumentError, message
+        end
+        variable.value = value
+      end
+      self
+    end
+
+    # Binds _values_ and selects records by the expression.
+    #
+    # @param values [::Hash] The values passed to {#bind}.
+    # @param options [::Hash] The options passed to
+    #   {Groonga::Table#select}.
+    # @return [Groonga::Hash] The result table.
+    def select(values={}, options={})
+      bind(values)
+      @table.select(@expression, options)
+    end
+
+    # @return [Boolean] +true+ if the schema isn't changed since the
+    #   expression is built and the expression isn't closed,
+    #   +false+ otherwise. The expression is closed by
+    #   {Groonga::Context#pop_memory_pool} when it is built in a
+    #   memory pool.
+    def valid?
+      return false if @expression.closed?
+      @generation == Table.column_cache_generation
+    end
+
+    # Closes the expression. It can't be used after it is closed.
+    def close
+      @expression.close unless @expression.closed?
+    end
+
+    # @private
+    #
+    # The LRU cache of prepared expressions for a context. It is
+    # used by {Groonga::Table#prepare} with a query string.
+    #
+    # The cache doesn't own cached prepared expressions. They may
+    # be still used by callers of {Groonga::Table#prepare}. So
+    # evicted, expired and cleared prepared expressions are just
+    # dropped. They aren't closed.
+    class Cache
+      DEFAULT_MAX_SIZE = 100
+
+      attr_reader :max_size, :n_hits, :n_misses
+      def initialize(max_size=DEFAULT_MAX_SIZE)
+        @max_size = max_size
+        @expressions = {}
+        @n_hits = 0
+        @n_misses = 0
+      end
+
+      def size
+        @expressions.size
+      end
+
+      def max_size=(max_size)
+        @max_size = max_size
+        evict
+      end
+
+      def fetch(key)
+        expression = @expressions.delete(key)
+        if expression
+          if expression.valid?
+            @n_hits += 1
+            # Ruby's Hash keeps insertion order. The last entry is the
+            # most recently used entry.
+            @expressions[key] = expression
+            return expression
+          end
+        end
+
+        @n_misses += 1
+        expression = yield
+        if @max_size > 0
+          @expressions[key] = expression
+          evict
+        end
+        expression
+      end
+
+      def clear
+        @expressions.clear
+      end
+
+      private
+      def evict
+        while @expressions.size > @max_size
+          @expressions.shift
+        end
+      end
+    end
+  end
+end
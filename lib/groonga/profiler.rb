@@ -0,0 +1,336 @@
+# -*- coding: utf-8 -*-
+#
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+require "json"
+
+module Groonga
+  # It records elapsed time, CPU time, the number of input and
+  # output records and the number of allocated objects of
+  # operations such as {Groonga::Table#select} in a context. Use
+  # {Groonga::Context#profile} or
+  # {Groonga::Context#start_profile} to use it.
+  #
+  # Recorded operations are nested. For example, building an
+  # expression by a block is recorded as a child operation of
+  # {Groonga::Table#select}.
+  #
+  # Reading column values are too many to record each
+  # read. They are aggregated by column in {#column_reads}.
+  #
+  # @example Profile a search
+  #   profiler = context.profile do
+  #     records = entries.select {|record| record.content =~ "groonga"}
+  #     records.sort(["_score"], :limit => 10).each do |record|
+  #       record.title
+  #     end
+  #   end
+  #   puts(profiler.to_json)
+  #
+  # @since 4.0.5
+  class Profiler
+    # An operation recorded by {Groonga::Profiler}.
+    class Operation
+      # @return [String] The operation name such as +"select"+.
+      attr_reader :name
+      # @return [String, nil] The name of the target object.
+      attr_reader :target
+      # @return [Float] The elapsed time in seconds.
+      attr_accessor :elapsed_time
+      # @return [Float] The CPU time in seconds.
+      attr_accessor :cpu_time
+      # @return [Integer, nil] The number of input records.
+      attr_accessor :n_input_records
+      # @return [Integer, nil] The number of output records.
+      attr_accessor :n_output_records
+      # @return [Integer, nil] The number of allocated Ruby objects.
+      #   It is +nil+ on Ruby that doesn't report it.
+      attr_accessor :n_allocated_objects
+      # @return [::Array<Operation>] The nested operations.
+      attr_reader :children
+      def initialize(name, target)
+        @name = name
+        @target = target
+        @elapsed_time = nil
+        @cpu_time = nil
+        @n_input_records = nil
+        @n_output_records = nil
+        @n_allocated_objects = nil
+        @children = []
+      end
+
+      def to_hash
+        {
+          "name" => @name,
+          "target" => @target,
+          "elapsed_time" => @elapsed_time,
+          "cpu_time" => @cpu_time,
+          "n_input_records" => @n_input_records,
+          "n_output_records" => @n_output_records,
+          "n_allocated_objects" => @n_allocated_objects,
+          "children" => @children.collect(&:to_hash),
+        }
+      end
+    end
+
+    # @return [::Array<Operation>] The recorded top level operations.
+    attr_reader :operations
+
+    # @return [::Hash{String => ::Hash}] The number of reads and the
+    #   total elapsed time for each column. The key is the column
+    #   name. The value is a Hash that has +"n_reads"+ and
+    #   +"elapsed_time"+.
+    attr_reader :column_reads
+
+    # @param callback [Proc, nil] It is called with each finished
+    #   top level operation.
+    def initialize(callback=nil)
+      @callback = callback
+      @operations = []
+      @column_reads = {}
+      @measuring_column_read = false
+      @stack = []
+    end
+
+    # Records an operation.
+    #
+    # @param name [String] The operation name.
+    # @param target [Groonga::Object, nil] The target object.
+    # @param n_input_records [Integer, nil] The number of input records.
+    # @yield [operation] Runs the operation.
+    # @yieldparam operation [Operation] The operation. You can set
+    #   {Operation#n_output_records} in the block.
+    # @return [Object] The value returned by the block.
+    def measure(name, target=nil, n_input_records=nil)
+      operation = Operation.new(name, target_name(target))
+      operation.n_input_records = n_input_records
+      parent = @stack.last
+      @stack.push(operation)
+      start_time = self.class.now
+      start_cpu_time = self.class.cpu_time
+      start_n_allocated_objects = self.class.n_allocated_objects
+      begin
+        yield(operation)
+      ensure
+        operation.elapsed_time = self.class.now - start_time
+        operation.cpu_time = self.class.cpu_time - start_cpu_time
+        n_allocated_objects = self.class.n_allocated_objects
+        if n_allocated_objects
+          operation.n_allocated_objects =
+            n_allocated_objects - start_n_allocated_objects
+        end
+        @stack.pop
+        if parent
+          parent.children << operation
+        else
+          @operations << operation
+          @callback.call(operation) if @callback
+        end
+      end
+    end
+
+    # Records a column read.
+    #
+    # @param name [String] The name of the read column.
+    # @yield [] Reads the column value.
+    # @return [Object] The value returned by the block.
+    def measure_column_read(name)
+      # Table#column_value reads a value by Column#[]. Only the
+      # outer read is recorded. Otherwise a read is counted twice.
+      return yield if @measuring_column_read
+
+      @measuring_column_read = true
+      start_time = self.class.now
+      begin
+        yield
+      ensure
+        @measuring_column_read = false
+        elapsed_time = self.class.now - start_time
+        read = (@column_reads[name] ||= {"n_reads" => 0, "elapsed_time" => 0.0})
+        read["n_reads"] += 1
+        read["elapsed_time"] += elapsed_time
+      end
+    end
+
+    def to_hash
+      {
+        "operations" => @operations.collect(&:to_hash),
+        "column_reads" => @column_reads,
+      }
+    end
+
+    def to_json(*args)
+      to_hash.to_json(*args)
+    end
+
+    private
+    def target_name(target)
+      return nil if target.nil?
+      target.name || "(temporary)"
+    end
+
+    class << self
+      if defined?(Process::CLOCK_MONOTONIC)
+        # @private
+        def now
+          Process.clock_gettime(Process::CLOCK_MONOTONIC)
+        end
+      else
+        # @private
+        def now
+          Time.now.to_f
+        end
+      end
+
+      if defined?(Process::CLOCK_PROCESS_CPUTIME_ID)
+        # @private
+        def cpu_time
+          Process.clock_gettime(Process::CLOCK_PROCESS_CPUTIME_ID)
+        end
+      else
+        # @private
+        def cpu_time
+          times = Process.times
+          times.utime + times.stime
+        end
+      end
+
+      # @private
+      def n_allocated_objects
+        stat = GC.stat
+        stat[:total_allocated_objects] || stat[:total_allocated_object]
+      end
+
+      # @private
+      #
+      # Instruments operations. It is called when a context starts
+      # profiling. Instrumentation is removed by {.uninstall} when
+      # no context is profiled. So operations don't have any
+      # overhead such as an argument Array for each call while
+      # profiling isn't used.
+      def install
+        installation_mutex.synchronize do
+          @n_installations ||= 0
+          @n_installations += 1
+          install_instruments if @n_installations == 1
+        end
+      end
+
+      # @private
+      #
+      # Restores the original methods replaced by {.install} when
+      # the last profiling context stops profiling.
+      def uninstall
+        installation_mutex.synchronize do
+          return if (@n_installations || 0).zero?
+          @n_installations -= 1
+          uninstall_instruments if @n_installations.zero?
+        end
+      end
+
+      # @private
+      def installed?
+        not (@n_installations || 0).zero?
+      end
+
+      private
+      def installation_mutex
+        @installation_mutex ||= Mutex.new
+      end
+
+      def install_instruments
+        @instrumented_methods = []
+
+        [:select, :sort, :group,
+         :union!, :intersection!, :difference!, :merge!].each do |method_name|
+          instrument_table_operation(Table, method_name)
+        end
+
+        [Table, Table::KeySupport].each do |klass|
+          instrument(klass, :column_value) do |profiler, table, args, &invoke|
+            column_name = "#{table.name || '(temporary)'}.#{args[1]}"
+            profiler.measure_column_read(column_name, &invoke)
+          end
+        end
+
+        [FixSizeColumn, VariableSizeColumn].each do |klass|
+          instrument(klass, :[]) do |profiler, column, args, &invoke|
+            profiler.measure_column_read(column.name || "(temporary)", &invoke)
+          end
+        end
+
+        instrument(RecordExpressionBuilder, :build, :table) do |profiler, builder, args, &invoke|
+          profiler.measure("build_expression", builder.table, &invoke)
+        end
+      end
+
+      def uninstall_instruments
+        @instrumented_methods.reverse_each do |klass, method_name|
+          original_method_name = "#{method_name}_without_profiler"
+          klass.__send__(:alias_method, method_name, original_method_name)
+          klass.__send__(:remove_method, original_method_name)
+        end
+        @instrumented_methods = nil
+      end
+
+      # Replaces _method_name_ of _klass_ with a method that calls
+      # _measure_ when the context of the receiver has a
+      # profiler. Otherwise the original method is just called.
+      # The context is got from the object returned by
+      # _owner_method_name_ if it is given.
+      def instrument(klass, method_name, owner_method_name=nil, &measure)
+        original_method_name = "#{method_name}_without_profiler"
+        @instrumented_methods << [klass, method_name]
+        klass.__send__(:alias_method, original_method_name, method_name)
+        klass.__send__(:define_method, method_name) do |*args, &block|
+          owner = owner_method_name ? __send__(owner_method_name) : self
+          profiler = owner.context.profiler
+          if profiler.nil?
+            __send__(original_method_name, *args, &block)
+          else
+            measure.call(profiler, self, args) do
+              __send__(original_method_name, *args, &block)
+            end
+          end
+        end
+      end
+
+      def instrument_table_operation(klass, method_name)
+        instrument(klass, method_name) do |profiler, table, args, &invoke|
+          profiler.measure(method_name.to_s, table, table.size) do |operation|
+            result = invoke.call
+            operation.n_output_records = count_records(result)
+            result
+          end
+        end
+      end
+
+      def count_records(result)
+        case result
+        when Table
+          result.size
+        when ::Array
+          result.inject(0) do |n_records, sub_result|
+            return nil unless sub_result.is_a?(Table)
+            n_records + sub_result.size
+          end
+        else
+          nil
+        end
+      end
+    end
+  end
+end
@@ -126,4 +126,55 @@ module Groonga
       end
     end
   end
+
+  class NativeQueryLogger
+    # @return [Float] The max seconds that an event is kept in the
+    #   ring buffer.
+    attr_reader :flush_interval
+
+    # @return [SystemCallError, nil] The last error raised while
+    #   buffered events are written by the thread started by
+    #   {#start}. For example, it is set when the log file can't be
+    #   reopened. The thread keeps running after an error.
+    #
+    # @since 4.0.5
+    attr_reader :last_error
+
+    # Starts a thread that writes buffered events. It is called by
+    # {Groonga::QueryLogger.register}.
+    #
+    # @return [void]
+    #
+    # @since 4.0.5
+    def start
+      return if @drain_thread
+      @stop_requested = false
+      @drain_thread = Thread.new do
+        until @stop_requested or closed?
+          begin
+            drain(@flush_interval)
+          rescue SystemCallError
+            @last_error = $!
+          end
+        end
+      end
+    end
+
+    # Stops the thread started by {#start} and closes the logger. It
+    # is called by {Groonga::QueryLogger.unregister}. The thread
+    # finishes after the current {#drain} that waits at most
+    # {#flush_interval} seconds.
+    #
+    # @return [void]
+    #
+    # @since 4.0.5
+    def stop
+      if @drain_thread
+        @stop_requested = true
+        @drain_thread.join
+        @drain_thread = nil
+      end
+      close
+    end
+  end
 end
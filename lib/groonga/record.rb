@@ -23,6 +23,61 @@ require "groonga/sub-records"
 
 module Groonga
   class Record
+    # @private
+    # Options for ID based table methods. It is shared to not
+    # allocate a Hash for each column value access.
+    ID_OPTIONS = {:id => true}.freeze
+
+    # @private
+    # Options of {#as_json} passed to
+    # {Groonga::Table#serialize_records}.
+    SERIALIZE_OPTION_NAMES = [:columns, :max_depth].freeze
+
+    class << self
+      # @private
+      #
+      # Creates the record class for _table_. Use
+      # {Groonga::Table#record_class} to get the cached class.
+      #
+      # The class has reader and writer methods for columns of
+      # _table_ and its domain tables. They are the same as
+      # {#method_missing} but they don't parse the method name for
+      # each call. Columns whose names are the same as existing
+      # methods such as +key+ aren't defined.
+      #
+      # An anonymous table such as a search result uses the class
+      # of the named table that is found by following domains.
+      # {Groonga::Record} is used if there is no named table.
+      def class_for(table)
+        base_table = table
+        while base_table.is_a?(Table) and base_table.name.nil?
+          base_table = base_table.domain
+        end
+        return self unless base_table.is_a?(Table)
+        return base_table.record_class unless base_table.equal?(table)
+
+        record_class = Class.new(self)
+        column_names(table).each do |name|
+          next if method_defined?(name) or private_method_defined?(name)
+          next if method_defined?("#{name}=")
+          record_class.define_column_accessor(name)
+        end
+        record_class
+      end
+
+      private
+      def column_names(table)
+        names = []
+        while table.is_a?(Table)
+          table.columns.each do |column|
+            names << column.local_name
+          end
+          table = table.domain
+        end
+        names.uniq
+      end
+    end
+
     # レコードが所属するテーブル
     attr_reader :table
     # _table_ の _id_ に対応するレコードを作成する。 _values_ には各
@@ -54,7 +109,7 @@ module Groonga
     # 同じレコードIDを持つなら +true+ を返し、そうでなければ
     # +false+ を返す。
     def ==(other)
-      self.class == other.class and
+      other.is_a?(Record) and
         [table, id] == [other.table, other.id]
     end
 
@@ -71,7 +126,7 @@ module Groonga
 
     # このレコードの _column_name_ で指定されたカラムの値を返す。
     def [](column_name)
-      @table.column_value(@id, column_name, :id => true)
+      @table.column_value(@id, column_name, ID_OPTIONS)
     end
 
     # Sets column value of the record.
@@ -97,7 +152,7 @@ module Groonga
     #
     # @see Groonga::Table#set_column_value
     def []=(column_name, value)
-      @table.set_column_value(@id, column_name, value, :id => true)
+      @table.set_column_value(@id, column_name, value, ID_OPTIONS)
     end
 
     # このレコードの _column_name_ で指定されたカラムの値の最後に
@@ -228,12 +283,12 @@ module Groonga
 
     # レコードの値を返す。
     def value
-      @table.value(@id, :id => true)
+      @table.value(@id, ID_OPTIONS)
     end
 
     # レコードの値を設定する。既存の値は上書きされる。
     def value=(value)
-      @table.set_value(@id, value, :id => true)
+      @table.set_value(@id, value, ID_OPTIONS)
     end
 
     # このレコードの _name_ で指定されたカラムの値を _delta_ だけ増
@@ -258,25 +313,35 @@ module Groonga
     # たこのレコードのカラムの値のハッシュを返す。
     #
     # return same attributes object if duplicate records exist.
-    def attributes
-      accessor = AttributeHashBuilder.new(self)
-      accessor.build
-    end
-
-    def as_json
-      accessor = AttributeHashBuilder.new(self) do |value|
-        if value.is_a?(Time)
-          value.iso8601
-        else
-          value
+    #
+    # @param options [::Hash] The options. +:columns+ and
+    #   +:max_depth+ are available. See
+    #   {Groonga::Table#serialize_records} for details.
+    def attributes(options={})
+      @table.serialize_records(@id, options)
+    end
+
+    # @param options [::Hash] The options. See {#attributes}. Other
+    #   options such as +:only+ passed by Rails are ignored.
+    # @return [::Hash] The same as {#attributes} but +Time+ values
+    #   are formatted by +Time#iso8601+.
+    def as_json(options=nil)
+      serialize_options = {:format => :as_json}
+      if options.is_a?(::Hash)
+        SERIALIZE_OPTION_NAMES.each do |name|
+          serialize_options[name] = options[name] if options.has_key?(name)
         end
       end
-      accessor.build
+      @table.serialize_records(@id, serialize_options)
     end
 
     # @return [String] the record formatted as JSON.
     def to_json(*args)
-      as_json.to_json(*args)
+      if args.empty?
+        @table.serialize_records(@id, :format => :json)
+      else
+        as_json.to_json(*args)
+      end
     end
 
     # Delete the record.
@@ -369,10 +434,15 @@ module Groonga
 
     # @private
     def inspect
+      inspected = super
+      if self.class.name.nil?
+        inspected = inspected.sub(/\A#<#{Regexp.escape(self.class.inspect)}/,
+                                  "#<#{Record.name}")
+      end
       if @table.closed?
-        super.gsub(/>\z/, " (closed)>")
+        inspected.gsub(/>\z/, " (closed)>")
       else
-        super.gsub(/>\z/, ", attributes: #{attributes.inspect}>")
+        inspected.gsub(/>\z/, ", attributes: #{attributes.inspect}>")
       end
     end
 
@@ -435,104 +505,6 @@ module Groonga
         super
       end
     end
-
-    # @private
-    class AttributeHashBuilder
-      attr_reader :attributes
-
-      def initialize(root_record, &value_translator)
-        @root_record = root_record
-        @all_built_attributes = {}
-        @value_translator = value_translator
-      end
-
-      def build
-        build_attributes(@root_record)
-      end
-
-      private
-      def build_attributes(record)
-        if @all_built_attributes.has_key?(record)
-          return @all_built_attributes[record]
-        end
-
-        attributes = {}
-        @all_built_attributes[record] = attributes
-
-        add_id(attributes, record)
-        add_key(attributes, record)
-        add_value(attributes, record)
-        add_score(attributes, record)
-        add_n_sub_records(attributes, record)
-        add_columns(attributes, record)
-
-        attributes
-      end
-
-      def build_value(value)
-        if value.is_a?(Record)
-          build_attributes(value)
-        else
-          value = @value_translator.call(value) if @value_translator
-          value
-        end
-      end
-
-      def build_vector(vector)
-        vector.collect do |element|
-          build_value(element)
-        end
-      end
-
-      def add_id(attributes, record)
-        attributes["_id"] = record.id
-      end
-
-      def add_table(attributes, record)
-        attributes["_table"] = record.table.name
-      end
-
-      def add_columns(attributes, record)
-        record.columns.each do |column|
-          next if column.is_a?(IndexColumn)
-
-          value = column[record.id]
-          attributes[column.local_name] = build_column(column, value)
-        end
-      end
-
-      def build_column(column, value)
-        if column.vector?
-          build_vector(value)
-        else
-          build_value(value)
-        end
-      end
-
-      def add_key(attributes, record)
-        if record.support_key?
-          attributes["_key"] = build_value(record.key)
-        end
-      end
-
-      def add_value(attributes, record)
-        if record.support_value?
-          attributes["_value"] = build_value(record.value)
-        end
-      end
-
-      def add_score(attributes, record)
-        if record.support_score?
-          attributes["_score"] = record.score
-        end
-      end
-
-      def add_n_sub_records(attributes, record)
-        if record.support_sub_records?
-          attributes["_nsubrecs"] = record.n_sub_records
-        end
-      end
-    end
   end
 end
 
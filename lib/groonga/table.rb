@@ -17,9 +17,148 @@
 
 module Groonga
   class Table
+    # @private
+    #
+    # It is extended to a result of {#select} that is fetched from
+    # the select cache. The query isn't parsed until the expression
+    # is used.
+    module CachedSelectResult
+      def expression
+        @expression ||= @expression_builder.build
+      end
+    end
+
     def disk_usage
       measurer = StatisticMeasurer.new
       measurer.measure_disk_usage(path)
     end
+
+    # Creates snippets of _column_ values of all records in the
+    # table in a batch. It is useful to highlight keywords in a
+    # page of search result.
+    #
+    # @example Highlight keywords in a page
+    #   expression = Groonga::Expression.new
+    #   expression.define_variable(:domain => entries)
+    #   expression.parse("groonga", :default_column => "content")
+    #   page = entries.select(expression).sort(["_score"], :limit => 10)
+    #   page.snippets("content", expression, :tags => ["<em>", "</em>"])
+    #     # => [["<em>groonga</em> is ..."], ...]
+    #
+    # @param column [String, Groonga::Column, Groonga::Accessor] The
+    #   column name or the text column. The column name is resolved
+    #   in the table. So you can use a column name of the original
+    #   table for a search result.
+    # @param expression_or_snippet [Groonga::Expression, Groonga::Snippet]
+    #   The expression that has keywords or the snippet.
+    # @param [::Hash] options The name and value
+    #   pairs. Omitted names are initialized as the default value.
+    #   Other options are passed to {Groonga::Expression#snippet}.
+    # @option options [::Array] :tags ([["<span class=\"keyword\">", "</span>"]])
+    #   The tags passed to {Groonga::Expression#snippet}. It is
+    #   ignored for a snippet.
+    # @option options :release_gvl (nil) It is passed to
+    #   {Groonga::Snippet#execute_batch}.
+    # @return [::Array<::Array<String>>] Snippets of each record in
+    #   ID order.
+    #
+    # @since 4.0.5
+    def snippets(column, expression_or_snippet, options={})
+      options = options.dup
+      tags = options.delete(:tags) || [["<span class=\"keyword\">", "</span>"]]
+      batch_options = {:release_gvl => options.delete(:release_gvl)}
+      unless column.is_a?(Object)
+        column_name = column.to_s
+        column = self.column(column_name)
+        if column.nil?
+          raise InvalidArgument, "unknown column: <#{column_name}>: <#{name}>"
+        end
+      end
+
+      if expression_or_snippet.is_a?(Snippet)
+        return expression_or_snippet.execute_batch(column, self, batch_options)
+      end
+
+      snippet = expression_or_snippet.snippet(tags, options)
+      begin
+        snippet.execute_batch(column, self, batch_options)
+      ensure
+        snippet.close
+      end
+    end
+
+    # Prepares a condition that is executed many times with
+    # different values. Values are bound to variables named by
+    # +:variables+.
+    #
+    # A prepared expression for a query string is cached in the
+    # context and reused by the same query and options. See
+    # {Groonga::Context#prepared_expression_cache_size=}. A
+    # prepared expression for a block isn't cached. Keep it by
+    # yourself.
+    #
+    # @example Prepare by a block
+    #   adults = users.prepare(:variables => [:min_age]) do |record, variables|
+    #     record.age >= variables[:min_age]
+    #   end
+    #   adults.select(:min_age => 20)
+    #
+    # @example Prepare by a query string
+    #   users.prepare("age >= min_age", :variables => [:min_age])
+    #     .select(:min_age => 20)
+    #
+    # @overload prepare(query, options={})
+    #   @param query [String] The query. Variables are referred by
+    #     their names.
+    #   @!macro [new] table.prepare.options
+    #     @param options [::Hash] The name and value
+    #       pairs. Omitted names are initialized as the default value.
+    #     @option options [::Array<Symbol>] :variables ([])
+    #       The variable names.
+    #     @option options [Symbol] :syntax (:script)
+    #       The syntax of _query_.
+    #     @option options [String] :default_column
+    #       The default column for _query_.
+    #     @option options :allow_pragma
+    #     @option options :allow_column
+    #     @option options :allow_leading_not
+    #       They are the same as {Groonga::Table#select}.
+    #
+    # @overload prepare(options={})
+    #   @yield [record, variables] Builds the condition.
+    #   @yieldparam record [Groonga::RecordExpressionBuilder] The record.
+    #   @yieldparam variables [::Hash{Symbol => Groonga::Variable}]
+    #     The variables that can be used as values.
+    #   @!macro table.prepare.options
+    #
+    # @return [Groonga::PreparedExpression]
+    #
+    # @since 4.0.5
+    def prepare(query_or_options=nil, options={}, &block)
+      if query_or_options.is_a?(::Hash)
+        query = nil
+        options = query_or_options
+      else
+        query = query_or_options
+      end
+      if query.nil? or block
+        return PreparedExpression.new(self, query, options, &block)
+      end
+
+      key = [
+        id || object_id,
+        query,
+        options[:variables],
+        options[:syntax],
+        options[:default_column],
+        options[:allow_pragma],
+        options[:allow_column],
+        options[:allow_leading_not],
+        options[:name],
+      ]
+      context.prepared_expressions.fetch(key) do
+        PreparedExpression.new(self, query, options)
+      end
+    end
   end
 end
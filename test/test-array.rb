@@ -235,6 +235,78 @@ EXPECTED_OUTPUT
       end
     end
 
+    def test_timeout
+      pulled_record = @queue.pull(:timeout => 0.1) do |record|
+        flunk("must not be called: #{record.inspect}")
+      end
+      assert_nil(pulled_record)
+    end
+
+    def test_pull_in_thread
+      thread = Thread.new do
+        @queue.pull(:timeout => 5) do |record|
+          record.content
+        end
+      end
+      sleep(0.1)
+      @queue.push do |record|
+        record.content = "The first record"
+      end
+      assert_equal("The first record", thread.value.content)
+    end
+
+    def test_pull_interrupted_in_thread
+      interrupted = Class.new(StandardError)
+      thread = Thread.new do
+        @queue.pull do |record|
+          flunk("must not be called: #{record.inspect}")
+        end
+      end
+      sleep(0.1)
+      thread.raise(interrupted)
+      assert_raise(interrupted) do
+        assert_not_nil(thread.join(5), "blocked pull isn't interrupted")
+      end
+    end
+
+    def test_unblock_in_thread
+      thread = Thread.new do
+        @queue.pull do |record|
+          flunk("must not be called: #{record.inspect}")
+        end
+      end
+      sleep(0.1)
+      @queue.unblock
+      assert_not_nil(thread.join(5), "blocked pull isn't unblocked")
+      assert_nil(thread.value)
+    end
+
+    def test_pull_batch
+      3.times do |i|
+        @queue.push do |record|
+          record.content = "record #{i}"
+        end
+      end
+      contents = []
+      records = @queue.pull_batch(2) do |record|
+        contents << record.content
+      end
+      assert_equal([
+                     [1, 2],
+                     ["record 0", "record 1"],
+                     [3],
+                   ],
+                   [
+                     records.collect(&:id),
+                     contents,
+                     @queue.pull_batch(10).collect(&:id),
+                   ])
+    end
+
+    def test_pull_batch_not_block?
+      assert_equal([], @queue.pull_batch(10, :block? => false))
+    end
+
     private
     def pull_rb_source(options)
       base_dir = File.expand_path(File.join(File.dirname(__FILE__), ".."))
@@ -130,6 +130,33 @@ class CommandSelectTest < Test::Unit::TestCase
     end
   end
 
+  class AsyncTest < self
+    def test_value
+      users = context.execute_command_async("select", :table => @users)
+      books = context.execute_command_async("select", :table => @books)
+      assert_equal([4, 2], [users.value.n_hits, books.value.n_hits])
+    end
+
+    def test_callback
+      n_hits = []
+      future = context.execute_command_async("select",
+                                             :table => @users) do |response|
+        n_hits << response.n_hits
+      end
+      future.wait
+      assert_equal([true, [4]], [future.resolved?, n_hits])
+    end
+
+    def test_invalid
+      future = context.execute_command_async("select",
+                                             :table => @books,
+                                             :query => "<")
+      assert_raise(Groonga::SyntaxError) do
+        future.value
+      end
+    end
+  end
+
   class QueryFlagsTest < self
     def setup_tables
       Groonga::Schema.define do |schema|
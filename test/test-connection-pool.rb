@@ -0,0 +1,156 @@
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+require "socket"
+
+class ConnectionPoolTest < Test::Unit::TestCase
+  include GroongaTestUtils
+
+  setup :before => :append
+  def setup_remote_connection
+    @process_id = nil
+
+    package_config = PKGConfig.package_config("groonga")
+    groonga = package_config.variable("groonga")
+
+    @host = "127.0.0.1"
+    @port = 12346
+    @remote_database_path = @tmp_dir + "remote-database"
+    @process_id = Process.fork do
+      exec(groonga,
+           "-i", @host,
+           "-p", @port.to_s,
+           "-s", "-n", @remote_database_path.to_s)
+    end
+    sleep(1)
+  end
+
+  setup
+  def setup_pool
+    @pool = nil
+  end
+
+  teardown
+  def teardown_pool
+    @pool.close if @pool
+  end
+
+  teardown
+  def teardown_remote_connection
+    Process.kill(:TERM, @process_id) if @process_id
+  end
+
+  def test_with_connection
+    @pool = create_pool
+    _, result = @pool.with_connection do |context|
+      context.send("status")
+      context.receive
+    end
+    assert_equal("alloc_count", JSON.load(result).keys.sort.first)
+  end
+
+  def test_reuse
+    @pool = create_pool
+    context = @pool.checkout
+    @pool.checkin(context)
+    assert_equal([context, 1, 0],
+                 [@pool.checkout, @pool.n_connections, @pool.n_idle_connections])
+  end
+
+  def test_timeout
+    @pool = create_pool(:size => 1, :timeout => 0.1)
+    @pool.checkout
+    assert_raise(Groonga::ConnectionPool::TimeoutError) do
+      @pool.checkout
+    end
+  end
+
+  def test_health_check
+    @pool = create_pool(:health_check_interval => 0)
+    context = @pool.checkout
+    @pool.checkin(context)
+    assert_equal(context, @pool.checkout)
+  end
+
+  def test_health_check_timeout
+    server = TCPServer.new(@host, 0)
+    accepted_sockets = []
+    accept_thread = Thread.new do
+      loop do
+        accepted_sockets << server.accept
+      end
+    end
+    begin
+      @pool = create_pool(:port => server.addr[1],
+                          :health_check_interval => 0,
+                          :health_check_timeout => 0.1)
+      context = @pool.checkout
+      @pool.checkin(context)
+      new_context = @pool.checkout
+      assert_equal([false, true, 1],
+                   [context.equal?(new_context),
+                    context.closed?,
+                    @pool.n_connections])
+    ensure
+      accept_thread.kill
+      accept_thread.join
+      accepted_sockets.each(&:close)
+      server.close
+    end
+  end
+
+  def test_health_check_unexpected_error
+    @pool = create_pool(:health_check_interval => 0)
+    context = @pool.checkout
+    @pool.checkin(context)
+    unexpected_error = Class.new(StandardError)
+    context.singleton_class.send(:define_method, :receive) do
+      raise unexpected_error
+    end
+    assert_raise(unexpected_error) do
+      @pool.checkout
+    end
+    assert_equal([true, 0, 0],
+                 [context.closed?,
+                  @pool.n_connections,
+                  @pool.n_idle_connections])
+  end
+
+  def test_reap
+    @pool = create_pool(:idle_timeout => 0)
+    context = @pool.checkout
+    @pool.checkin(context)
+    assert_equal([true, 0, 0],
+                 [context.closed?,
+                  @pool.n_connections,
+                  @pool.n_idle_connections])
+  end
+
+  def test_close
+    @pool = create_pool
+    context = @pool.checkout
+    @pool.close
+    @pool.checkin(context)
+    assert_equal([true, 0], [context.closed?, @pool.n_connections])
+    assert_raise(Groonga::ConnectionPool::ClosedError) do
+      @pool.checkout
+    end
+  end
+
+  private
+  def create_pool(options={})
+    Groonga::ConnectionPool.new({:host => @host, :port => @port}.merge(options))
+  end
+end
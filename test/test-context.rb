@@ -124,6 +124,18 @@ class ContextTest < Test::Unit::TestCase
     assert_equal(-1, context.match_escalation_threshold)
   end
 
+  def test_release_gvl
+    context = Groonga::Context.new
+    assert_false(context.release_gvl?)
+    context.release_gvl = true
+    assert_true(context.release_gvl?)
+  end
+
+  def test_release_gvl_option
+    context = Groonga::Context.new(:release_gvl => true)
+    assert_true(context.release_gvl?)
+  end
+
   def test_close
     context = Groonga::Context.new
     assert_false(context.closed?)
@@ -201,11 +213,42 @@ COMMANDS
                    responses)
     end
 
+    def test_window
+      table_create = "table_create Items TABLE_HASH_KEY ShortText"
+      column_create = "column_create Items title COLUMN_SCALAR Text"
+      commands = <<-COMMANDS
+#{table_create}
+#{column_create}
+COMMANDS
+      responses = []
+      restore(commands, :window => 4) do |command, response|
+        responses << [command.dup, response]
+      end
+      assert_equal([
+                     [table_create, "true"],
+                     [column_create, "true"],
+                   ],
+                   responses)
+    end
+
+    def test_progress
+      commands = <<-COMMANDS
+table_create Items TABLE_HASH_KEY ShortText
+column_create Items title COLUMN_SCALAR Text
+COMMANDS
+      n_received_responses = []
+      progress = lambda do |restore_progress|
+        n_received_responses << restore_progress.n_received_responses
+      end
+      restore(commands, :progress => progress)
+      assert_equal([1, 2], n_received_responses)
+    end
+
     private
-    def restore(commands, &block)
+    def restore(commands, options={}, &block)
       restore_context = Groonga::Context.new
       restore_context.create_database(@database_path.to_s) do
-        restore_context.restore(commands, &block)
+        restore_context.restore(commands, options, &block)
       end
     end
 
@@ -216,4 +259,90 @@ COMMANDS
       end
     end
   end
+
+  class ProfileTest < self
+    setup :setup_database
+
+    setup
+    def setup_entries
+      @entries = Groonga::Array.create(:name => "Entries")
+      @entries.define_column("content", "Text")
+      @entries.add(:content => "groonga")
+      @entries.add(:content => "rroonga")
+      @entries.add(:content => "Ruby")
+    end
+
+    def test_operations
+      context = Groonga::Context.default
+      profiler = context.profile do
+        records = @entries.select do |record|
+          record.content =~ "roonga"
+        end
+        records.sort(["_id"])
+        @entries.each do |record|
+          record.content
+        end
+      end
+      operations = profiler.operations.collect do |operation|
+        [
+          operation.name,
+          operation.n_input_records,
+          operation.n_output_records,
+          operation.children.collect(&:name),
+        ]
+      end
+      assert_equal([
+                     [
+                       ["select", 3, 2, ["build_expression"]],
+                       ["sort", 2, 2, []],
+                     ],
+                     {"n_reads" => 3},
+                     nil,
+                   ],
+                   [
+                     operations,
+                     {"n_reads" => profiler.column_reads["Entries.content"]["n_reads"]},
+                     context.profiler,
+                   ])
+    end
+
+    def test_column_reads_by_column_value
+      context = Groonga::Context.default
+      profiler = context.profile do
+        @entries.column_value(1, "content")
+        @entries.column("content")[2]
+      end
+      assert_equal(2, profiler.column_reads["Entries.content"]["n_reads"])
+    end
+
+    def test_callback
+      names = []
+      context = Groonga::Context.default
+      context.start_profile do |operation|
+        names << operation.name
+      end
+      begin
+        @entries.select {|record| record.content =~ "groonga"}
+      ensure
+        profiler = context.stop_profile
+      end
+      assert_equal([["select"], "select"],
+                   [names, JSON.parse(profiler.to_json)["operations"][0]["name"]])
+    end
+
+    def test_uninstall
+      context = Groonga::Context.default
+      installed_in_profile = nil
+      context.profile do
+        installed_in_profile =
+          Groonga::Table.method_defined?(:select_without_profiler)
+      end
+      assert_equal([true, false, false],
+                   [
+                     installed_in_profile,
+                     Groonga::Table.method_defined?(:select_without_profiler),
+                     Groonga::Profiler.installed?,
+                   ])
+    end
+  end
 end
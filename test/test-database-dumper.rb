@@ -183,6 +183,40 @@ load --table Users
       DUMP
     end
 
+    def test_n_jobs
+      assert_equal(<<-DUMP, dump(:n_jobs => 2))
+#{dumped_schema_tables}
+
+#{dumped_schema_reference_columns}
+
+#{dumped_tables}
+
+#{dumped_schema_index_columns}
+      DUMP
+    end
+
+    def test_n_jobs_failed
+      output_class = Class.new(StringIO) do
+        def write(content)
+          raise IOError, "broken output" if content.start_with?("load")
+          super
+        end
+      end
+      tmp_dir = Dir.tmpdir
+      temporary_paths = Dir.glob(File.join(tmp_dir, "rroonga-dump*")).sort
+      assert_raise(IOError) do
+        dump(:n_jobs => 2, :output => output_class.new)
+      end
+      assert_equal([
+                     [],
+                     temporary_paths,
+                   ],
+                   [
+                     Process.waitall,
+                     Dir.glob(File.join(tmp_dir, "rroonga-dump*")).sort,
+                   ])
+    end
+
     def test_limit_tables
       assert_equal(<<-DUMP, dump(:tables => ["Posts"]))
 #{dumped_schema_tables}
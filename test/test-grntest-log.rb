@@ -0,0 +1,218 @@
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+require "tempfile"
+require "stringio"
+
+require "groonga/grntest-log"
+
+class GrntestLogTest < Test::Unit::TestCase
+  class LatencyHistogramTest < self
+    def setup
+      @histogram = Groonga::GrntestLog::LatencyHistogram.new
+    end
+
+    def test_empty
+      assert_equal([0, nil, nil, nil, nil],
+                   [
+                     @histogram.n_samples,
+                     @histogram.min,
+                     @histogram.max,
+                     @histogram.mean,
+                     @histogram.percentile(50),
+                   ])
+    end
+
+    def test_percentile
+      1.upto(100) do |latency|
+        @histogram.add(latency * 1000)
+      end
+      assert_equal([1000, 100000, 50500.0],
+                   [@histogram.min, @histogram.max, @histogram.mean])
+      assert_in_delta(50000, @histogram.percentile(50), 50000 * 0.025)
+      assert_in_delta(90000, @histogram.percentile(90), 90000 * 0.025)
+      assert_in_delta(99000, @histogram.percentile(99), 99000 * 0.025)
+      assert_equal(100000, @histogram.percentile(100))
+    end
+
+    def test_percentile_in_range
+      @histogram.add(1000)
+      assert_equal([1000, 1000],
+                   [@histogram.percentile(1), @histogram.percentile(100)])
+    end
+
+    def test_merge
+      other = Groonga::GrntestLog::LatencyHistogram.new
+      1.upto(50) do |latency|
+        @histogram.add(latency * 1000)
+      end
+      51.upto(100) do |latency|
+        other.add(latency * 1000)
+      end
+      expected = Groonga::GrntestLog::LatencyHistogram.new
+      1.upto(100) do |latency|
+        expected.add(latency * 1000)
+      end
+      @histogram.merge!(other)
+      assert_equal([
+                     expected.n_samples,
+                     expected.total,
+                     expected.min,
+                     expected.max,
+                     expected.buckets,
+                   ],
+                   [
+                     @histogram.n_samples,
+                     @histogram.total,
+                     @histogram.min,
+                     @histogram.max,
+                     @histogram.buckets,
+                   ])
+    end
+
+    def test_merge_empty
+      @histogram.add(1000)
+      @histogram.merge!(Groonga::GrntestLog::LatencyHistogram.new)
+      assert_equal([1, 1000, 1000],
+                   [@histogram.n_samples, @histogram.min, @histogram.max])
+    end
+  end
+
+  class ParallelAnalyzerTest < self
+    def setup
+      @log = Tempfile.new("grntest-log")
+    end
+
+    def teardown
+      @log.close!
+    end
+
+    def test_chunks
+      write_log(task_line(0, "select", 0, 1000),
+                task_line(1, "load", 1000, 3000),
+                task_line(2, "select", 3000, 6000))
+      assert_equal([expected_statistics, expected_statistics],
+                   [analyze(:n_workers => 1), analyze(:n_workers => 3)])
+    end
+
+    def test_line_over_chunk_boundary
+      first_line = task_line(0, "select --table Users", 0, 1000)
+      write_log(first_line,
+                task_line(1, "load", 1000, 3000))
+      # The boundary is in the middle of the first line.
+      size = File.size(@log.path)
+      first_line_size = first_line.bytesize
+      assert_operator(first_line_size, :>, size / 2)
+      assert_equal({"select" => [1, 1000], "load" => [1, 2000]},
+                   analyze(:n_workers => 2))
+    end
+
+    def test_chunk_boundary_at_line_start
+      write_log(task_line(0, "select", 1000, 2000),
+                task_line(1, "select", 2000, 3000))
+      # Both lines have the same size. So the boundary of 2 chunks
+      # is at the start of the second line.
+      lines = File.readlines(@log.path)
+      assert_equal(lines[0].bytesize, lines[1].bytesize)
+      assert_equal({"select" => [2, 2000]},
+                   analyze(:n_workers => 2))
+    end
+
+    def test_many_workers
+      write_log(task_line(0, "select", 0, 1000))
+      assert_equal({"select" => [1, 1000]},
+                   analyze(:n_workers => File.size(@log.path) + 1))
+    end
+
+    def test_ignore_not_task_lines
+      write_log("[{\"script\": \"test.scr\",\n",
+                "\"detail\": [\n",
+                task_line(0, "select", 0, 1000),
+                "\"summary\": []}]\n")
+      assert_equal({"select" => [1, 1000]},
+                   analyze(:n_workers => 2))
+    end
+
+    def test_analyze_io
+      write_log(task_line(0, "/d/select?table=Users", 0, 1000),
+                task_line(1, "select --table Users", 1000, 3000))
+      analyzer = Groonga::GrntestLog::ParallelAnalyzer.new(:n_workers => 1)
+      statistics = File.open(@log.path) do |input|
+        analyzer.analyze_io(input)
+      end
+      assert_equal({"select" => [2, 3000]}, summarize(statistics))
+    end
+
+    def test_invalid_n_workers
+      assert_raise(ArgumentError) do
+        Groonga::GrntestLog::ParallelAnalyzer.new(:n_workers => 0)
+      end
+    end
+
+    private
+    def task_line(id, command, start_time, end_time)
+      "#{[id, command, start_time, end_time, true].to_json},\n"
+    end
+
+    def write_log(*lines)
+      @log.write(lines.join(""))
+      @log.flush
+    end
+
+    def expected_statistics
+      {"select" => [2, 4000], "load" => [1, 2000]}
+    end
+
+    def analyze(options)
+      analyzer = Groonga::GrntestLog::ParallelAnalyzer.new(options)
+      summarize(analyzer.analyze(@log.path))
+    end
+
+    def summarize(statistics)
+      summary = {}
+      statistics.histograms.each do |name, histogram|
+        summary[name] = [histogram.n_samples, histogram.total]
+      end
+      summary
+    end
+  end
+
+  class SummaryWriterTest < self
+    def test_write
+      statistics = Groonga::GrntestLog::Statistics.new
+      [
+        ["select", 0, 2000],
+        ["load", 0, 1000],
+        ["select", 0, 4000],
+      ].each_with_index do |(command, start_time, end_time), id|
+        event = Groonga::GrntestLog::TaskEvent.new(id, command,
+                                                   start_time, end_time,
+                                                   true)
+        statistics.add(event)
+      end
+      output = StringIO.new
+      writer = Groonga::GrntestLog::SummaryWriter.new(output)
+      writer.write(statistics)
+      # Percentiles between min and max are approximated by
+      # histogram buckets.
+      assert_equal(<<-SUMMARY, output.string)
+command\tn_queries\tmin\tmean\tp50\tp90\tp95\tp99\tmax
+load\t1\t1.000\t1.000\t1.000\t1.000\t1.000\t1.000\t1.000
+select\t2\t2.000\t3.000\t2.000\t4.000\t4.000\t4.000\t4.000
+(total)\t3\t1.000\t2.333\t1.972\t4.000\t4.000\t4.000\t4.000
+      SUMMARY
+    end
+  end
+end
@@ -90,6 +90,41 @@ class IndexCursorTest < Test::Unit::TestCase
     assert_equal("l", term.key)
   end
 
+  def test_each_packed_slice
+    slices = []
+    @terms.open_cursor do |table_cursor|
+      @content_index.open_cursor(table_cursor) do |cursor|
+        cursor.each_packed_slice(3) do |packed_postings|
+          slices << packed_postings.unpack("L*").each_slice(6).to_a
+        end
+      end
+    end
+
+    expected = expected_postings.collect do |posting|
+      [
+        posting[:record_id],
+        posting[:section_id],
+        posting[:term_id],
+        posting[:position],
+        posting[:term_frequency],
+        posting[:weight],
+      ]
+    end
+    assert_equal(expected.each_slice(3).to_a, slices)
+  end
+
+  def test_each_packed_slice_huge_size
+    slices = []
+    @terms.open_cursor do |table_cursor|
+      @content_index.open_cursor(table_cursor) do |cursor|
+        cursor.each_packed_slice(2 ** 60) do |packed_postings|
+          slices << packed_postings.unpack("L*").each_slice(6).count
+        end
+      end
+    end
+    assert_equal([expected_postings.size], slices)
+  end
+
   private
   def create_hashes(keys, values)
     hashes = []
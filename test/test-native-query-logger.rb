@@ -0,0 +1,134 @@
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+class NativeQueryLoggerTest < Test::Unit::TestCase
+  include GroongaTestUtils
+
+  setup :setup_database
+
+  setup
+  def setup_native_query_log_path
+    @native_query_log_path = @tmp_dir + "native-query.log"
+  end
+
+  def test_text
+    logger = Groonga::NativeQueryLogger.new(@native_query_log_path.to_s)
+    log_status(logger)
+    assert_equal("status",
+                 read_log.lines.first.split("|", 3).last.sub(/\A>/, "").chomp)
+  end
+
+  def test_json
+    logger = Groonga::NativeQueryLogger.new(@native_query_log_path.to_s,
+                                            :format => :json)
+    log_status(logger)
+    events = read_log.lines.collect do |line|
+      JSON.parse(line)
+    end
+    assert_equal([">", "status"],
+                 [events.first["info"].split("|", 2).last,
+                  events.first["message"]])
+  end
+
+  def test_binary
+    logger = Groonga::NativeQueryLogger.new(@native_query_log_path.to_s,
+                                            :format => :binary)
+    log_status(logger)
+    log = @native_query_log_path.binread
+    flag, timestamp_size, info_size, message_size = log.unpack("L4")
+    timestamp = log[16, timestamp_size]
+    info = log[16 + timestamp_size, info_size]
+    message = log[16 + timestamp_size + info_size, message_size]
+    assert_equal([
+                   Groonga::QueryLogger::Flags::COMMAND,
+                   true,
+                   ">",
+                   "status",
+                 ],
+                 [
+                   flag,
+                   /\A\d{4}-\d{2}-\d{2} / =~ timestamp ? true : false,
+                   info.split("|", 2).last,
+                   message,
+                 ])
+  end
+
+  def test_sample_rate
+    logger = Groonga::NativeQueryLogger.new(@native_query_log_path.to_s,
+                                            :sample_rate => 0.5)
+    Groonga::QueryLogger.register(logger, :all => true)
+    begin
+      4.times do
+        context.send("status")
+        context.receive
+      end
+    ensure
+      Groonga::QueryLogger.unregister
+    end
+    commands = read_log.lines.grep(/\|>/)
+    assert_equal(2, commands.size)
+  end
+
+  def test_slow_threshold
+    logger = Groonga::NativeQueryLogger.new(@native_query_log_path.to_s,
+                                            :slow_threshold => 60)
+    log_status(logger)
+    assert_equal("", read_log)
+  end
+
+  def test_stop
+    logger = Groonga::NativeQueryLogger.new(@native_query_log_path.to_s)
+    log_status(logger)
+    assert_equal([true, 0],
+                 [logger.closed?, logger.n_dropped_events])
+  end
+
+  def test_reopen_failure
+    log_dir = @tmp_dir + "native"
+    FileUtils.mkdir_p(log_dir.to_s)
+    log_path = log_dir + "query.log"
+    logger = Groonga::NativeQueryLogger.new(log_path.to_s,
+                                            :flush_interval => 0.01)
+    Groonga::QueryLogger.register(logger, :all => true)
+    begin
+      FileUtils.rm_rf(log_dir.to_s)
+      Groonga::QueryLogger.reopen
+      100.times do
+        break if logger.last_error
+        sleep(0.01)
+      end
+      drain_thread = logger.instance_variable_get(:@drain_thread)
+      assert_equal([Errno::ENOENT, true],
+                   [logger.last_error.class, drain_thread.alive?])
+    ensure
+      Groonga::QueryLogger.unregister
+    end
+  end
+
+  private
+  def log_status(logger)
+    Groonga::QueryLogger.register(logger, :all => true)
+    begin
+      context.send("status")
+      context.receive
+    ensure
+      Groonga::QueryLogger.unregister
+    end
+  end
+
+  def read_log
+    @native_query_log_path.read
+  end
+end
@@ -51,6 +51,26 @@ class PaginationTest < Test::Unit::TestCase
                     })
   end
 
+  def test_top_k
+    assert_paginate({
+                      :current_page => 2,
+                      :page_size => 10,
+                      :n_pages => 15,
+                      :n_records => 150,
+                      :start_offset => 11,
+                      :end_offset => 20,
+                      :have_previous_page? => true,
+                      :previous_page => 1,
+                      :have_next_page? => true,
+                      :next_page => 3,
+                      :first_page? => false,
+                      :last_page? => false,
+                      :have_pages? => true,
+                    },
+                    :page => 2,
+                    :top_k => true)
+  end
+
   def test_no_entries
     @users.each do |user|
       user.delete
@@ -223,6 +243,91 @@ class PaginationTest < Test::Unit::TestCase
                     :size => 50)
   end
 
+  class KeysetTest < self
+    def test_first_page
+      users = @users.paginate([["number", :desc]],
+                              :keyset => true,
+                              :size => 3)
+      assert_equal([["user150", "user149", "user148"], true],
+                   [record_keys(users), users.have_next_page?])
+    end
+
+    def test_all_pages
+      assert_equal((1..150).collect {|i| "user#{i}"},
+                   paginate_all([["number"]], 40))
+    end
+
+    def test_ties
+      @users.each do |user|
+        user.number = user.number % 3
+      end
+      expected_keys = @users.sort([["number"], ["_id"]]).collect do |record|
+        record.value.key
+      end
+      assert_equal(expected_keys, paginate_all([["number"]], 7))
+    end
+
+    def test_changed_sort_keys
+      users = @users.paginate([["number"]], :keyset => true)
+      assert_raise(Groonga::InvalidContinuationToken) do
+        @users.paginate([["number", :desc]], :after => users.next_token)
+      end
+    end
+
+    def test_broken_token
+      assert_raise(Groonga::InvalidContinuationToken) do
+        @users.paginate([["number"]], :after => "broken")
+      end
+    end
+
+    def test_patricia_trie_key
+      names = Groonga::PatriciaTrie.create(:name => "Names",
+                                           :key_type => "ShortText")
+      @users.each do |user|
+        names.add(user.key)
+      end
+      expected_keys = @users.collect(&:key).sort
+      assert_equal([expected_keys, expected_keys.reverse],
+                   [
+                     paginate_all([["_key"]], 40, names),
+                     paginate_all([["_key", :desc]], 40, names),
+                   ])
+    end
+
+    def test_patricia_trie_integer_key
+      numbers = Groonga::PatriciaTrie.create(:name => "Numbers",
+                                             :key_type => "Int32")
+      [-2, 300, 0, 7, -100, 65536].each do |number|
+        numbers.add(number)
+      end
+      assert_equal([
+                     [-100, -2, 0, 7, 300, 65536],
+                     [65536, 300, 7, 0, -2, -100],
+                   ],
+                   [
+                     paginate_all([["_key"]], 4, numbers),
+                     paginate_all([["_key", :desc]], 4, numbers),
+                   ])
+    end
+
+    private
+    def paginate_all(sort_keys, size, table=@users)
+      keys = []
+      options = {:keyset => true, :size => size}
+      loop do
+        users = table.paginate(sort_keys, options)
+        keys.concat(record_keys(users))
+        break unless users.have_next_page?
+        options = {:after => users.next_token, :size => size}
+      end
+      keys
+    end
+
+    def record_keys(users)
+      users.collect {|record| record.value.key}
+    end
+  end
+
   private
   def assert_paginate(expected, options={})
     users = @users.paginate([["number"]], options)
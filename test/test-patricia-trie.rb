@@ -130,6 +130,35 @@ class PatriciaTrieTest < Test::Unit::TestCase
                  words.scan('muTEki リンクの冒険 ミリバール アルパカ ガッ'))
   end
 
+  def test_scan_packed
+    Groonga::Context.default_options = {:encoding => "utf-8"}
+    words = Groonga::PatriciaTrie.create(:key_type => "ShortText",
+                                         :key_normalize => true)
+    words.add("リンク")
+    adventure_of_link = words.add('リンクの冒険')
+    words.add('冒険')
+    gaxtu = words.add('ｶﾞｯ')
+    muteki = words.add('ＭＵＴＥＫＩ')
+    packed_hits = words.scan_packed(['muTEki リンクの冒険',
+                                     '',
+                                     'ミリバール ガッ'])
+    assert_equal([
+                   [[muteki.id, 0, 6], [adventure_of_link.id, 7, 18]],
+                   [],
+                   [[gaxtu.id, 16, 6]],
+                 ],
+                 packed_hits.collect {|hits| hits.unpack("L*").each_slice(3).to_a})
+  end
+
+  def test_scan_packed_string
+    Groonga::Context.default_options = {:encoding => "utf-8"}
+    words = Groonga::PatriciaTrie.create(:key_type => "ShortText")
+    groonga = words.add("groonga")
+    assert_equal([groonga.id, 6, 7],
+                 words.scan_packed("I use groonga",
+                                   :release_gvl => true).unpack("L*"))
+  end
+
   def test_tag_keys
     Groonga::Context.default_options = {:encoding => "utf-8"}
     words = Groonga::PatriciaTrie.create(:key_type => "ShortText",
@@ -0,0 +1,91 @@
+# Copyright (C) 2014  Kouhei Sutou <kou@clear-code.com>
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License version 2.1 as published by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+class PreparedExpressionTest < Test::Unit::TestCase
+  include GroongaTestUtils
+
+  setup :setup_database
+
+  setup
+  def setup_users
+    @users = Groonga::Hash.create(:name => "Users", :key_type => "ShortText")
+    @users.define_column("age", "UInt32")
+    @users.add("alice", :age => 15)
+    @users.add("bob", :age => 20)
+    @users.add("chris", :age => 30)
+  end
+
+  def test_block
+    prepared = @users.prepare(:variables => [:min_age]) do |record, variables|
+      record.age >= variables[:min_age]
+    end
+    assert_equal([["bob", "chris"], ["chris"]],
+                 [select_keys(prepared, :min_age => 20),
+                  select_keys(prepared, :min_age => 25)])
+  end
+
+  def test_query
+    prepared = @users.prepare("age >= min_age", :variables => [:min_age])
+    assert_equal([["alice", "bob", "chris"], ["chris"]],
+                 [select_keys(prepared, :min_age => 10),
+                  select_keys(prepared, :min_age => 25)])
+  end
+
+  def test_cache
+    prepared = @users.prepare("age >= min_age", :variables => [:min_age])
+    assert_equal([true, 1],
+                 [prepared.equal?(@users.prepare("age >= min_age",
+                                                 :variables => [:min_age])),
+                  context.prepared_expressions.n_hits])
+  end
+
+  def test_cache_expired_by_schema_change
+    prepared = @users.prepare("age >= min_age", :variables => [:min_age])
+    @users.define_column("name", "ShortText")
+    assert_not_equal(prepared,
+                     @users.prepare("age >= min_age", :variables => [:min_age]))
+  end
+
+  def test_cache_size
+    context.prepared_expression_cache_size = 1
+    evicted = @users.prepare("age >= min_age", :variables => [:min_age])
+    @users.prepare("age < max_age", :variables => [:max_age])
+    assert_equal([1, ["chris"]],
+                 [context.prepared_expressions.size,
+                  select_keys(evicted, :min_age => 25)])
+  end
+
+  def test_cache_memory_pool
+    keys = 2.times.collect do
+      context.push_memory_pool do
+        prepared = @users.prepare("age >= min_age", :variables => [:min_age])
+        select_keys(prepared, :min_age => 25)
+      end
+    end
+    assert_equal([["chris"], ["chris"]], keys)
+  end
+
+  def test_unknown_variable
+    prepared = @users.prepare("age >= min_age", :variables => [:min_age])
+    assert_raise(ArgumentError) do
+      prepared.bind(:max_age => 10)
+    end
+  end
+
+  private
+  def select_keys(prepared, values)
+    prepared.select(values).collect {|record| record.key.key}.sort
+  end
+end
@@ -543,6 +543,27 @@ class RecordTest < Test::Unit::TestCase
       ]
       assert_equal(top_page_attributes, top_page_record.attributes)
     end
+
+    def test_columns
+      groonga = @bookmarks.add(top_page)
+      assert_equal({"_id" => groonga.id, "uri" => "http://groonga.org/"},
+                   groonga.attributes(:columns => ["_id", "uri"]))
+    end
+
+    def test_max_depth
+      @bookmarks.define_column("next", @bookmarks)
+
+      top_page_record = @bookmarks.add(top_page.merge("user" => "morita"))
+      doc_page_record = @bookmarks.add(doc_page)
+      top_page_record["next"] = doc_page_record
+
+      attributes = top_page_record.attributes(:max_depth => 0)
+      assert_equal([
+                     {"_id" => 1, "_key" => "morita"},
+                     {"_id" => 2},
+                   ],
+                   [attributes["user"], attributes["next"]])
+    end
   end
 
   def test_dynamic_accessor
@@ -556,6 +577,52 @@ class RecordTest < Test::Unit::TestCase
     assert_equal("http://groonga.org/", groonga.uri)
   end
 
+  def test_generated_accessor
+    groonga = @bookmarks.add
+    assert_equal([@bookmarks.record_class, true],
+                 [groonga.class,
+                  groonga.class.public_method_defined?(:uri)])
+  end
+
+  def test_generated_accessor_select_result
+    @bookmarks.add(:uri => "http://groonga.org/")
+    result = @bookmarks.select {|record| record.uri == "http://groonga.org/"}
+    assert_equal(["http://groonga.org/", @bookmarks.record_class],
+                 [result.first.uri, result.record_class])
+  end
+
+  def test_generated_accessor_new_column
+    groonga = @bookmarks.add
+    @bookmarks.define_column("title", "ShortText")
+    record = @bookmarks[groonga.id]
+    record.title = "groonga"
+    assert_equal(["groonga", true],
+                 [record.title,
+                  record.class.public_method_defined?(:title)])
+  end
+
+  def test_generated_accessor_select_result_new_column
+    @bookmarks.add(:uri => "http://groonga.org/")
+    record_class = @bookmarks.record_class
+    generation = Groonga::Table.column_cache_generation
+    result = @bookmarks.select {|record| record.uri == "http://groonga.org/"}
+    result.define_column("note", "ShortText")
+    record = result.first
+    record.note = "search engine"
+    assert_equal([
+                   record_class,
+                   generation,
+                   "search engine",
+                   "http://groonga.org/",
+                 ],
+                 [
+                   @bookmarks.record_class,
+                   Groonga::Table.column_cache_generation,
+                   record.note,
+                   record.uri,
+                 ])
+  end
+
   def test_method_chain
     morita = @users.add("morita")
     groonga = @bookmarks.add(:user => morita, :uri => "http://groonga.org")
@@ -652,5 +719,33 @@ class RecordTest < Test::Unit::TestCase
       }.to_json
       assert_equal(expected, groonga.to_json)
     end
+
+    def test_to_json_self_referencing
+      @bookmarks.define_column("next", @bookmarks)
+      groonga = @bookmarks.add("uri" => "http://groonga.org/")
+      groonga["next"] = groonga
+      expected = {
+        "_id"        => groonga.id,
+        "comment"    => nil,
+        "created_at" => Time.at(0).iso8601,
+        "next"       => {"_id" => groonga.id},
+        "rate"       => 0,
+        "uri"        => "http://groonga.org/",
+      }
+      assert_equal(expected, JSON.parse(groonga.to_json))
+    end
+
+    def test_as_json_unknown_options
+      groonga = @bookmarks.add("uri" => "http://groonga.org/", "rate" => 5)
+      assert_equal([
+                     groonga.as_json,
+                     {"_id" => groonga.id, "uri" => "http://groonga.org/"},
+                   ],
+                   [
+                     groonga.as_json(:only => ["uri"]),
+                     groonga.as_json(:columns => ["_id", "uri"],
+                                     :except => ["rate"]),
+                   ])
+    end
   end
 end
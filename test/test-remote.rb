@@ -53,6 +53,77 @@ class RemoteTest < Test::Unit::TestCase
                  values.keys.sort)
   end
 
+  def test_execute_command_async
+    _context = Groonga::Context.new
+    _context.connect(:host => @host, :port => @port)
+    futures = 2.times.collect do
+      _context.execute_command_async("status")
+    end
+    assert_equal([true, true],
+                 futures.collect {|future| future.value.body.has_key?("version")})
+  end
+
+  def test_receive_interrupted
+    interrupted = Class.new(StandardError)
+    _context = Groonga::Context.new
+    _context.connect(:host => @host, :port => @port)
+    thread = Thread.new do
+      _context.receive
+    end
+    sleep(0.1)
+    thread.raise(interrupted)
+    assert_raise(interrupted) do
+      assert_not_nil(thread.join(5), "blocked receive isn't interrupted")
+    end
+  end
+
+  def test_send_while_waiting
+    _context = Groonga::Context.new
+    _context.connect(:host => @host, :port => @port)
+    waiting_thread = Thread.new do
+      _context.execute_command_async("status").value
+    end
+    sleep(0.1)
+    future = _context.execute_command_async("status")
+    assert_equal([true, true],
+                 [
+                   waiting_thread.value.body.has_key?("version"),
+                   future.value.body.has_key?("version"),
+                 ])
+  end
+
+  def test_restore_window
+    table_create = "table_create Items TABLE_HASH_KEY ShortText"
+    column_create = "column_create Items title COLUMN_SCALAR Text"
+    table_remove = "table_remove Items"
+    commands = <<-COMMANDS
+#{table_create}
+#{column_create}
+#{table_remove}
+#{table_create}
+COMMANDS
+    _context = Groonga::Context.new
+    _context.connect(:host => @host, :port => @port)
+    responses = []
+    n_received_responses = []
+    progress = lambda do |restore_progress|
+      n_received_responses << restore_progress.n_received_responses
+    end
+    _context.restore(commands, :window => 2, :progress => progress) do |command, response|
+      responses << [command.dup, response]
+    end
+    assert_equal([
+                   [
+                     [table_create, "true"],
+                     [column_create, "true"],
+                     [table_remove, "true"],
+                     [table_create, "true"],
+                   ],
+                   [1, 2, 3, 4],
+                 ],
+                 [responses, n_received_responses])
+  end
+
   def test_invalid_select
     context.connect(:host => @host, :port => @port)
 
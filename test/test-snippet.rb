@@ -123,6 +123,72 @@ class SnippetTest < Test::Unit::TestCase
                  snippet.execute(text))
   end
 
+  class ExecuteBatchTest < self
+    setup
+    def setup_entries
+      @entries = Groonga::Array.create(:name => "Entries")
+      @entries.define_column("content", "Text")
+      @entries.add(:content => text)
+      @entries.add(:content => "")
+      @entries.add(:content => short_text)
+      @content = @entries.column("content")
+    end
+
+    def setup_snippet
+      @snippet = Groonga::Snippet.new(:width => 30,
+                                      :default_open_tag => "{",
+                                      :default_close_tag => "}")
+      @snippet.add_keyword("全文")
+    end
+
+    def test_ids
+      assert_equal([
+                     @snippet.execute(text),
+                     [],
+                     @snippet.execute(short_text),
+                   ],
+                   @snippet.execute_batch(@content, [1, 2, 3]))
+    end
+
+    def test_packed_ids
+      assert_equal([@snippet.execute(short_text), []],
+                   @snippet.execute_batch(@content, [3, 2].pack("L*")))
+    end
+
+    def test_table
+      records = @entries.select {|record| record.content =~ "エンジンです"}
+      assert_equal([@snippet.execute(short_text)],
+                   @snippet.execute_batch(records.column("content"), records))
+    end
+
+    def test_release_gvl
+      assert_equal([@snippet.execute(short_text)],
+                   @snippet.execute_batch(@content, [3], :release_gvl => true))
+    end
+
+    def test_not_text_column
+      @entries.define_column("n_likes", "UInt32")
+      assert_raise(ArgumentError) do
+        @snippet.execute_batch(@entries.column("n_likes"), [1])
+      end
+    end
+
+    def test_table_snippets
+      expression = Groonga::Expression.new
+      expression.define_variable(:domain => @entries)
+      expression.parse("エンジンです", :default_column => "content")
+      records = @entries.select(expression)
+      assert_equal([["groonga は全文検索[エンジンです]。"]],
+                   records.snippets("content", expression,
+                                    :tags => ["[", "]"]))
+    end
+
+    private
+    def short_text
+      "groonga は全文検索エンジンです。"
+    end
+  end
+
   private
   def text
     <<-EOT
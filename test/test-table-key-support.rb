@@ -137,4 +137,50 @@ class TableKeySupportTest < Test::Unit::TestCase
       end
     end
   end
+
+  class BatchTest < self
+    setup
+    def setup_tables
+      @tags = Groonga::PatriciaTrie.create(:name => "Tags",
+                                           :key_type => "ShortText")
+      @tags.add("groonga")
+      @tags.add("ruby")
+      @tags.add("mroonga")
+      @users = Groonga::Hash.create(:name => "Users",
+                                    :key_type => "UInt32")
+      @users.add(10)
+      @users.add(20)
+    end
+
+    def test_ids_for
+      assert_equal([2, nil, 1],
+                   @tags.ids_for(["ruby", "rroonga", "groonga"]))
+    end
+
+    def test_ids_for_sort
+      assert_equal([2, 3, nil, 1],
+                   @tags.ids_for(["ruby", "mroonga", "rroonga", "groonga"],
+                                 :sort => true))
+    end
+
+    def test_ids_for_packed_keys
+      assert_equal([2, 0, 1],
+                   @users.ids_for([20, 30, 10].pack("L*")).unpack("L*"))
+    end
+
+    def test_ids_for_packed_keys_for_variable_size_key
+      assert_raise(ArgumentError) do
+        @tags.ids_for("groonga")
+      end
+    end
+
+    def test_keys_for
+      assert_equal(["ruby", nil, "groonga"],
+                   @tags.keys_for([2, 100, @tags["groonga"]]))
+    end
+
+    def test_keys_for_packed_ids
+      assert_equal([20, 10], @users.keys_for([2, 1].pack("L*")))
+    end
+  end
 end
@@ -71,6 +71,77 @@ class TableSelectTest < Test::Unit::TestCase
     assert_equal_select_result([@comment1, @comment2], @result)
   end
 
+  def test_query_release_gvl
+    @result = @comments.select("content:@Hello", :release_gvl => true)
+    assert_equal_select_result([@comment1, @comment2], @result)
+  end
+
+  def test_query_release_gvl_interrupted
+    interrupted = Class.new(StandardError)
+    thread = Thread.new do
+      loop do
+        @comments.select("content:@Hello", :release_gvl => true)
+      end
+    end
+    sleep(0.1)
+    thread.raise(interrupted)
+    assert_raise(interrupted) do
+      thread.join
+    end
+    @result = @comments.select("content:@Hello", :release_gvl => true)
+    assert_equal_select_result([@comment1, @comment2], @result)
+  end
+
+  def test_query_cache
+    context.select_cache_size = 10
+    # A result isn't cached while the database is modified in the
+    # current second.
+    touch_database_in_past
+    @comments.select("content:@Hello")
+    @result = @comments.select("content:@Hello")
+    assert_equal_select_result([@comment1, @comment2], @result)
+    statistics = context.select_cache_statistics
+    assert_equal([1, 1, 1, Groonga::Expression],
+                 [
+                   statistics[:size],
+                   statistics[:n_hits],
+                   statistics[:n_misses],
+                   @result.expression.class,
+                 ])
+  end
+
+  def test_query_cache_expired
+    context.select_cache_size = 10
+    touch_database_in_past
+    @comments.select("content:@Hello")
+    comment = @comments.add(:content => "Hello Cache")
+    @result = @comments.select("content:@Hello")
+    assert_equal_select_result([@comment1, @comment2, comment], @result)
+    assert_equal(0, context.select_cache_statistics[:n_hits])
+  end
+
+  def test_query_cache_schema_changed
+    context.select_cache_size = 10
+    touch_database_in_past
+    @comments.select("content:@Hello")
+    @comments.define_column("title", "ShortText")
+    touch_database_in_past
+    @comments.select("content:@Hello")
+    assert_equal(0, context.select_cache_statistics[:n_hits])
+  end
+
+  def test_query_cache_database
+    context.select_cache_size = 10
+    touch_database_in_past
+    @comments.select("content:@Hello")
+    @database.close
+    @database = Groonga::Database.create(:path => (@tmp_dir + "other.db").to_s)
+    setup_comments
+    touch_database_in_past
+    @comments.select("content:@Hello")
+    assert_equal(0, context.select_cache_statistics[:n_hits])
+  end
+
   def test_query_with_parser
     @result = @comments.select("content @ \"Hello\"", :syntax => :script)
     assert_equal_select_result([@comment1, @comment2], @result)
@@ -188,4 +259,9 @@ class TableSelectTest < Test::Unit::TestCase
     end
     assert_equal_select_result([], @result)
   end
+
+  private
+  def touch_database_in_past
+    context.database.touch(Time.now - 2)
+  end
 end
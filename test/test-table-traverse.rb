@@ -285,6 +285,76 @@ class TableTraverseTest < Test::Unit::TestCase
                     "http://www.ruby-lang.org/"],
                    keys)
     end
+
+    def test_reuse_record
+      records = []
+      keys = []
+      @bookmarks.each(:reuse_record => true) do |record|
+        records << record
+        keys << record.key
+      end
+      assert_equal([["Cutter", "Ruby", "groonga"], 1],
+                   [keys, records.uniq {|record| record.object_id}.size])
+    end
+
+    def test_reuse_record_with_limit
+      users = create_users
+      add_users(users)
+      results = []
+      users.each(:limit => 20, :reuse_record => true) do |record|
+        results << record["name"]
+      end
+
+      assert_equal((100...120).collect {|i| "user#{i}"},
+                   results)
+    end
+  end
+
+  class EachIDTest < self
+    def test_default
+      ids = []
+      @bookmarks.each_id do |id|
+        ids << id
+      end
+      assert_equal([@cutter_bookmark.id,
+                    @ruby_bookmark.id,
+                    @groonga_bookmark.id],
+                   ids)
+    end
+
+    def test_with_limit_and_offset
+      users = create_users
+      add_users(users)
+      assert_equal((21..40).to_a,
+                   users.each_id(:limit => 20, :offset => 20).to_a)
+    end
+  end
+
+  class EachIDSliceTest < self
+    def test_default
+      users = create_users
+      add_users(users)
+      slices = []
+      users.each_id_slice(30) do |packed_ids|
+        slices << packed_ids.unpack("L*")
+      end
+      assert_equal([
+                     (1..30).to_a,
+                     (31..60).to_a,
+                     (61..90).to_a,
+                     (91..100).to_a,
+                   ],
+                   slices)
+    end
+
+    def test_with_limit
+      users = create_users
+      add_users(users)
+      slices = users.each_id_slice(30, :limit => 20).collect do |packed_ids|
+        packed_ids.unpack("L*")
+      end
+      assert_equal([(1..20).to_a], slices)
+    end
   end
 
   private
@@ -233,6 +233,39 @@ class TableTest < Test::Unit::TestCase
     assert_equal(uri_column, bookmarks.column(:uri))
   end
 
+  def test_column_cache_accessor
+    bookmarks = Groonga::Array.create(:name => "Bookmarks")
+    bookmarks.define_column("uri", "ShortText")
+    assert_equal(bookmarks.column("_id").object_id,
+                 bookmarks.column(:_id).object_id)
+  end
+
+  def test_column_cache_rename
+    bookmarks = Groonga::Array.create(:name => "Bookmarks")
+    uri_column = bookmarks.define_column("uri", "ShortText")
+    bookmarks.column("uri")
+    uri_column.rename("url")
+    assert_equal([nil, uri_column],
+                 [bookmarks.column("uri"), bookmarks.column("url")])
+  end
+
+  def test_column_cache_remove
+    bookmarks = Groonga::Array.create(:name => "Bookmarks")
+    bookmarks.define_column("uri", "ShortText")
+    bookmarks.column("uri").remove
+    assert_nil(bookmarks.column("uri"))
+  end
+
+  def test_column_cache_memory_pool
+    bookmarks = Groonga::Hash.create(:name => "Bookmarks",
+                                     :key_type => "ShortText")
+    bookmarks.add("http://groonga.org/")
+    context.push_memory_pool do
+      assert_equal("http://groonga.org/", bookmarks.column("_key")[1])
+    end
+    assert_equal("http://groonga.org/", bookmarks.column("_key")[1])
+  end
+
   def test_size
     bookmarks_path = @tables_dir + "bookmarks"
     bookmarks = Groonga::Array.create(:name => "Bookmarks",
@@ -403,6 +436,38 @@ class TableTest < Test::Unit::TestCase
                  results.collect {|record| record["id"]})
   end
 
+  def test_sort_release_gvl
+    bookmarks = create_bookmarks
+    add_shuffled_ids(bookmarks)
+
+    results = bookmarks.sort([{:key => "id", :order => :descending}],
+                             :limit => 20, :release_gvl => true)
+    assert_equal((180..199).to_a.reverse,
+                 results.collect {|record| record["id"]})
+  end
+
+  def test_sort_top_k
+    bookmarks = create_bookmarks
+    add_shuffled_ids(bookmarks)
+
+    results = bookmarks.sort([{:key => "id", :order => :descending}],
+                             :limit => 20, :offset => 20, :top_k => true)
+    assert_equal((160..179).to_a.reverse,
+                 results.collect {|record| record["id"]})
+  end
+
+  def test_sort_top_k_text
+    bookmarks = create_bookmarks
+    bookmarks.define_column("uri", "ShortText")
+    ["http://d/", "http://b/", "http://c/", "http://a/"].each do |uri|
+      bookmarks.add(:uri => uri)
+    end
+
+    results = bookmarks.sort(["uri"], :limit => 3, :top_k => true)
+    assert_equal(["http://a/", "http://b/", "http://c/"],
+                 results.collect {|record| record["uri"]})
+  end
+
   def test_sort_with_nonexistent_key
     bookmarks = create_bookmarks
     add_shuffled_ids(bookmarks)
@@ -551,6 +616,26 @@ class TableTest < Test::Unit::TestCase
                  users["morita"].attributes)
   end
 
+  def test_serialize_records
+    users = Groonga::Hash.create(:name => "Users",
+                                 :key_type => "ShortText")
+    users.define_column("age", "UInt32")
+    users.add("morita", :age => 29)
+    users.add("gunyara-kun", :age => 11)
+    result = users.select {|record| record.age > 20}
+    morita = {"_id" => 1, "_key" => "morita", "age" => 29}
+    assert_equal([
+                   [{"_id" => 1, "_key" => morita, "_score" => 1}],
+                   "[{\"_key\":\"morita\",\"age\":29}]",
+                 ],
+                 [
+                   result.serialize_records,
+                   users.serialize_records([1],
+                                           :format => :json,
+                                           :columns => ["_key", "age"]),
+                 ])
+  end
+
   def test_have_column
     users = Groonga::Hash.create(:name => "Users",
                                  :key_type => "ShortText")
@@ -715,6 +800,15 @@ class TableTest < Test::Unit::TestCase
                      groups)
       end
 
+      def test_release_gvl
+        grouped_records = @records.group("bookmark", :release_gvl => true)
+        groups = grouped_records.collect do |record|
+          [record.title, record.n_sub_records]
+        end
+        assert_equal([["groonga", 2], ["Ruby", 2]],
+                     groups)
+      end
+
       def test_less_than_limit
         sorted = @records.sort([{:key => "rank", :order => :descending}],
                                :limit => 3, :offset => 0)
@@ -812,6 +906,147 @@ class TableTest < Test::Unit::TestCase
     end
   end
 
+  class FetchColumnsTest < self
+    setup
+    def setup_schema
+      Groonga::Schema.define do |schema|
+        schema.create_table("Bookmarks",
+                            :type => :hash,
+                            :key_type => "ShortText") do |table|
+          table.text("title")
+          table.int32("n_likes")
+          table.short_text("tags", :type => :vector)
+        end
+      end
+      @bookmarks = Groonga["Bookmarks"]
+      @bookmarks.add("http://groonga.org/",
+                     :title => "groonga", :n_likes => 10,
+                     :tags => ["search", "C"])
+      @bookmarks.add("http://ruby-lang.org/",
+                     :title => "Ruby", :n_likes => 20,
+                     :tags => ["language"])
+    end
+
+    def test_array
+      assert_equal([
+                     [1, 2],
+                     ["http://groonga.org/", "http://ruby-lang.org/"],
+                     ["groonga", "Ruby"],
+                     [10, 20],
+                     [["search", "C"], ["language"]],
+                   ],
+                   @bookmarks.fetch_columns(["_id", "_key", :title,
+                                             "n_likes", "tags"]))
+    end
+
+    def test_packed
+      ids, titles, n_likes = @bookmarks.fetch_columns(["_id",
+                                                       "title",
+                                                       "n_likes"],
+                                                      :packed => true)
+      assert_equal([[1, 2], ["groonga", "Ruby"], [10, 20]],
+                   [ids.unpack("L*"), titles, n_likes.unpack("l*")])
+    end
+
+    def test_score
+      result = @bookmarks.select do |record|
+        record.title =~ "Ruby"
+      end
+      assert_equal([["http://ruby-lang.org/"], [1]],
+                   result.fetch_columns(["_key", "_score"]))
+    end
+
+    def test_limit
+      assert_equal([["Ruby"]],
+                   @bookmarks.fetch_columns(["title"],
+                                            :offset => 1,
+                                            :limit => 1))
+    end
+
+    def test_nonexistent
+      message = "no such column: <\"nonexistent\">: <#{@bookmarks.inspect}>"
+      assert_raise(Groonga::NoSuchColumn.new(message)) do
+        @bookmarks.fetch_columns(["nonexistent"])
+      end
+    end
+
+    def test_invalid_column_name
+      message = "column name should be String or Symbol: 1"
+      assert_raise(ArgumentError.new(message)) do
+        @bookmarks.fetch_columns(["title", 1])
+      end
+    end
+  end
+
+  class LoadColumnsTest < self
+    setup
+    def setup_schema
+      Groonga::Schema.define do |schema|
+        schema.create_table("Users",
+                            :type => :hash,
+                            :key_type => "ShortText") do |table|
+          table.short_text("name")
+          table.int32("age")
+        end
+      end
+      @users = Groonga["Users"]
+    end
+
+    def test_columns
+      errors = @users.load_columns(["_key", "name", "age"],
+                                   [
+                                     ["alice", "bob"],
+                                     ["Alice", "Bob"],
+                                     [29, 31],
+                                   ])
+      assert_equal([
+                     [],
+                     [["alice", "Alice", 29], ["bob", "Bob", 31]],
+                   ],
+                   [
+                     errors,
+                     @users.collect do |user|
+                       [user.key, user.name, user.age]
+                     end,
+                   ])
+    end
+
+    def test_rows
+      rows = [["alice", "Alice", 29], ["bob", "Bob", 31]]
+      errors = @users.load_columns(["_key", "name", "age"], rows.each)
+      assert_equal([
+                     [],
+                     [["alice", "Alice", 29], ["bob", "Bob", 31]],
+                   ],
+                   [
+                     errors,
+                     @users.collect do |user|
+                       [user.key, user.name, user.age]
+                     end,
+                   ])
+    end
+
+    def test_error
+      rows = [["alice", "Alice", 29], ["bob", "Bob", Object.new], ["chris"]]
+      errors = @users.load_columns(["_key", "name", "age"], rows.each)
+      assert_equal([
+                     [[1, TypeError]],
+                     ["alice", "bob", "chris"],
+                   ],
+                   [
+                     errors.collect {|index, error| [index, error.class]},
+                     @users.collect(&:key),
+                   ])
+    end
+
+    def test_without_key
+      message = "_key must be specified for table with key: <#{@users.inspect}>"
+      assert_raise(ArgumentError.new(message)) do
+        @users.load_columns(["name"], [["Alice"]])
+      end
+    end
+  end
+
   class OtherProcessTest < self
     def test_create
       by_other_process do